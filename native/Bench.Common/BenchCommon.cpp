@@ -0,0 +1,48 @@
+#include "BenchCommon.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace BenchCommon
+{
+    namespace
+    {
+        constexpr int kMinNameWidth = 10;
+    }
+
+    void PrintUsage(const char* program, std::span<const Benchmark> benchmarks)
+    {
+        int width = kMinNameWidth;
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            const int length = static_cast<int>(std::strlen(benchmark.name));
+            width = length > width ? length : width;
+        }
+
+        std::printf("Usage: %s <benchmark> [options]\n\nBenchmarks:\n", program);
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            std::printf("  %-*s %s\n", width, benchmark.name, benchmark.description);
+        }
+    }
+
+    int RunBenchmarks(const char* program, std::span<const Benchmark> benchmarks, int argc, char** argv)
+    {
+        if (argc < 2)
+        {
+            PrintUsage(program, benchmarks);
+            return 1;
+        }
+
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            if (std::strcmp(argv[1], benchmark.name) == 0)
+            {
+                return benchmark.run(argc - 2, argv + 2);
+            }
+        }
+
+        PrintUsage(program, benchmarks);
+        return 1;
+    }
+}
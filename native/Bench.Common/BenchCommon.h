@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/// Pieces every <Library>.Bench console project shares: the wall-clock stopwatch, the
+/// benchmark table entry and the "<program> <benchmark> [options]" dispatcher.
+namespace BenchCommon
+{
+    class Stopwatch
+    {
+    public:
+        Stopwatch()
+            : _start(std::chrono::steady_clock::now())
+        {
+        }
+
+        double ElapsedSeconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    /// Keeps the optimizer from discarding a computed value.
+    template <typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+        volatile const T* sink = &value;
+        (void)sink;
+    }
+
+    struct Benchmark
+    {
+        const char* name;
+        const char* description;
+        /// Receives the arguments after the benchmark name.
+        int (*run)(int argc, char** argv);
+    };
+
+    void PrintUsage(const char* program, std::span<const Benchmark> benchmarks);
+
+    /// Runs the benchmark named by argv[1]; prints usage and returns 1 when it is missing
+    /// or unknown.
+    int RunBenchmarks(const char* program, std::span<const Benchmark> benchmarks, int argc, char** argv);
+}
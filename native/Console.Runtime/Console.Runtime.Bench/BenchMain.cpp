@@ -0,0 +1,17 @@
+// Console.Runtime.Bench: benchmarks for the Console.Runtime static library.
+//
+// Usage: Console.Runtime.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "record", "Metrics hot-path cost per event, snapshots and exports under load, histogram accuracy", ConsoleRuntimeBench::RunRecordBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Console.Runtime.Bench", kBenchmarks, argc, argv);
+}
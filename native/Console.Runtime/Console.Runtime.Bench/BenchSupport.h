@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ConsoleRuntimeBench
+{
+    int RunRecordBench(int argc, char** argv);
+}
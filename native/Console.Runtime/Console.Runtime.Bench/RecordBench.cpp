@@ -0,0 +1,416 @@
+// Cost of recording into Metrics on the hot path, and of reading it back out.
+//
+// Usage: Console.Runtime.Bench record [events]
+//
+// baseline    the loop below with nothing recorded: what the other rows are measured against
+// frame       MetricsWriter::Frame per event (door and ID counters)
+// latency     MetricsWriter::Latency per event (stage histogram)
+// event       Frame + Latency, the usual per-frame pair
+// lookup      the same pair through Metrics::Writer() on every event (thread-local cache)
+// threads     4 writers recording `events` each while a reader snapshots continuously;
+//             wall ns per event over all writers, exact totals after they stop and
+//             histogram counts consistent with their buckets in every snapshot
+// unset       latency from an unset (0) or future timestamp saturates instead of overflowing
+// snapshot    Snapshot, binary dump and Prometheus text of a populated registry: time, size
+// accuracy    percentiles of a wide random distribution against exact sorted values
+// roundtrip   binary dump read back equals the snapshot; truncated dumps are rejected
+
+#include "BenchSupport.h"
+
+#include "ConsoleRuntime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ConsoleRuntime;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::uint32_t kDoors = 1024;
+    constexpr std::size_t kPatternSize = 4096;
+    constexpr std::size_t kThreads = 4;
+
+    /// A generous bound: the sandboxes this runs in add a few ns to an empty loop.
+    constexpr double kMaxNsPerEvent = 25.0;
+
+    class Rng
+    {
+    public:
+        explicit Rng(std::uint64_t seed)
+            : _state(seed)
+        {
+        }
+
+        std::uint64_t Next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return _state;
+        }
+
+    private:
+        std::uint64_t _state;
+    };
+
+    /// Pre-generated door/ID/age triples so the timed loops measure recording, not generation.
+    struct Pattern
+    {
+        std::vector<std::uint32_t> doors;
+        std::vector<std::uint32_t> ids;
+        std::vector<std::int64_t> stamps;
+
+        explicit Pattern(std::uint64_t seed)
+        {
+            Rng rng(seed);
+            for (std::size_t i = 0; i < kPatternSize; ++i)
+            {
+                doors.push_back(static_cast<std::uint32_t>(rng.Next() % kDoors));
+                ids.push_back(static_cast<std::uint32_t>(0x100 + rng.Next() % 0x400));
+                // 10 us .. ~26 ms in ticks.
+                stamps.push_back(-static_cast<std::int64_t>(100 + rng.Next() % (1u << 18)));
+            }
+        }
+    };
+
+    enum class Mode
+    {
+        Baseline,
+        Frame,
+        Latency,
+        Event,
+        Lookup
+    };
+
+    /// Records `events` events in `mode`; returns the checksum of the loop so it is not elided.
+    std::uint64_t Record(Metrics& metrics, const Pattern& pattern, Mode mode, std::size_t events)
+    {
+        MetricsWriter& writer = metrics.Writer();
+        std::uint64_t checksum = 0;
+        for (std::size_t i = 0; i < events; ++i)
+        {
+            const std::size_t at = i & (kPatternSize - 1);
+            const std::uint32_t door = pattern.doors[at];
+            const std::uint32_t id = pattern.ids[at];
+            const std::int64_t now = static_cast<std::int64_t>(i);
+            switch (mode)
+            {
+            case Mode::Baseline:
+                checksum += door + id + static_cast<std::uint64_t>(now - pattern.stamps[at]);
+                break;
+            case Mode::Frame:
+                writer.Frame(door, id);
+                break;
+            case Mode::Latency:
+                writer.Latency(LatencyStage::Consumer, now + pattern.stamps[at], now);
+                break;
+            case Mode::Event:
+                writer.Frame(door, id);
+                writer.Latency(LatencyStage::Consumer, now + pattern.stamps[at], now);
+                break;
+            case Mode::Lookup:
+                metrics.Writer().Frame(door, id);
+                metrics.Writer().Latency(LatencyStage::Consumer, now + pattern.stamps[at], now);
+                break;
+            }
+        }
+        return checksum;
+    }
+
+    volatile std::uint64_t g_sink;
+
+    double TimeMode(Mode mode, std::size_t events)
+    {
+        Metrics metrics(MetricsConfig{ kDoors });
+        const Pattern pattern(1);
+        Record(metrics, pattern, mode, kPatternSize); // warm the writer and the caches
+
+        // Best of three damps scheduler noise.
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            Stopwatch watch;
+            g_sink = Record(metrics, pattern, mode, events);
+            best = std::min(best, watch.ElapsedSeconds() * 1e9 / static_cast<double>(events));
+        }
+        return best;
+    }
+
+    bool RunSingleThread(std::size_t events)
+    {
+        const double baseline = TimeMode(Mode::Baseline, events);
+        std::printf("baseline  %8.2f ns/event\n", baseline);
+
+        bool pass = true;
+        const struct
+        {
+            const char* label;
+            Mode mode;
+        } rows[] = {
+            { "frame", Mode::Frame },
+            { "latency", Mode::Latency },
+            { "event", Mode::Event },
+            { "lookup", Mode::Lookup },
+        };
+        for (const auto& row : rows)
+        {
+            const double ns = TimeMode(row.mode, events);
+            const bool ok = ns - baseline <= kMaxNsPerEvent;
+            std::printf("%-9s %8.2f ns/event  %+.2f ns over baseline  %s\n", row.label, ns, ns - baseline, ok ? "PASS" : "FAIL");
+            pass = ok && pass;
+        }
+        return pass;
+    }
+
+    bool RunThreads(std::size_t events)
+    {
+        Metrics metrics(MetricsConfig{ kDoors });
+        const std::uint32_t queue = metrics.AddQueue("rx", 4096);
+
+        std::atomic<bool> stop{ false };
+        std::atomic<std::size_t> ready{ 0 };
+        std::vector<std::thread> writers;
+
+        // Wall time over all events, so the figure holds on machines with fewer cores than threads.
+        Stopwatch watch;
+        for (std::size_t t = 0; t < kThreads; ++t)
+        {
+            writers.emplace_back([&, t] {
+                const Pattern pattern(t + 1);
+                ready.fetch_add(1);
+                while (ready.load() < kThreads)
+                {
+                    std::this_thread::yield();
+                }
+                Record(metrics, pattern, Mode::Event, events);
+                metrics.Writer().Drop(DropReason::QueueFull, static_cast<std::uint32_t>(t), 0x100);
+                metrics.SetQueueDepth(queue, 1000 * (t + 1));
+            });
+        }
+
+        std::size_t snapshots = 0;
+        bool monotonic = true;
+        bool consistent = true;
+        std::uint64_t previous = 0;
+        std::thread reader([&] {
+            while (!stop.load())
+            {
+                const MetricsSnapshot snapshot = metrics.Snapshot();
+                const std::uint64_t frames = snapshot.TotalFrames();
+                monotonic = monotonic && frames >= previous;
+                previous = frames;
+
+                // Prometheus buckets are cumulative up to +Inf == _count; they must agree.
+                const LatencyHistogram& latency = snapshot.latency[static_cast<std::size_t>(LatencyStage::Consumer)];
+                consistent = consistent && latency.CountAtOrBelow(LatencyHistogram::kMaxValue) == latency.Count()
+                    && (latency.Count() == 0 || latency.Min() <= latency.Max());
+                ++snapshots;
+            }
+        });
+
+        for (std::thread& writer : writers)
+        {
+            writer.join();
+        }
+        const double nsPerEvent = watch.ElapsedSeconds() * 1e9 / static_cast<double>(kThreads * events);
+        stop.store(true);
+        reader.join();
+
+        const MetricsSnapshot snapshot = metrics.Snapshot();
+        const std::uint64_t expected = kThreads * events;
+        const bool exact = snapshot.TotalFrames() == expected
+            && snapshot.latency[static_cast<std::size_t>(LatencyStage::Consumer)].Count() == expected
+            && snapshot.drops[static_cast<std::size_t>(DropReason::QueueFull)] == kThreads
+            && snapshot.writers == kThreads
+            && snapshot.queues.size() == 1 && snapshot.queues[0].maxDepth == 1000 * kThreads;
+        const bool pass = exact && monotonic && consistent && nsPerEvent <= kMaxNsPerEvent * 2;
+        std::printf("threads   %zu writers: %.2f ns/event overall, %zu snapshots meanwhile, totals %s, monotonic %s, histograms %s  %s\n",
+            kThreads, nsPerEvent, snapshots, exact ? "exact" : "WRONG", monotonic ? "yes" : "NO",
+            consistent ? "consistent" : "INCONSISTENT", pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunUnset()
+    {
+        Metrics metrics(MetricsConfig{ kDoors });
+        MetricsWriter& writer = metrics.Writer();
+        const std::int64_t now = DoorCore::UtcNowTicks();
+        writer.Latency(LatencyStage::Render, 0, now);
+        writer.Latency(LatencyStage::Render, now, 0);
+        writer.Latency(LatencyStage::Render, INT64_MIN / 2, INT64_MAX / 2);
+
+        const MetricsSnapshot snapshot = metrics.Snapshot();
+        const LatencyHistogram& render = snapshot.latency[static_cast<std::size_t>(LatencyStage::Render)];
+        const std::uint64_t negative = snapshot.negativeLatency[static_cast<std::size_t>(LatencyStage::Render)];
+        const bool pass = render.Count() == 3 && render.Max() > LatencyHistogram::kMaxValue - 100 && render.Min() == 0 && negative == 1;
+        std::printf("unset     timestamp 0, future and extreme: %llu samples, max %lld ns, %llu negative  %s\n",
+            static_cast<unsigned long long>(render.Count()), static_cast<long long>(render.Max()),
+            static_cast<unsigned long long>(negative), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    void Populate(Metrics& metrics, std::size_t events)
+    {
+        const Pattern pattern(7);
+        Record(metrics, pattern, Mode::Event, events);
+        MetricsWriter& writer = metrics.Writer();
+        for (std::size_t i = 0; i < kPatternSize; ++i)
+        {
+            writer.Latency(LatencyStage::Transport, pattern.stamps[i] / 2, 0);
+            writer.LatencyNs(LatencyStage::Render, 16'000'000 + static_cast<std::int64_t>(i) * 100);
+            if (i % 64 == 0)
+            {
+                writer.Drop(static_cast<DropReason>(i / 64 % kDropReasonCount), pattern.doors[i], pattern.ids[i]);
+            }
+        }
+        writer.Frame(kDoors + 5, 0x1ABCDEF);
+        writer.Latency(LatencyStage::Transport, 10, 0);
+        metrics.SetQueueDepth(metrics.AddQueue("pipe", 1024), 17);
+        metrics.SetQueueDepth(metrics.AddQueue("gateway", 0), 3);
+    }
+
+    bool RunSnapshot(std::size_t events)
+    {
+        Metrics metrics(MetricsConfig{ kDoors });
+        Populate(metrics, events);
+
+        constexpr int kRounds = 50;
+        std::vector<std::uint8_t> binary;
+        std::string text;
+        double snapshotUs = 0;
+        double binaryUs = 0;
+        double textUs = 0;
+        for (int round = 0; round < kRounds; ++round)
+        {
+            Stopwatch snapshotWatch;
+            const MetricsSnapshot snapshot = metrics.Snapshot();
+            snapshotUs += snapshotWatch.ElapsedSeconds() * 1e6;
+
+            binary.clear();
+            Stopwatch binaryWatch;
+            MetricsExport::WriteBinary(snapshot, binary);
+            binaryUs += binaryWatch.ElapsedSeconds() * 1e6;
+
+            text.clear();
+            Stopwatch textWatch;
+            MetricsExport::WritePrometheus(snapshot, text);
+            textUs += textWatch.ElapsedSeconds() * 1e6;
+        }
+
+        const bool pass = !binary.empty() && text.find("rail_hmi_latency_seconds_bucket{stage=\"render\",le=\"+Inf\"}") != std::string::npos;
+        std::printf("snapshot  %u doors, %zu writer: snapshot %.0f us, binary %.0f us (%zu bytes), prometheus %.0f us (%zu bytes)  %s\n",
+            kDoors, static_cast<std::size_t>(1), snapshotUs / kRounds, binaryUs / kRounds, binary.size(), textUs / kRounds, text.size(),
+            pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunAccuracy()
+    {
+        constexpr std::size_t kSamples = 200000;
+        Rng rng(42);
+        std::vector<std::int64_t> values;
+        LatencyHistogram histogram;
+        for (std::size_t i = 0; i < kSamples; ++i)
+        {
+            // Log-uniform over 100 ns .. ~1.7 min, the range the bus sees from shm to a stalled HMI.
+            const double exponent = 2.0 + static_cast<double>(rng.Next() % 1000000) / 1000000.0 * 9.0;
+            const auto value = static_cast<std::int64_t>(std::pow(10.0, exponent));
+            values.push_back(value);
+            histogram.Record(value);
+        }
+        std::sort(values.begin(), values.end());
+
+        double worst = 0;
+        for (const double q : { 0.5, 0.9, 0.99, 0.999, 1.0 })
+        {
+            const std::size_t rank = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(q * kSamples)));
+            const double exact = static_cast<double>(values[rank - 1]);
+            const double error = std::abs(static_cast<double>(histogram.Percentile(q)) - exact) / exact;
+            worst = std::max(worst, error);
+        }
+
+        const double bound = 1.0 / LatencyHistogram::kSubBuckets;
+        const bool pass = worst <= bound && histogram.Min() == values.front() && histogram.Max() == values.back();
+        std::printf("accuracy  p50..p100 of %zu log-uniform samples: worst error %.2f%% (bound %.2f%%)  %s\n",
+            kSamples, worst * 100, bound * 100, pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool SameHistogram(const LatencyHistogram& a, const LatencyHistogram& b)
+    {
+        return a.Count() == b.Count() && a.Sum() == b.Sum() && a.Min() == b.Min() && a.Max() == b.Max() && a.Buckets() == b.Buckets();
+    }
+
+    bool RunRoundTrip(std::size_t events)
+    {
+        Metrics metrics(MetricsConfig{ kDoors });
+        Populate(metrics, events / 10);
+        const MetricsSnapshot original = metrics.Snapshot();
+
+        std::vector<std::uint8_t> binary;
+        MetricsExport::WriteBinary(original, binary);
+
+        MetricsSnapshot copy;
+        std::string error;
+        bool equal = MetricsExport::ReadBinary(binary, copy, error);
+        equal = equal && copy.takenTicks == original.takenTicks && copy.takenNs == original.takenNs && copy.writers == original.writers
+            && copy.negativeLatency == original.negativeLatency && copy.drops == original.drops
+            && copy.doorFrames == original.doorFrames && copy.doorDrops == original.doorDrops
+            && copy.idFrames == original.idFrames && copy.idDrops == original.idDrops && copy.queues.size() == original.queues.size();
+        for (std::size_t stage = 0; equal && stage < kLatencyStageCount; ++stage)
+        {
+            equal = SameHistogram(copy.latency[stage], original.latency[stage]);
+        }
+        for (std::size_t i = 0; equal && i < copy.queues.size(); ++i)
+        {
+            equal = copy.queues[i].name == original.queues[i].name && copy.queues[i].capacity == original.queues[i].capacity
+                && copy.queues[i].depth == original.queues[i].depth && copy.queues[i].maxDepth == original.queues[i].maxDepth;
+        }
+
+        // Every strict prefix must be rejected rather than read as a shorter snapshot.
+        std::size_t accepted = 0;
+        for (std::size_t length = 0; length < binary.size(); ++length)
+        {
+            MetricsSnapshot partial;
+            if (MetricsExport::ReadBinary(std::span<const std::uint8_t>(binary.data(), length), partial, error))
+            {
+                ++accepted;
+            }
+        }
+
+        const bool pass = equal && accepted == 0;
+        std::printf("roundtrip %zu bytes read back %s, %zu truncated dumps accepted  %s\n",
+            binary.size(), equal ? "equal" : "DIFFERENT", accepted, pass ? "PASS" : "FAIL");
+        return pass;
+    }
+}
+
+namespace ConsoleRuntimeBench
+{
+    int RunRecordBench(int argc, char** argv)
+    {
+        const std::size_t events = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 10000000;
+        if (events < 100000)
+        {
+            std::fprintf(stderr, "events must be >= 100000\n");
+            return 1;
+        }
+
+        std::printf("record: %zu events, %u doors\n\n", events, kDoors);
+        bool pass = RunSingleThread(events);
+        pass = RunThreads(events) && pass;
+        pass = RunUnset() && pass;
+        pass = RunSnapshot(events) && pass;
+        pass = RunAccuracy() && pass;
+        pass = RunRoundTrip(events) && pass;
+        return pass ? 0 : 1;
+    }
+}
@@ -1 +1,6 @@
 #pragma once
+
+// Public entry point for the Console.Runtime static library.
+#include "LatencyHistogram.h"
+#include "Metrics.h"
+#include "MetricsExport.h"
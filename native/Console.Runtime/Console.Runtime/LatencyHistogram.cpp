@@ -0,0 +1,99 @@
+#include "pch.h"
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ConsoleRuntime
+{
+    static_assert(LatencyHistogram::BucketIndex(LatencyHistogram::kMaxValue) == LatencyHistogram::kBuckets - 1);
+    static_assert(LatencyHistogram::BucketLower(LatencyHistogram::BucketIndex(1000)) <= 1000);
+    static_assert(LatencyHistogram::BucketUpper(LatencyHistogram::BucketIndex(1000)) >= 1000);
+
+    LatencyHistogram::LatencyHistogram()
+        : _buckets(kBuckets, 0)
+    {
+    }
+
+    void LatencyHistogram::Record(std::int64_t value)
+    {
+        const std::int64_t clamped = std::clamp<std::int64_t>(value, 0, kMaxValue);
+        ++_buckets[BucketIndex(clamped)];
+        ++_count;
+        _sum += static_cast<std::uint64_t>(clamped);
+        _min = std::min(_min, clamped);
+        _max = std::max(_max, clamped);
+    }
+
+    void LatencyHistogram::Merge(const LatencyHistogram& other)
+    {
+        if (other._count == 0)
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < kBuckets; ++i)
+        {
+            _buckets[i] += other._buckets[i];
+        }
+        _count += other._count;
+        _sum += other._sum;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+    }
+
+    void LatencyHistogram::Clear()
+    {
+        std::fill(_buckets.begin(), _buckets.end(), 0);
+        _count = 0;
+        _sum = 0;
+        _min = INT64_MAX;
+        _max = 0;
+    }
+
+    double LatencyHistogram::Mean() const
+    {
+        return _count != 0 ? static_cast<double>(_sum) / static_cast<double>(_count) : 0.0;
+    }
+
+    std::int64_t LatencyHistogram::Percentile(double q) const
+    {
+        if (_count == 0)
+        {
+            return 0;
+        }
+
+        const double clampedQ = std::clamp(q, 0.0, 1.0);
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clampedQ * static_cast<double>(_count))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i)
+        {
+            seen += _buckets[i];
+            if (seen >= rank)
+            {
+                return std::clamp(BucketUpper(i), _min, _max);
+            }
+        }
+        return _max;
+    }
+
+    std::uint64_t LatencyHistogram::CountAtOrBelow(std::int64_t value) const
+    {
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < kBuckets && BucketUpper(i) <= value; ++i)
+        {
+            total += _buckets[i];
+        }
+        return total;
+    }
+
+    void LatencyHistogram::Assign(const std::uint64_t* buckets, std::uint64_t count, std::uint64_t sum, std::int64_t min, std::int64_t max)
+    {
+        std::copy(buckets, buckets + kBuckets, _buckets.begin());
+        _count = count;
+        _sum = sum;
+        // A snapshot racing the first sample can see the count before min.
+        _min = count != 0 ? std::min(min, max) : INT64_MAX;
+        _max = count != 0 ? max : 0;
+    }
+}
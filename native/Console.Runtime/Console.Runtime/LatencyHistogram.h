@@ -0,0 +1,91 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ConsoleRuntime
+{
+    /// <summary>
+    /// Log-linear (HDR-style) histogram of non-negative nanosecond values.
+    /// </summary>
+    /// <remarks>
+    /// Values below 2^kSubBucketBits get one bucket each; above that every power of two is
+    /// split into 2^kSubBucketBits equal buckets, so any recorded value is known to within
+    /// 1/32 (~3%) of itself from 1 ns up to kMaxValue (~18 minutes). The bucket index is a
+    /// bit-width and a shift, cheap enough for the recording hot path; MetricsWriter keeps
+    /// the same layout in atomics and snapshots merge into this plain form.
+    /// </remarks>
+    class LatencyHistogram
+    {
+    public:
+        static constexpr std::uint32_t kSubBucketBits = 5;
+        static constexpr std::uint32_t kSubBuckets = 1u << kSubBucketBits;
+        static constexpr std::uint32_t kValueBits = 40;
+        static constexpr std::int64_t kMaxValue = (std::int64_t{ 1 } << kValueBits) - 1;
+        static constexpr std::size_t kBuckets = (kValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+        /// Bucket of `value`; negative values count as 0, values above kMaxValue as kMaxValue.
+        static constexpr std::size_t BucketIndex(std::int64_t value)
+        {
+            const std::uint64_t v = value <= 0 ? 0 : value > kMaxValue ? kMaxValue : static_cast<std::uint64_t>(value);
+            if (v < kSubBuckets)
+            {
+                return static_cast<std::size_t>(v);
+            }
+            const std::uint32_t shift = static_cast<std::uint32_t>(std::bit_width(v)) - 1 - kSubBucketBits;
+            return (static_cast<std::size_t>(shift + 1) << kSubBucketBits) | static_cast<std::size_t>((v >> shift) & (kSubBuckets - 1));
+        }
+
+        /// Smallest value that lands in `bucket`.
+        static constexpr std::int64_t BucketLower(std::size_t bucket)
+        {
+            if (bucket < kSubBuckets)
+            {
+                return static_cast<std::int64_t>(bucket);
+            }
+            const std::uint32_t shift = static_cast<std::uint32_t>(bucket >> kSubBucketBits) - 1;
+            return static_cast<std::int64_t>((kSubBuckets | (bucket & (kSubBuckets - 1))) << shift);
+        }
+
+        /// Largest value that lands in `bucket`.
+        static constexpr std::int64_t BucketUpper(std::size_t bucket)
+        {
+            return bucket + 1 < kBuckets ? BucketLower(bucket + 1) - 1 : kMaxValue;
+        }
+
+        LatencyHistogram();
+
+        void Record(std::int64_t value);
+        void Merge(const LatencyHistogram& other);
+        void Clear();
+
+        std::uint64_t Count() const { return _count; }
+        /// Sum of the recorded values (after clamping), for means and Prometheus _sum.
+        std::uint64_t Sum() const { return _sum; }
+        std::int64_t Min() const { return _count != 0 ? _min : 0; }
+        std::int64_t Max() const { return _count != 0 ? _max : 0; }
+        double Mean() const;
+
+        /// Value at quantile `q` (0..1): the upper bound of the bucket holding that rank,
+        /// clamped to the recorded range, so it never understates a latency.
+        std::int64_t Percentile(double q) const;
+
+        /// Recorded values <= `value`, to bucket resolution (a bucket counts if its upper bound
+        /// is <= value).
+        std::uint64_t CountAtOrBelow(std::int64_t value) const;
+
+        const std::vector<std::uint64_t>& Buckets() const { return _buckets; }
+
+        /// Replaces the contents with raw state (used by snapshots and the binary reader).
+        void Assign(const std::uint64_t* buckets, std::uint64_t count, std::uint64_t sum, std::int64_t min, std::int64_t max);
+
+    private:
+        std::vector<std::uint64_t> _buckets;
+        std::uint64_t _count = 0;
+        std::uint64_t _sum = 0;
+        std::int64_t _min = INT64_MAX;
+        std::int64_t _max = 0;
+    };
+}
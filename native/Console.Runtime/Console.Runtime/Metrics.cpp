@@ -0,0 +1,269 @@
+#include "pch.h"
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <utility>
+
+using DoorCore::SteadyNowNs;
+
+namespace ConsoleRuntime
+{
+    namespace
+    {
+        std::atomic<std::uint64_t> g_nextInstance{ 1 };
+
+        /// One-entry cache of the writer the calling thread used last.
+        struct ThreadWriterCache
+        {
+            std::uint64_t instance = 0;
+            MetricsWriter* writer = nullptr;
+        };
+
+        thread_local ThreadWriterCache t_writerCache;
+
+        std::uint64_t Sum(const std::vector<std::uint64_t>& values)
+        {
+            std::uint64_t total = 0;
+            for (const std::uint64_t value : values)
+            {
+                total += value;
+            }
+            return total;
+        }
+
+        std::vector<double> Rates(const std::vector<std::uint64_t>& earlier, const std::vector<std::uint64_t>& later, double seconds)
+        {
+            std::vector<double> rates(later.size(), 0.0);
+            if (seconds <= 0 || earlier.size() != later.size())
+            {
+                return rates;
+            }
+            for (std::size_t i = 0; i < later.size(); ++i)
+            {
+                rates[i] = static_cast<double>(later[i] - earlier[i]) / seconds;
+            }
+            return rates;
+        }
+    }
+
+    const char* LatencyStageName(LatencyStage stage)
+    {
+        switch (stage)
+        {
+        case LatencyStage::Transport: return "transport";
+        case LatencyStage::Consumer: return "consumer";
+        case LatencyStage::Render: return "render";
+        }
+        return "unknown";
+    }
+
+    const char* DropReasonName(DropReason reason)
+    {
+        switch (reason)
+        {
+        case DropReason::QueueFull: return "queue_full";
+        case DropReason::Overwritten: return "overwritten";
+        case DropReason::Rejected: return "rejected";
+        case DropReason::Disconnected: return "disconnected";
+        }
+        return "unknown";
+    }
+
+    std::uint64_t MetricsSnapshot::TotalFrames() const
+    {
+        return Sum(doorFrames);
+    }
+
+    std::uint64_t MetricsSnapshot::TotalDrops() const
+    {
+        std::uint64_t total = 0;
+        for (const std::uint64_t count : drops)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+    MetricsRates ComputeRates(const MetricsSnapshot& earlier, const MetricsSnapshot& later)
+    {
+        MetricsRates rates;
+        rates.seconds = static_cast<double>(later.takenNs - earlier.takenNs) / 1e9;
+        if (rates.seconds > 0)
+        {
+            rates.frames = static_cast<double>(later.TotalFrames() - earlier.TotalFrames()) / rates.seconds;
+            rates.drops = static_cast<double>(later.TotalDrops() - earlier.TotalDrops()) / rates.seconds;
+        }
+        rates.doorFrames = Rates(earlier.doorFrames, later.doorFrames, rates.seconds);
+        rates.doorDrops = Rates(earlier.doorDrops, later.doorDrops, rates.seconds);
+        rates.idFrames = Rates(earlier.idFrames, later.idFrames, rates.seconds);
+        rates.idDrops = Rates(earlier.idDrops, later.idDrops, rates.seconds);
+        return rates;
+    }
+
+    MetricsWriter::MetricsWriter(std::uint32_t doors)
+        : _doors(doors)
+        , _doorFrames(new std::atomic<std::uint64_t>[doors + 1]{})
+        , _doorDrops(new std::atomic<std::uint64_t>[doors + 1]{})
+    {
+    }
+
+    Metrics::Metrics(MetricsConfig config)
+        : _config(config)
+        , _instance(g_nextInstance.fetch_add(1, std::memory_order_relaxed))
+        , _gauges(new QueueGauge[std::max<std::uint32_t>(config.maxQueues, 1)])
+    {
+    }
+
+    Metrics::~Metrics()
+    {
+        // Instance numbers are never reused, so stale thread caches can only miss.
+        if (t_writerCache.instance == _instance)
+        {
+            t_writerCache = {};
+        }
+    }
+
+    MetricsWriter& Metrics::Writer()
+    {
+        if (t_writerCache.instance == _instance)
+        {
+            return *t_writerCache.writer;
+        }
+        return RegisterWriter();
+    }
+
+    MetricsWriter& Metrics::RegisterWriter()
+    {
+        const std::thread::id self = std::this_thread::get_id();
+
+        std::lock_guard<std::mutex> lock(_lock);
+        MetricsWriter* writer = nullptr;
+        for (std::size_t i = 0; i < _writers.size(); ++i)
+        {
+            if (_writerThreads[i] == self)
+            {
+                writer = _writers[i].get();
+                break;
+            }
+        }
+        if (writer == nullptr)
+        {
+            _writers.push_back(std::unique_ptr<MetricsWriter>(new MetricsWriter(_config.doors)));
+            _writerThreads.push_back(self);
+            writer = _writers.back().get();
+        }
+
+        t_writerCache = { _instance, writer };
+        return *writer;
+    }
+
+    std::uint32_t Metrics::AddQueue(std::string name, std::uint64_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        const std::uint32_t index = _queueCount.load(std::memory_order_relaxed);
+        if (index >= std::max<std::uint32_t>(_config.maxQueues, 1))
+        {
+            return kNoQueue;
+        }
+
+        _queueNames.push_back(std::move(name));
+        _queueCapacities.push_back(capacity);
+        _queueCount.store(index + 1, std::memory_order_release);
+        return index;
+    }
+
+    void Metrics::SetQueueDepth(std::uint32_t queue, std::uint64_t depth)
+    {
+        if (queue >= _queueCount.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        QueueGauge& gauge = _gauges[queue];
+        gauge.depth.store(depth, std::memory_order_relaxed);
+
+        // Depth may be reported from more than one thread; the high-water mark only grows.
+        std::uint64_t seen = gauge.maxDepth.load(std::memory_order_relaxed);
+        while (depth > seen && !gauge.maxDepth.compare_exchange_weak(seen, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    MetricsSnapshot Metrics::Snapshot() const
+    {
+        MetricsSnapshot snapshot;
+        snapshot.takenTicks = DoorCore::UtcNowTicks();
+        snapshot.takenNs = SteadyNowNs();
+        snapshot.doorFrames.assign(_config.doors + 1, 0);
+        snapshot.doorDrops.assign(_config.doors + 1, 0);
+        snapshot.idFrames.assign(kIdSlots, 0);
+        snapshot.idDrops.assign(kIdSlots, 0);
+
+        std::vector<std::uint64_t> buckets(LatencyHistogram::kBuckets);
+        LatencyHistogram part;
+
+        std::lock_guard<std::mutex> lock(_lock);
+        snapshot.writers = static_cast<std::uint32_t>(_writers.size());
+        for (const std::unique_ptr<MetricsWriter>& writer : _writers)
+        {
+            for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage)
+            {
+                const MetricsWriter::StageHistogram& source = writer->_latency[stage];
+
+                // The count is whatever the buckets hold as read, so cumulative bucket counts
+                // never exceed it. Sum, min and max may trail the newest sample by one.
+                std::uint64_t count = 0;
+                std::size_t lowest = LatencyHistogram::kBuckets;
+                std::size_t highest = 0;
+                for (std::size_t i = 0; i < LatencyHistogram::kBuckets; ++i)
+                {
+                    buckets[i] = source.buckets[i].load(std::memory_order_relaxed);
+                    if (buckets[i] != 0)
+                    {
+                        count += buckets[i];
+                        lowest = std::min(lowest, i);
+                        highest = i;
+                    }
+                }
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                const std::int64_t min = std::min(source.min.load(std::memory_order_relaxed), LatencyHistogram::BucketUpper(lowest));
+                const std::int64_t max = std::max(source.max.load(std::memory_order_relaxed), LatencyHistogram::BucketLower(highest));
+                part.Assign(buckets.data(), count, source.sum.load(std::memory_order_relaxed), min, max);
+                snapshot.latency[stage].Merge(part);
+                snapshot.negativeLatency[stage] += source.negative.load(std::memory_order_relaxed);
+            }
+
+            for (std::size_t i = 0; i < kDropReasonCount; ++i)
+            {
+                snapshot.drops[i] += writer->_drops[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < kIdSlots; ++i)
+            {
+                snapshot.idFrames[i] += writer->_idFrames[i].load(std::memory_order_relaxed);
+                snapshot.idDrops[i] += writer->_idDrops[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i <= _config.doors; ++i)
+            {
+                snapshot.doorFrames[i] += writer->_doorFrames[i].load(std::memory_order_relaxed);
+                snapshot.doorDrops[i] += writer->_doorDrops[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        const std::uint32_t queues = _queueCount.load(std::memory_order_acquire);
+        snapshot.queues.resize(queues);
+        for (std::uint32_t i = 0; i < queues; ++i)
+        {
+            QueueGaugeSnapshot& queue = snapshot.queues[i];
+            queue.name = _queueNames[i];
+            queue.capacity = _queueCapacities[i];
+            queue.depth = _gauges[i].depth.load(std::memory_order_relaxed);
+            queue.maxDepth = _gauges[i].maxDepth.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CanFrame.h"
+#include "LatencyHistogram.h"
+#include "Primitives.h"
+
+namespace ConsoleRuntime
+{
+    /// <summary>
+    /// Points along the door status path where a frame's age is measured.
+    /// </summary>
+    /// <remarks>
+    /// The producer (DoorApp.PublishStatus) stamps CanFrame::timestamp; each later stage
+    /// records now - timestamp, so every stage histogram is the end-to-end latency up to that
+    /// point and Render is the full producer-to-screen time. A stage that knows when the
+    /// previous one handled the frame can record that leg alone by passing it as `from`.
+    /// </remarks>
+    enum class LatencyStage : std::uint8_t
+    {
+        /// Received by a transport (pipe, shared memory, PCAN).
+        Transport,
+        /// Applied by a consumer (gateway, door table).
+        Consumer,
+        /// Shown on screen.
+        Render
+    };
+
+    constexpr std::size_t kLatencyStageCount = 3;
+
+    enum class DropReason : std::uint8_t
+    {
+        /// A bounded queue or ring was full.
+        QueueFull,
+        /// Replaced by a newer frame before it was consumed (coalescing, ring overwrite).
+        Overwritten,
+        /// Malformed or addressed outside the configured range.
+        Rejected,
+        /// Sent or queued while the transport was disconnected.
+        Disconnected
+    };
+
+    constexpr std::size_t kDropReasonCount = 4;
+
+    /// Per-ID slots: one per 11-bit ID plus one shared by every 29-bit ID.
+    constexpr std::size_t kIdSlots = DoorCore::kStandardIdMask + 2;
+    constexpr std::size_t kExtendedIdSlot = kIdSlots - 1;
+
+    const char* LatencyStageName(LatencyStage stage);
+    const char* DropReasonName(DropReason reason);
+
+    struct MetricsConfig
+    {
+        /// Door slots (flat index, e.g. bus * 256 + door). Larger indexes share one overflow
+        /// slot at the end.
+        std::uint32_t doors = 256;
+
+        /// Queue gauges that can be registered with AddQueue.
+        std::uint32_t maxQueues = 16;
+    };
+
+    struct QueueGaugeSnapshot
+    {
+        std::string name;
+        std::uint64_t capacity = 0;
+        std::uint64_t depth = 0;
+        /// High-water mark since the queue was registered.
+        std::uint64_t maxDepth = 0;
+    };
+
+    /// <summary>
+    /// Point-in-time totals of a Metrics registry, merged over all writers.
+    /// </summary>
+    /// <remarks>
+    /// Counters are monotonic; rates come from two snapshots (ComputeRates). Writers keep
+    /// running while a snapshot is taken, so counters read a few nanoseconds apart may be
+    /// off by the events recorded in between.
+    /// </remarks>
+    struct MetricsSnapshot
+    {
+        /// UTC .NET ticks and steady-clock nanoseconds at the time of the snapshot.
+        std::int64_t takenTicks = 0;
+        std::int64_t takenNs = 0;
+        std::uint32_t writers = 0;
+
+        std::array<LatencyHistogram, kLatencyStageCount> latency;
+        /// Samples whose end preceded their start (clock skew between hosts); counted as 0.
+        std::array<std::uint64_t, kLatencyStageCount> negativeLatency{};
+
+        /// Config().doors + 1 entries; the last one is the overflow slot.
+        std::vector<std::uint64_t> doorFrames;
+        std::vector<std::uint64_t> doorDrops;
+        /// kIdSlots entries.
+        std::vector<std::uint64_t> idFrames;
+        std::vector<std::uint64_t> idDrops;
+        std::array<std::uint64_t, kDropReasonCount> drops{};
+        std::vector<QueueGaugeSnapshot> queues;
+
+        std::uint64_t TotalFrames() const;
+        std::uint64_t TotalDrops() const;
+    };
+
+    /// Per-second rates between two snapshots of the same registry.
+    struct MetricsRates
+    {
+        double seconds = 0;
+        double frames = 0;
+        double drops = 0;
+        std::vector<double> doorFrames;
+        std::vector<double> doorDrops;
+        std::vector<double> idFrames;
+        std::vector<double> idDrops;
+    };
+
+    MetricsRates ComputeRates(const MetricsSnapshot& earlier, const MetricsSnapshot& later);
+
+    /// <summary>
+    /// One thread's counters and histograms; only that thread records into it.
+    /// </summary>
+    /// <remarks>
+    /// With a single writer every update is a relaxed load and store on memory no other
+    /// thread writes, so recording never contends, never locks and never issues a locked
+    /// instruction. Snapshot() reads the same atomics from another thread without stopping
+    /// the writer.
+    /// </remarks>
+    class alignas(64) MetricsWriter
+    {
+    public:
+        MetricsWriter(const MetricsWriter&) = delete;
+        MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+        /// Counts one frame for `door` and `canId`.
+        void Frame(std::uint32_t door, std::uint32_t canId)
+        {
+            DoorCore::Bump(_doorFrames[DoorSlot(door)]);
+            DoorCore::Bump(_idFrames[IdSlot(canId)]);
+        }
+
+        void Drop(DropReason reason, std::uint32_t door, std::uint32_t canId)
+        {
+            DoorCore::Bump(_drops[static_cast<std::size_t>(reason)]);
+            DoorCore::Bump(_doorDrops[DoorSlot(door)]);
+            DoorCore::Bump(_idDrops[IdSlot(canId)]);
+        }
+
+        /// Records `toTicks - fromTicks` (.NET ticks, e.g. now - CanFrame::timestamp).
+        void Latency(LatencyStage stage, std::int64_t fromTicks, std::int64_t toTicks)
+        {
+            // Saturate before scaling: an unset timestamp (0) is ~6.4e17 ticks old, which
+            // would overflow as nanoseconds.
+            constexpr std::int64_t kMaxTicks = LatencyHistogram::kMaxValue / 100;
+            std::int64_t ticks = toTicks - fromTicks;
+            if (ticks > kMaxTicks)
+            {
+                ticks = kMaxTicks;
+            }
+            else if (ticks < -kMaxTicks)
+            {
+                ticks = -kMaxTicks;
+            }
+            LatencyNs(stage, ticks * 100);
+        }
+
+        void LatencyNs(LatencyStage stage, std::int64_t nanoseconds)
+        {
+            StageHistogram& histogram = _latency[static_cast<std::size_t>(stage)];
+            if (nanoseconds < 0)
+            {
+                DoorCore::Bump(histogram.negative);
+                nanoseconds = 0;
+            }
+            else if (nanoseconds > LatencyHistogram::kMaxValue)
+            {
+                nanoseconds = LatencyHistogram::kMaxValue;
+            }
+
+            DoorCore::Bump(histogram.buckets[LatencyHistogram::BucketIndex(nanoseconds)]);
+            DoorCore::Bump(histogram.sum, static_cast<std::uint64_t>(nanoseconds));
+            if (nanoseconds > histogram.max.load(std::memory_order_relaxed))
+            {
+                histogram.max.store(nanoseconds, std::memory_order_relaxed);
+            }
+            if (nanoseconds < histogram.min.load(std::memory_order_relaxed))
+            {
+                histogram.min.store(nanoseconds, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        friend class Metrics;
+
+        /// No separate count: a snapshot derives it from the buckets it read, so the two
+        /// always agree even while the writer is recording.
+        struct StageHistogram
+        {
+            std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBuckets> buckets{};
+            std::atomic<std::uint64_t> sum{ 0 };
+            std::atomic<std::uint64_t> negative{ 0 };
+            std::atomic<std::int64_t> min{ INT64_MAX };
+            std::atomic<std::int64_t> max{ 0 };
+        };
+
+        explicit MetricsWriter(std::uint32_t doors);
+
+        std::size_t DoorSlot(std::uint32_t door) const
+        {
+            return door < _doors ? door : _doors;
+        }
+
+        static std::size_t IdSlot(std::uint32_t canId)
+        {
+            return canId <= DoorCore::kStandardIdMask ? canId : kExtendedIdSlot;
+        }
+
+        const std::uint32_t _doors;
+        std::array<StageHistogram, kLatencyStageCount> _latency;
+        std::array<std::atomic<std::uint64_t>, kDropReasonCount> _drops{};
+        std::array<std::atomic<std::uint64_t>, kIdSlots> _idFrames{};
+        std::array<std::atomic<std::uint64_t>, kIdSlots> _idDrops{};
+        std::unique_ptr<std::atomic<std::uint64_t>[]> _doorFrames;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> _doorDrops;
+    };
+
+    /// <summary>
+    /// Registry of per-thread metric writers and queue gauges for the door status path.
+    /// </summary>
+    /// <remarks>
+    /// Each recording thread gets its own MetricsWriter on first use of Writer() and keeps it
+    /// for the registry's lifetime, so totals survive thread exit. Hot paths should fetch the
+    /// writer once per thread (or per batch) and record through the reference; each event
+    /// is then a handful of uncontended stores.
+    ///
+    /// Queue gauges hold the latest depth reported by SetQueueDepth plus a high-water mark.
+    /// Register them with AddQueue before the data path starts.
+    /// </remarks>
+    class Metrics
+    {
+    public:
+        static constexpr std::uint32_t kNoQueue = UINT32_MAX;
+
+        explicit Metrics(MetricsConfig config = {});
+        ~Metrics();
+
+        Metrics(const Metrics&) = delete;
+        Metrics& operator=(const Metrics&) = delete;
+
+        const MetricsConfig& Config() const { return _config; }
+
+        /// The calling thread's writer, created on first use.
+        MetricsWriter& Writer();
+
+        /// Registers a queue gauge; returns its index, or kNoQueue if maxQueues are in use.
+        std::uint32_t AddQueue(std::string name, std::uint64_t capacity = 0);
+
+        void SetQueueDepth(std::uint32_t queue, std::uint64_t depth);
+
+        /// Merges every writer's current totals; recording continues meanwhile.
+        MetricsSnapshot Snapshot() const;
+
+    private:
+        struct alignas(64) QueueGauge
+        {
+            std::atomic<std::uint64_t> depth{ 0 };
+            std::atomic<std::uint64_t> maxDepth{ 0 };
+        };
+
+        MetricsWriter& RegisterWriter();
+
+        const MetricsConfig _config;
+        const std::uint64_t _instance;
+
+        // Guards registration; the writers and gauges themselves are never locked.
+        mutable std::mutex _lock;
+        std::vector<std::unique_ptr<MetricsWriter>> _writers;
+        std::vector<std::thread::id> _writerThreads;
+
+        std::unique_ptr<QueueGauge[]> _gauges;
+        std::vector<std::string> _queueNames;
+        std::vector<std::uint64_t> _queueCapacities;
+        std::atomic<std::uint32_t> _queueCount{ 0 };
+    };
+}
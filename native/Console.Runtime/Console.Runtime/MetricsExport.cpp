@@ -0,0 +1,359 @@
+#include "pch.h"
+
+#include "MetricsExport.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace ConsoleRuntime::MetricsExport
+{
+    // The header is written and read as a raw struct.
+    static_assert(std::endian::native == std::endian::little, "metrics dumps are little-endian");
+
+    namespace
+    {
+        /// Door slots accepted from a dump; guards the allocation against corrupt headers.
+        constexpr std::uint32_t kMaxDumpDoors = 1u << 24;
+
+        /// Upper bounds (seconds) of the Prometheus histogram buckets, besides +Inf.
+        constexpr double kPrometheusBounds[] = {
+            0.00001, 0.00002, 0.00005, 0.0001, 0.0002, 0.0005, 0.001, 0.002, 0.005,
+            0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10,
+        };
+
+        template <typename T>
+        void Put(std::vector<std::uint8_t>& out, const T& value)
+        {
+            const std::size_t at = out.size();
+            out.resize(at + sizeof(T));
+            std::memcpy(out.data() + at, &value, sizeof(T));
+        }
+
+        void PutSparse(std::vector<std::uint8_t>& out, const std::uint64_t* values, std::size_t count)
+        {
+            const std::size_t countAt = out.size();
+            Put<std::uint32_t>(out, 0);
+            std::uint32_t nonZero = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (values[i] != 0)
+                {
+                    Put(out, static_cast<std::uint32_t>(i));
+                    Put(out, values[i]);
+                    ++nonZero;
+                }
+            }
+            std::memcpy(out.data() + countAt, &nonZero, sizeof(nonZero));
+        }
+
+        class Cursor
+        {
+        public:
+            explicit Cursor(std::span<const std::uint8_t> bytes)
+                : _bytes(bytes)
+            {
+            }
+
+            template <typename T>
+            bool Get(T& value)
+            {
+                if (_bytes.size() - _offset < sizeof(T))
+                {
+                    return false;
+                }
+                std::memcpy(&value, _bytes.data() + _offset, sizeof(T));
+                _offset += sizeof(T);
+                return true;
+            }
+
+            bool GetBytes(std::string& text, std::size_t length)
+            {
+                if (_bytes.size() - _offset < length)
+                {
+                    return false;
+                }
+                text.assign(reinterpret_cast<const char*>(_bytes.data() + _offset), length);
+                _offset += length;
+                return true;
+            }
+
+            bool GetSparse(std::uint64_t* values, std::size_t count)
+            {
+                std::uint32_t nonZero = 0;
+                if (!Get(nonZero))
+                {
+                    return false;
+                }
+                for (std::uint32_t n = 0; n < nonZero; ++n)
+                {
+                    std::uint32_t index = 0;
+                    std::uint64_t value = 0;
+                    if (!Get(index) || !Get(value) || index >= count)
+                    {
+                        return false;
+                    }
+                    values[index] = value;
+                }
+                return true;
+            }
+
+        private:
+            std::span<const std::uint8_t> _bytes;
+            std::size_t _offset = 0;
+        };
+
+        void Append(std::string& out, std::uint64_t value)
+        {
+            char text[24];
+            const auto result = std::to_chars(text, text + sizeof(text), value);
+            out.append(text, result.ptr);
+        }
+
+        void Append(std::string& out, double value)
+        {
+            char text[32];
+            const int length = std::snprintf(text, sizeof(text), "%.9g", value);
+            out.append(text, static_cast<std::size_t>(length));
+        }
+
+        void Describe(std::string& out, std::string_view prefix, const char* name, const char* type, const char* help)
+        {
+            out.append("# HELP ").append(prefix).append("_").append(name).append(" ").append(help).append("\n");
+            out.append("# TYPE ").append(prefix).append("_").append(name).append(" ").append(type).append("\n");
+        }
+
+        void Sample(std::string& out, std::string_view prefix, const char* name, std::string_view labels, std::uint64_t value)
+        {
+            out.append(prefix).append("_").append(name);
+            if (!labels.empty())
+            {
+                out.append("{").append(labels).append("}");
+            }
+            out.append(" ");
+            Append(out, value);
+            out.append("\n");
+        }
+
+        std::string DoorLabel(std::size_t door, std::size_t doors)
+        {
+            return door < doors ? "door=\"" + std::to_string(door) + "\"" : std::string("door=\"other\"");
+        }
+
+        std::string IdLabel(std::size_t slot)
+        {
+            if (slot == kExtendedIdSlot)
+            {
+                return "id=\"extended\"";
+            }
+            char text[24];
+            std::snprintf(text, sizeof(text), "id=\"0x%03zX\"", slot);
+            return text;
+        }
+
+        void Series(std::string& out, std::string_view prefix, const char* name, const char* help,
+                    const std::vector<std::uint64_t>& values, bool byDoor)
+        {
+            Describe(out, prefix, name, "counter", help);
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                if (values[i] != 0)
+                {
+                    Sample(out, prefix, name, byDoor ? DoorLabel(i, values.size() - 1) : IdLabel(i), values[i]);
+                }
+            }
+        }
+    }
+
+    void WriteBinary(const MetricsSnapshot& snapshot, std::vector<std::uint8_t>& out)
+    {
+        Header header{};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.doors = static_cast<std::uint32_t>(snapshot.doorFrames.empty() ? 0 : snapshot.doorFrames.size() - 1);
+        header.idSlots = static_cast<std::uint32_t>(kIdSlots);
+        header.stages = static_cast<std::uint32_t>(kLatencyStageCount);
+        header.buckets = static_cast<std::uint32_t>(LatencyHistogram::kBuckets);
+        header.dropReasons = static_cast<std::uint32_t>(kDropReasonCount);
+        header.queueCount = static_cast<std::uint32_t>(snapshot.queues.size());
+        header.takenTicks = snapshot.takenTicks;
+        header.takenNs = snapshot.takenNs;
+        header.writers = snapshot.writers;
+        Put(out, header);
+
+        for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage)
+        {
+            const LatencyHistogram& histogram = snapshot.latency[stage];
+            Put(out, histogram.Count());
+            Put(out, histogram.Sum());
+            Put(out, histogram.Min());
+            Put(out, histogram.Max());
+            Put(out, snapshot.negativeLatency[stage]);
+            PutSparse(out, histogram.Buckets().data(), LatencyHistogram::kBuckets);
+        }
+
+        for (const std::uint64_t count : snapshot.drops)
+        {
+            Put(out, count);
+        }
+        PutSparse(out, snapshot.doorFrames.data(), snapshot.doorFrames.size());
+        PutSparse(out, snapshot.doorDrops.data(), snapshot.doorDrops.size());
+        PutSparse(out, snapshot.idFrames.data(), snapshot.idFrames.size());
+        PutSparse(out, snapshot.idDrops.data(), snapshot.idDrops.size());
+
+        for (const QueueGaugeSnapshot& queue : snapshot.queues)
+        {
+            const std::size_t length = std::min<std::size_t>(queue.name.size(), UINT16_MAX);
+            Put(out, static_cast<std::uint16_t>(length));
+            out.insert(out.end(), queue.name.begin(), queue.name.begin() + static_cast<std::ptrdiff_t>(length));
+            Put(out, queue.capacity);
+            Put(out, queue.depth);
+            Put(out, queue.maxDepth);
+        }
+    }
+
+    bool ReadBinary(std::span<const std::uint8_t> bytes, MetricsSnapshot& snapshot, std::string& error)
+    {
+        Cursor cursor(bytes);
+        Header header{};
+        if (!cursor.Get(header) || header.magic != kMagic)
+        {
+            error = "not a metrics dump";
+            return false;
+        }
+        if (header.version != kVersion || header.idSlots != kIdSlots || header.stages != kLatencyStageCount
+            || header.buckets != LatencyHistogram::kBuckets || header.dropReasons != kDropReasonCount
+            || header.doors > kMaxDumpDoors)
+        {
+            error = "metrics dump has an unsupported version or layout";
+            return false;
+        }
+
+        snapshot = MetricsSnapshot{};
+        snapshot.takenTicks = header.takenTicks;
+        snapshot.takenNs = header.takenNs;
+        snapshot.writers = header.writers;
+
+        std::vector<std::uint64_t> buckets(LatencyHistogram::kBuckets);
+        for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage)
+        {
+            std::uint64_t count = 0;
+            std::uint64_t sum = 0;
+            std::int64_t min = 0;
+            std::int64_t max = 0;
+            std::fill(buckets.begin(), buckets.end(), 0);
+            if (!cursor.Get(count) || !cursor.Get(sum) || !cursor.Get(min) || !cursor.Get(max)
+                || !cursor.Get(snapshot.negativeLatency[stage]) || !cursor.GetSparse(buckets.data(), buckets.size()))
+            {
+                error = "metrics dump is truncated (latency)";
+                return false;
+            }
+            snapshot.latency[stage].Assign(buckets.data(), count, sum, min, max);
+        }
+
+        for (std::uint64_t& count : snapshot.drops)
+        {
+            if (!cursor.Get(count))
+            {
+                error = "metrics dump is truncated (drops)";
+                return false;
+            }
+        }
+
+        snapshot.doorFrames.assign(static_cast<std::size_t>(header.doors) + 1, 0);
+        snapshot.doorDrops.assign(static_cast<std::size_t>(header.doors) + 1, 0);
+        snapshot.idFrames.assign(kIdSlots, 0);
+        snapshot.idDrops.assign(kIdSlots, 0);
+        if (!cursor.GetSparse(snapshot.doorFrames.data(), snapshot.doorFrames.size())
+            || !cursor.GetSparse(snapshot.doorDrops.data(), snapshot.doorDrops.size())
+            || !cursor.GetSparse(snapshot.idFrames.data(), snapshot.idFrames.size())
+            || !cursor.GetSparse(snapshot.idDrops.data(), snapshot.idDrops.size()))
+        {
+            error = "metrics dump is truncated or corrupt (counters)";
+            return false;
+        }
+
+        snapshot.queues.resize(header.queueCount);
+        for (QueueGaugeSnapshot& queue : snapshot.queues)
+        {
+            std::uint16_t length = 0;
+            if (!cursor.Get(length) || !cursor.GetBytes(queue.name, length)
+                || !cursor.Get(queue.capacity) || !cursor.Get(queue.depth) || !cursor.Get(queue.maxDepth))
+            {
+                error = "metrics dump is truncated (queues)";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void WritePrometheus(const MetricsSnapshot& snapshot, std::string& out, std::string_view prefix)
+    {
+        Series(out, prefix, "door_frames_total", "Frames counted per door.", snapshot.doorFrames, true);
+        Series(out, prefix, "door_drops_total", "Frames dropped per door.", snapshot.doorDrops, true);
+        Series(out, prefix, "can_id_frames_total", "Frames counted per CAN ID (29-bit IDs pooled).", snapshot.idFrames, false);
+        Series(out, prefix, "can_id_drops_total", "Frames dropped per CAN ID (29-bit IDs pooled).", snapshot.idDrops, false);
+
+        Describe(out, prefix, "drops_total", "counter", "Frames dropped by reason.");
+        for (std::size_t i = 0; i < kDropReasonCount; ++i)
+        {
+            Sample(out, prefix, "drops_total", std::string("reason=\"") + DropReasonName(static_cast<DropReason>(i)) + "\"", snapshot.drops[i]);
+        }
+
+        Describe(out, prefix, "queue_depth", "gauge", "Latest reported queue depth.");
+        for (const QueueGaugeSnapshot& queue : snapshot.queues)
+        {
+            Sample(out, prefix, "queue_depth", "queue=\"" + queue.name + "\"", queue.depth);
+        }
+        Describe(out, prefix, "queue_depth_max", "gauge", "Highest reported queue depth.");
+        for (const QueueGaugeSnapshot& queue : snapshot.queues)
+        {
+            Sample(out, prefix, "queue_depth_max", "queue=\"" + queue.name + "\"", queue.maxDepth);
+        }
+
+        Describe(out, prefix, "latency_seconds", "histogram", "Frame age at each stage since the producer stamped it.");
+        for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage)
+        {
+            const LatencyHistogram& histogram = snapshot.latency[stage];
+            const std::string stageLabel = std::string("stage=\"") + LatencyStageName(static_cast<LatencyStage>(stage)) + "\"";
+
+            // One pass over the fine buckets, advancing through the coarse bounds.
+            const std::vector<std::uint64_t>& buckets = histogram.Buckets();
+            std::size_t bucket = 0;
+            std::uint64_t cumulative = 0;
+            for (const double bound : kPrometheusBounds)
+            {
+                const auto boundNs = static_cast<std::int64_t>(bound * 1e9);
+                while (bucket < LatencyHistogram::kBuckets && LatencyHistogram::BucketUpper(bucket) <= boundNs)
+                {
+                    cumulative += buckets[bucket++];
+                }
+                out.append(prefix).append("_latency_seconds_bucket{").append(stageLabel).append(",le=\"");
+                Append(out, bound);
+                out.append("\"} ");
+                Append(out, cumulative);
+                out.append("\n");
+            }
+            out.append(prefix).append("_latency_seconds_bucket{").append(stageLabel).append(",le=\"+Inf\"} ");
+            Append(out, histogram.Count());
+            out.append("\n");
+
+            out.append(prefix).append("_latency_seconds_sum{").append(stageLabel).append("} ");
+            Append(out, static_cast<double>(histogram.Sum()) / 1e9);
+            out.append("\n");
+            Sample(out, prefix, "latency_seconds_count", stageLabel, histogram.Count());
+        }
+
+        Describe(out, prefix, "latency_negative_total", "counter", "Latency samples with the end before the start (clock skew).");
+        for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage)
+        {
+            Sample(out, prefix, "latency_negative_total",
+                std::string("stage=\"") + LatencyStageName(static_cast<LatencyStage>(stage)) + "\"", snapshot.negativeLatency[stage]);
+        }
+
+        Describe(out, prefix, "metrics_writers", "gauge", "Threads that have recorded metrics.");
+        Sample(out, prefix, "metrics_writers", {}, snapshot.writers);
+    }
+}
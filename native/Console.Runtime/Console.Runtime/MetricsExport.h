@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Metrics.h"
+
+namespace ConsoleRuntime
+{
+    /// <summary>
+    /// Serializers for MetricsSnapshot: a compact binary dump and Prometheus text.
+    /// </summary>
+    /// <remarks>
+    /// Binary layout (little-endian):
+    ///   Header | Stage[kLatencyStageCount] | drops u64[kDropReasonCount]
+    ///   | doorFrames | doorDrops | idFrames | idDrops | Queue[queueCount]
+    /// Stage = count, sum, min, max, negative (u64 each) + buckets. Bucket and counter
+    /// arrays are sparse: u32 nonZero, then nonZero x (u32 index, u64 value), so an idle
+    /// registry dumps in a few hundred bytes. Queue = u16 name length, name bytes, capacity,
+    /// depth, maxDepth (u64).
+    ///
+    /// The text format is the Prometheus exposition format: counters per door/ID/reason,
+    /// queue gauges and one histogram per stage with fixed 1-2-5 buckets from 10 us to 10 s
+    /// (accurate to the histogram's ~3% bucket resolution). Doors and IDs with no events
+    /// are omitted.
+    /// </remarks>
+    namespace MetricsExport
+    {
+        constexpr std::uint32_t kMagic = 0x54454D52u; // "RMET"
+        constexpr std::uint32_t kVersion = 1;
+
+        struct Header
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t doors;
+            std::uint32_t idSlots;
+            std::uint32_t stages;
+            std::uint32_t buckets;
+            std::uint32_t dropReasons;
+            std::uint32_t queueCount;
+            std::int64_t takenTicks;
+            std::int64_t takenNs;
+            std::uint32_t writers;
+            std::uint32_t reserved;
+        };
+
+        /// Appends the binary dump of `snapshot` to `out`.
+        void WriteBinary(const MetricsSnapshot& snapshot, std::vector<std::uint8_t>& out);
+
+        bool ReadBinary(std::span<const std::uint8_t> bytes, MetricsSnapshot& snapshot, std::string& error);
+
+        /// Appends Prometheus exposition text; metric names start with `prefix`_.
+        void WritePrometheus(const MetricsSnapshot& snapshot, std::string& out, std::string_view prefix = "rail_hmi");
+    }
+}
@@ -0,0 +1,51 @@
+// Door.Core.Bench: microbenchmarks for the Door.Core static library.
+//
+// Usage: Door.Core.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint64_t> g_allocations{ 0 };
+    std::atomic<std::uint64_t> g_allocatedBytes{ 0 };
+
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "codec", "CAN frame wire codec vs. replica of the C# MemoryStream/BinaryWriter path", DoorCoreBench::RunCodecBench },
+        { "engine", "Multi-door simulation engine: doors x Hz, tick jitter and Step() capacity", DoorCoreBench::RunEngineBench },
+    };
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+DoorCoreBench::AllocationCounters DoorCoreBench::ReadAllocationCounters()
+{
+    return { g_allocations.load(std::memory_order_relaxed), g_allocatedBytes.load(std::memory_order_relaxed) };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Door.Core.Bench", kBenchmarks, argc, argv);
+}
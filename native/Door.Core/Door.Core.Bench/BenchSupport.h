@@ -0,0 +1,58 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace DoorCoreBench
+{
+    /// Process-wide heap counters, maintained by the operator new/delete replacements in
+    /// BenchMain.cpp.
+    struct AllocationCounters
+    {
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    AllocationCounters ReadAllocationCounters();
+
+    /// Measures time and heap traffic across a scope.
+    class Measurement
+    {
+    public:
+        Measurement()
+            : _before(ReadAllocationCounters())
+        {
+        }
+
+        double Seconds() const { return _watch.ElapsedSeconds(); }
+
+        AllocationCounters Allocated() const
+        {
+            const AllocationCounters now = ReadAllocationCounters();
+            return { now.allocations - _before.allocations, now.bytes - _before.bytes };
+        }
+
+    private:
+        AllocationCounters _before;
+        BenchCommon::Stopwatch _watch;
+    };
+
+    inline void PrintRate(const char* name, std::uint64_t items, const Measurement& m)
+    {
+        const double seconds = m.Seconds();
+        const AllocationCounters allocated = m.Allocated();
+        std::printf(
+            "%-28s %12.0f frames/s  %8.2f ns/frame  %10llu allocs  %12llu bytes allocated\n",
+            name,
+            items / seconds,
+            seconds * 1e9 / static_cast<double>(items),
+            static_cast<unsigned long long>(allocated.allocations),
+            static_cast<unsigned long long>(allocated.bytes));
+    }
+
+    int RunCodecBench(int argc, char** argv);
+    int RunEngineBench(int argc, char** argv);
+}
@@ -0,0 +1,264 @@
+// Compares the Door.Core wire codec with a C++ replica of the allocation pattern in
+// Common.Transport.Ipc.IpcCanBus.WriteFrame/ReadFrame.
+//
+// Usage: Door.Core.Bench codec [frames]
+
+#include "BenchSupport.h"
+
+#include "FrameCodec.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace DoorCore;
+
+namespace
+{
+    // ------------------------------------------------------------------
+    // Replica of the managed path: every step that allocates in C# allocates here.
+    // ------------------------------------------------------------------
+
+    /// Stand-in for the reference-type Common.Can.CanFrame with its byte[] payload.
+    struct LegacyCanFrame
+    {
+        std::uint32_t Id = 0;
+        std::uint8_t Dlc = 0;
+        std::vector<std::uint8_t> Data;
+        std::int64_t Ticks = 0;
+    };
+
+    /// Stand-in for MemoryStream + BinaryWriter (one growable buffer owned by a heap object).
+    struct LegacyWriter
+    {
+        std::vector<std::uint8_t> buffer;
+
+        template <typename T>
+        void Write(T value)
+        {
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+    };
+
+    /// Stand-in for BinaryReader over a MemoryStream.
+    struct LegacyReader
+    {
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t position = 0;
+
+        template <typename T>
+        T Read()
+        {
+            T value;
+            std::memcpy(&value, data + position, sizeof(T));
+            position += sizeof(T);
+            return value;
+        }
+    };
+
+    void LegacyWriteFrame(std::vector<std::uint8_t>& stream, const LegacyCanFrame& frame)
+    {
+        std::uint8_t dlc = frame.Dlc > 8 ? 8 : frame.Dlc;
+
+        auto ms = std::make_unique<LegacyWriter>();
+        ms->Write(frame.Id);
+        ms->Write(dlc);
+        ms->Write(frame.Ticks);
+        for (std::size_t i = 0; i < dlc; ++i)
+        {
+            ms->Write(i < frame.Data.size() ? frame.Data[i] : std::uint8_t{ 0 });
+        }
+
+        // ms.ToArray()
+        std::vector<std::uint8_t> payload(ms->buffer);
+
+        // new BinaryWriter(stream, leaveOpen: true)
+        auto outBw = std::make_unique<LegacyWriter>();
+        outBw->Write(static_cast<std::int32_t>(payload.size()));
+        stream.insert(stream.end(), outBw->buffer.begin(), outBw->buffer.end());
+        stream.insert(stream.end(), payload.begin(), payload.end());
+    }
+
+    std::unique_ptr<LegacyCanFrame> LegacyReadFrame(const std::uint8_t* stream, std::size_t& position)
+    {
+        auto br = std::make_unique<LegacyReader>(LegacyReader{ stream + position, 4 });
+        const auto len = br->Read<std::int32_t>();
+        position += 4;
+
+        // br.ReadBytes(len)
+        std::vector<std::uint8_t> payload(stream + position, stream + position + len);
+        position += static_cast<std::size_t>(len);
+
+        auto inBr = std::make_unique<LegacyReader>(LegacyReader{ payload.data(), payload.size() });
+        auto frame = std::make_unique<LegacyCanFrame>();
+        frame->Id = inBr->Read<std::uint32_t>();
+        std::uint8_t dlc = inBr->Read<std::uint8_t>();
+        if (dlc > 8) dlc = 8;
+        frame->Ticks = inBr->Read<std::int64_t>();
+        frame->Dlc = dlc;
+        frame->Data.resize(dlc);
+        for (std::size_t i = 0; i < dlc; ++i)
+        {
+            frame->Data[i] = inBr->Read<std::uint8_t>();
+        }
+        return frame;
+    }
+
+    // ------------------------------------------------------------------
+
+    std::vector<CanFrame> MakeWorkload(std::size_t count)
+    {
+        std::vector<CanFrame> frames(count);
+        const std::int64_t now = UtcNowTicks();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (i % 4 == 0)
+            {
+                frames[i] = CanFrame{};
+                frames[i].id = 0x100u + static_cast<std::uint32_t>(i % 64);
+                frames[i].dlc = 8;
+                for (std::uint8_t b = 0; b < 8; ++b)
+                {
+                    frames[i].data[b] = static_cast<std::uint8_t>(i + b);
+                }
+                frames[i].timestamp = now + static_cast<std::int64_t>(i);
+            }
+            else
+            {
+                frames[i] = DoorStateFrame::Create(
+                    static_cast<std::uint8_t>(i),
+                    static_cast<DoorState>(i % 3),
+                    now + static_cast<std::int64_t>(i));
+            }
+        }
+        return frames;
+    }
+
+    bool SameFrame(const CanFrame& a, const CanFrame& b)
+    {
+        return a.id == b.id && a.dlc == b.dlc && a.timestamp == b.timestamp
+            && std::memcmp(a.data, b.data, a.dlc) == 0;
+    }
+}
+
+int DoorCoreBench::RunCodecBench(int argc, char** argv)
+{
+    const std::size_t count = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 2'000'000;
+    if (count == 0)
+    {
+        std::fprintf(stderr, "frames must be > 0\n");
+        return 1;
+    }
+
+    const std::vector<CanFrame> frames = MakeWorkload(count);
+
+    std::vector<LegacyCanFrame> legacyFrames(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        legacyFrames[i].Id = frames[i].id;
+        legacyFrames[i].Dlc = frames[i].dlc;
+        legacyFrames[i].Data.assign(frames[i].data, frames[i].data + frames[i].dlc);
+        legacyFrames[i].Ticks = frames[i].timestamp;
+    }
+
+    // Sinks are sized up front so neither side is charged for the "pipe" buffer.
+    std::vector<std::uint8_t> legacyStream;
+    legacyStream.reserve(count * FrameCodec::kMaxRecordSize);
+    std::vector<std::uint8_t> wire(count * FrameCodec::kMaxRecordSize);
+    std::vector<CanFrame> decoded(count);
+
+    std::printf("codec: %zu frames (3/4 door state DLC 2, 1/4 DLC 8)\n\n", count);
+
+    {
+        Measurement m;
+        for (const LegacyCanFrame& frame : legacyFrames)
+        {
+            LegacyWriteFrame(legacyStream, frame);
+        }
+        PrintRate("encode legacy replica", count, m);
+    }
+
+    std::size_t wireSize = 0;
+    {
+        Measurement m;
+        std::span<std::uint8_t> out(wire);
+        for (const CanFrame& frame : frames)
+        {
+            wireSize += FrameCodec::Encode(frame, out.subspan(wireSize));
+        }
+        PrintRate("encode native single", count, m);
+    }
+
+    {
+        Measurement m;
+        const FrameCodec::BatchEncodeResult result = FrameCodec::EncodeBatch(frames, wire);
+        PrintRate("encode native batch", count, m);
+        if (result.frames != count || result.bytes != wireSize)
+        {
+            std::fprintf(stderr, "batch encode mismatch\n");
+            return 1;
+        }
+    }
+
+    if (wireSize != legacyStream.size() || std::memcmp(wire.data(), legacyStream.data(), wireSize) != 0)
+    {
+        std::fprintf(stderr, "native encoding differs from the legacy byte stream\n");
+        return 1;
+    }
+
+    {
+        std::vector<std::uint8_t> doorIds(count);
+        std::vector<DoorState> states(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            doorIds[i] = static_cast<std::uint8_t>(i);
+            states[i] = static_cast<DoorState>(i % 3);
+        }
+        std::vector<std::uint8_t> doorWire(count * DoorStateCodec::kRecordSize);
+
+        Measurement m;
+        const std::size_t written = DoorStateCodec::EncodeBatch(doorIds, states, frames[0].timestamp, doorWire);
+        PrintRate("encode door state batch", count, m);
+        BenchCommon::DoNotOptimize(written);
+    }
+
+    {
+        Measurement m;
+        std::size_t position = 0;
+        std::uint64_t checksum = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            checksum += LegacyReadFrame(legacyStream.data(), position)->Id;
+        }
+        PrintRate("decode legacy replica", count, m);
+        BenchCommon::DoNotOptimize(checksum);
+    }
+
+    {
+        Measurement m;
+        const FrameCodec::BatchDecodeResult result =
+            FrameCodec::DecodeBatch(std::span<const std::uint8_t>(wire.data(), wireSize), decoded);
+        PrintRate("decode native batch", count, m);
+        if (result.status != FrameCodec::DecodeStatus::Ok || result.frames != count || result.consumed != wireSize)
+        {
+            std::fprintf(stderr, "batch decode failed\n");
+            return 1;
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!SameFrame(frames[i], decoded[i]))
+        {
+            std::fprintf(stderr, "round trip mismatch at frame %zu\n", i);
+            return 1;
+        }
+    }
+
+    std::printf("\nwire bytes: %zu (%.2f bytes/frame), round trip verified\n", wireSize, wireSize / static_cast<double>(count));
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Multi-door simulation engine: real-time rate and tick jitter, plus raw Step() capacity.
+//
+// Usage: Door.Core.Bench engine [seconds] [workers] [publishHz]
+//
+// realtime  runs 1k and 10k doors for `seconds` on real-time workers; reports achieved vs.
+//           target doors x Hz and tick jitter (avg / p99 / max, late ticks)
+// capacity  steps 10k doors as fast as possible; reports door-ticks/s and frames/s
+
+#include "BenchSupport.h"
+
+#include "DoorEngine.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace DoorCore;
+
+namespace
+{
+    DoorEngineConfig MakeConfig(std::uint32_t doors, std::uint32_t workers, std::uint32_t publishHz)
+    {
+        DoorEngineConfig config;
+        config.doorCount = doors;
+        config.workerThreads = workers;
+        config.publishHz = publishHz;
+        return config;
+    }
+
+    void RunRealtime(std::uint32_t doors, std::uint32_t workers, std::uint32_t publishHz, double seconds)
+    {
+        DoorEngine engine(MakeConfig(doors, workers, publishHz));
+
+        std::atomic<std::uint64_t> frames{ 0 };
+        std::atomic<std::uint64_t> largestBurst{ 0 };
+        engine.Start([&](std::uint32_t, const PublishBurst& burst)
+        {
+            frames.fetch_add(burst.frames.size(), std::memory_order_relaxed);
+            std::uint64_t largest = largestBurst.load(std::memory_order_relaxed);
+            while (burst.frames.size() > largest && !largestBurst.compare_exchange_weak(largest, burst.frames.size()))
+            {
+            }
+        });
+
+        BenchCommon::Stopwatch watch;
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        engine.Stop();
+        const double elapsed = watch.ElapsedSeconds();
+
+        const DoorEngineStats stats = engine.Stats();
+        const double target = static_cast<double>(doors) * publishHz;
+        const double achieved = frames.load() / elapsed;
+        std::printf(
+            "realtime %6u doors %2u workers  target %9.0f frames/s  achieved %9.0f (%5.1f%%)  "
+            "bursts %8.0f/s  max burst %5llu  jitter avg %6.1f us  p99 <= %6u us  max %6llu us  late %llu/%llu\n",
+            doors,
+            engine.WorkerCount(),
+            target,
+            achieved,
+            100.0 * achieved / target,
+            stats.bursts / elapsed,
+            static_cast<unsigned long long>(largestBurst.load()),
+            stats.ticks == 0 ? 0.0 : static_cast<double>(stats.jitterSumUs) / stats.ticks,
+            stats.JitterPercentileUs(0.99),
+            static_cast<unsigned long long>(stats.jitterMaxUs),
+            static_cast<unsigned long long>(stats.lateTicks),
+            static_cast<unsigned long long>(stats.ticks));
+    }
+
+    void RunCapacity(std::uint32_t doors, std::uint32_t publishHz, std::uint64_t ticks)
+    {
+        DoorEngine engine(MakeConfig(doors, 1, publishHz));
+
+        std::uint64_t frames = 0;
+        const DoorEngine::PublishSink sink = [&](std::uint32_t, const PublishBurst& burst)
+        {
+            frames += burst.frames.size();
+        };
+
+        // Warm up so every door has left its initial Closed dwell.
+        engine.Step(ticks / 4, sink);
+        frames = 0;
+
+        DoorCoreBench::Measurement m;
+        engine.Step(ticks, sink);
+        const double seconds = m.Seconds();
+        const DoorCoreBench::AllocationCounters allocated = m.Allocated();
+
+        std::printf(
+            "capacity %6u doors             %12.0f door-ticks/s  %10.0f frames/s  %8.2f ns/frame  "
+            "%6.0fx real time  %llu allocs\n",
+            doors,
+            static_cast<double>(doors) * ticks / seconds,
+            frames / seconds,
+            seconds * 1e9 / static_cast<double>(frames == 0 ? 1 : frames),
+            ticks * engine.Config().tickMicros / 1e6 / seconds,
+            static_cast<unsigned long long>(allocated.allocations));
+    }
+}
+
+int DoorCoreBench::RunEngineBench(int argc, char** argv)
+{
+    const double seconds = argc > 0 ? std::strtod(argv[0], nullptr) : 5.0;
+    const std::uint32_t workers = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1;
+    const std::uint32_t publishHz = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 10;
+    if (seconds <= 0 || workers == 0 || publishHz == 0)
+    {
+        std::fprintf(stderr, "seconds, workers and publishHz must be > 0\n");
+        return 1;
+    }
+
+    std::printf("engine: %.1f s per run, %u workers, %u Hz per door, 1 ms tick\n\n", seconds, workers, publishHz);
+
+    RunRealtime(1'000, workers, publishHz, seconds);
+    RunRealtime(10'000, workers, publishHz, seconds);
+    std::printf("\n");
+    RunCapacity(1'000, publishHz, 60'000);
+    RunCapacity(10'000, publishHz, 60'000);
+    return 0;
+}
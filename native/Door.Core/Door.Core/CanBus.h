@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+
+#include "CanFrame.h"
+
+namespace DoorCore
+{
+    /// <summary>
+    /// Callbacks a transport raises from its own threads.
+    /// </summary>
+    /// <remarks>
+    /// Native counterpart of the ICanBus events. Frames are delivered in batches; the span is
+    /// only valid for the duration of the call.
+    /// </remarks>
+    struct CanBusHandlers
+    {
+        /// Raised when the connection state changes.
+        std::function<void(bool)> connectionStateChanged;
+
+        /// Raised with one or more frames received from the transport.
+        std::function<void(std::span<const CanFrame>)> framesReceived;
+    };
+
+    /// Receives transport failures (operation name and detail), like IIpcCanBusLogger.
+    using CanBusLogHandler = std::function<void(const std::string& operation, const std::string& detail)>;
+
+    /// <summary>
+    /// Abstraction for a native CAN transport (shared memory, PCAN, ...), mirroring
+    /// Common.Can.ICanBus.
+    /// </summary>
+    /// <remarks>
+    /// Accepting a frame hands it to the transport; it does not promise delivery. Unlike the
+    /// lossless named pipe, a transport may drop accepted frames downstream - a fan-out that
+    /// does not hold the sender back for slow receivers overwrites what they have not read -
+    /// and reports such losses through its own statistics. See each transport for its mode.
+    /// </remarks>
+    class ICanBus
+    {
+    public:
+        virtual ~ICanBus() = default;
+
+        /// Starts background work (connect/accept and receive loops). Handlers are fixed for
+        /// the lifetime of the run.
+        virtual void Start(CanBusHandlers handlers) = 0;
+
+        /// Stops background work and disconnects. Safe to call more than once.
+        virtual void Stop() = 0;
+
+        /// Indicates if the transport is currently connected.
+        virtual bool IsConnected() const = 0;
+
+        /// Sends a CAN frame. Returns false if the frame was not accepted (not connected or
+        /// queue full).
+        virtual bool Send(const CanFrame& frame) = 0;
+
+        /// Sends several frames; returns how many were accepted, in order.
+        virtual std::size_t SendBatch(std::span<const CanFrame> frames)
+        {
+            std::size_t sent = 0;
+            for (const CanFrame& frame : frames)
+            {
+                if (!Send(frame))
+                {
+                    break;
+                }
+                ++sent;
+            }
+            return sent;
+        }
+    };
+}
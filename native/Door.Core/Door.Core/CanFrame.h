@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace DoorCore
+{
+    /// Maximum payload length of a Classic CAN frame.
+    constexpr std::uint8_t kMaxDlc = 8;
+
+    /// Identifier masks for standard (11-bit) and extended (29-bit) frames.
+    constexpr std::uint32_t kStandardIdMask = 0x7FFu;
+    constexpr std::uint32_t kExtendedIdMask = 0x1FFFFFFFu;
+
+    /// .NET DateTime ticks (100 ns units since 0001-01-01 UTC), the unit carried on the wire.
+    constexpr std::int64_t kTicksPerSecond = 10'000'000;
+    constexpr std::int64_t kTicksPerMillisecond = 10'000;
+    constexpr std::int64_t kUnixEpochTicks = 621'355'968'000'000'000;
+
+    /// <summary>
+    /// One Classic CAN frame with an inline payload.
+    /// </summary>
+    /// <remarks>
+    /// Native counterpart of Common.Can.CanFrame. The type is trivially copyable and has a
+    /// fixed 24-byte layout so frames can be stored in arrays, rings and shared memory and
+    /// copied with memcpy. Timestamp uses the same UTC tick unit as the IPC wire format.
+    /// </remarks>
+    struct CanFrame
+    {
+        /// 11-bit (standard) or 29-bit (extended) identifier stored in a 32-bit container.
+        std::uint32_t id;
+
+        /// Data length code: 0..8 for Classic CAN.
+        std::uint8_t dlc;
+
+        std::uint8_t reserved[3];
+
+        /// Payload bytes; only the first dlc bytes are meaningful.
+        std::uint8_t data[kMaxDlc];
+
+        /// UTC timestamp in .NET ticks.
+        std::int64_t timestamp;
+    };
+
+    static_assert(std::is_trivially_copyable_v<CanFrame>, "CanFrame must stay POD");
+    static_assert(std::is_standard_layout_v<CanFrame>, "CanFrame must stay POD");
+    static_assert(sizeof(CanFrame) == 24, "CanFrame layout is part of the native contract");
+
+    /// Clamps a DLC to the Classic CAN maximum, as the C# transport does.
+    constexpr std::uint8_t ClampDlc(std::uint8_t dlc)
+    {
+        return dlc > kMaxDlc ? kMaxDlc : dlc;
+    }
+
+    /// Converts Unix-epoch nanoseconds to .NET ticks.
+    constexpr std::int64_t TicksFromUnixNanoseconds(std::int64_t nanoseconds)
+    {
+        return kUnixEpochTicks + nanoseconds / 100;
+    }
+
+    /// Converts .NET ticks to Unix-epoch nanoseconds.
+    constexpr std::int64_t UnixNanosecondsFromTicks(std::int64_t ticks)
+    {
+        return (ticks - kUnixEpochTicks) * 100;
+    }
+
+    /// Current UTC time in .NET ticks (equivalent of DateTime.UtcNow.Ticks).
+    inline std::int64_t UtcNowTicks()
+    {
+        const auto since = std::chrono::system_clock::now().time_since_epoch();
+        return TicksFromUnixNanoseconds(std::chrono::duration_cast<std::chrono::nanoseconds>(since).count());
+    }
+}
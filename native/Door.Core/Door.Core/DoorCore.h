@@ -1 +1,9 @@
 #pragma once
+
+// Public entry point for the Door.Core static library.
+#include "CanBus.h"
+#include "CanFrame.h"
+#include "DoorEngine.h"
+#include "DoorStateFrame.h"
+#include "FrameCodec.h"
+#include "Primitives.h"
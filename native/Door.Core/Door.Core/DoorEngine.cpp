@@ -0,0 +1,507 @@
+#include "pch.h"
+
+#include "DoorEngine.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace DoorCore
+{
+    namespace
+    {
+        constexpr std::uint32_t kNone = UINT32_MAX;
+        constexpr std::uint16_t kFullyOpen = 1000;
+
+        constexpr std::uint16_t kMovingCurrentMa = 2500;
+        constexpr std::uint16_t kStalledCurrentMa = 6000;
+
+        std::uint64_t MsToTicks(std::uint32_t milliseconds, std::uint32_t tickMicros)
+        {
+            return std::max<std::uint64_t>(1, static_cast<std::uint64_t>(milliseconds) * 1000 / tickMicros);
+        }
+
+        std::uint32_t WheelSizeFor(std::uint64_t maxDelay)
+        {
+            std::uint32_t size = 64;
+            while (size <= maxDelay && size < (1u << 20))
+            {
+                size <<= 1;
+            }
+            return size;
+        }
+    }
+
+    std::uint32_t DoorEngineStats::JitterPercentileUs(double fraction) const
+    {
+        std::uint64_t total = 0;
+        for (std::uint64_t count : jitterHistogram)
+        {
+            total += count;
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        const auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < jitterHistogram.size(); ++i)
+        {
+            seen += jitterHistogram[i];
+            if (seen >= target)
+            {
+                return kJitterBucketsUs[i];
+            }
+        }
+        return kJitterBucketsUs.back();
+    }
+
+    /// One worker's slice of the door table plus its timing wheel.
+    struct DoorEngine::Shard
+    {
+        std::uint32_t index = 0;
+        std::uint32_t firstDoor = 0;
+        std::uint32_t doorCount = 0;
+
+        // Struct-of-arrays door table (local index).
+        std::vector<DoorPhase> phase;
+        std::vector<std::uint16_t> position;
+        std::vector<std::uint16_t> current;
+        std::vector<std::uint8_t> obstructed;
+        /// Closing will stall at its deadline (decided when closing starts).
+        std::vector<std::uint8_t> obstructionPending;
+        std::vector<std::uint64_t> nextDeadline;
+        std::vector<std::uint64_t> nextPublish;
+        std::vector<std::uint64_t> lastUpdate;
+
+        // Timing wheel: one intrusive list per slot, one entry per door.
+        std::vector<std::uint32_t> wheelHead;
+        std::vector<std::uint32_t> wheelNext;
+        std::uint64_t wheelMask = 0;
+
+        std::vector<CanFrame> burstFrames;
+        std::vector<std::uint32_t> burstDoors;
+
+        std::uint64_t rng = 0;
+        std::uint64_t tick = 0;
+
+        std::atomic<std::uint64_t> ticks{ 0 };
+        std::atomic<std::uint64_t> publishes{ 0 };
+        std::atomic<std::uint64_t> transitions{ 0 };
+        std::atomic<std::uint64_t> bursts{ 0 };
+        std::atomic<std::uint64_t> lateTicks{ 0 };
+        std::atomic<std::uint64_t> jitterSumUs{ 0 };
+        std::atomic<std::uint64_t> jitterMaxUs{ 0 };
+        std::array<std::atomic<std::uint64_t>, DoorEngineStats::kJitterBucketsUs.size()> jitterHistogram{};
+
+        std::uint32_t NextRandom()
+        {
+            // xorshift64*: cheap, deterministic per shard.
+            rng ^= rng >> 12;
+            rng ^= rng << 25;
+            rng ^= rng >> 27;
+            return static_cast<std::uint32_t>((rng * 0x2545F4914F6CDD1DULL) >> 32);
+        }
+
+        std::uint64_t WakeOf(std::uint32_t d) const
+        {
+            return std::min(nextDeadline[d], nextPublish[d]);
+        }
+
+        void Schedule(std::uint32_t d)
+        {
+            const std::size_t slot = static_cast<std::size_t>(WakeOf(d) & wheelMask);
+            wheelNext[d] = wheelHead[slot];
+            wheelHead[slot] = d;
+        }
+
+        void RecordJitter(std::uint64_t jitterUs, std::uint32_t tickMicros)
+        {
+            Bump(jitterSumUs, jitterUs);
+            if (jitterUs > jitterMaxUs.load(std::memory_order_relaxed))
+            {
+                jitterMaxUs.store(jitterUs, std::memory_order_relaxed);
+            }
+            if (jitterUs > tickMicros)
+            {
+                Bump(lateTicks, 1);
+            }
+
+            std::size_t bucket = 0;
+            while (jitterUs > DoorEngineStats::kJitterBucketsUs[bucket])
+            {
+                ++bucket;
+            }
+            Bump(jitterHistogram[bucket], 1);
+        }
+    };
+
+    DoorEngine::DoorEngine(DoorEngineConfig config)
+        : _config(config)
+    {
+        _config.tickMicros = std::max<std::uint32_t>(_config.tickMicros, 1);
+        _config.publishHz = std::max<std::uint32_t>(_config.publishHz, 1);
+        _config.workerThreads = std::max<std::uint32_t>(_config.workerThreads, 1);
+
+        const std::uint32_t buses = (_config.doorCount + DoorStateFrame::kMaxDoors - 1) / DoorStateFrame::kMaxDoors;
+        const std::uint32_t workers = std::max<std::uint32_t>(1, std::min(_config.workerThreads, buses));
+        const std::uint32_t busesPerShard = (buses + workers - 1) / std::max<std::uint32_t>(workers, 1);
+        _doorsPerShard = std::max<std::uint32_t>(1, busesPerShard * DoorStateFrame::kMaxDoors);
+
+        const std::uint64_t travel = MsToTicks(_config.travelMs, _config.tickMicros);
+        const std::uint64_t publishPeriod = std::max<std::uint64_t>(1, 1'000'000 / (static_cast<std::uint64_t>(_config.publishHz) * _config.tickMicros));
+        const std::uint32_t wheelSize = WheelSizeFor(std::max({
+            travel,
+            publishPeriod,
+            MsToTicks(_config.openDwellMs, _config.tickMicros),
+            MsToTicks(_config.closedDwellMs, _config.tickMicros),
+            MsToTicks(_config.obstructedHoldMs, _config.tickMicros) }));
+
+        for (std::uint32_t first = 0; first < _config.doorCount; first += _doorsPerShard)
+        {
+            auto shard = std::make_unique<Shard>();
+            shard->index = static_cast<std::uint32_t>(_shards.size());
+            shard->firstDoor = first;
+            shard->doorCount = std::min(_doorsPerShard, _config.doorCount - first);
+            shard->rng = (_config.seed + 0x9E3779B97F4A7C15ULL * (shard->index + 1)) | 1;
+
+            const std::uint32_t n = shard->doorCount;
+            shard->phase.assign(n, DoorPhase::Closed);
+            shard->position.assign(n, 0);
+            shard->current.assign(n, 0);
+            shard->obstructed.assign(n, 0);
+            shard->obstructionPending.assign(n, 0);
+            shard->nextDeadline.resize(n);
+            shard->nextPublish.resize(n);
+            shard->lastUpdate.assign(n, 0);
+            shard->wheelNext.assign(n, kNone);
+            shard->wheelHead.assign(wheelSize, kNone);
+            shard->wheelMask = wheelSize - 1;
+            shard->burstFrames.reserve(n);
+            shard->burstDoors.reserve(n);
+
+            const std::uint64_t closedDwell = MsToTicks(_config.closedDwellMs, _config.tickMicros);
+            for (std::uint32_t d = 0; d < n; ++d)
+            {
+                // Stagger both the first opening and the publish phase so doors do not all
+                // fire on the same tick.
+                shard->nextDeadline[d] = 1 + shard->NextRandom() % closedDwell;
+                shard->nextPublish[d] = 1 + shard->NextRandom() % publishPeriod;
+                shard->Schedule(d);
+            }
+
+            _shards.push_back(std::move(shard));
+        }
+    }
+
+    DoorEngine::~DoorEngine()
+    {
+        Stop();
+    }
+
+    namespace
+    {
+        struct Timings
+        {
+            std::uint64_t travel;
+            std::uint64_t openDwell;
+            std::uint64_t closedDwell;
+            std::uint64_t obstructedHold;
+            std::uint64_t publishPeriod;
+            std::uint32_t obstructionChance;
+        };
+
+        Timings MakeTimings(const DoorEngineConfig& config)
+        {
+            Timings timings{};
+            timings.travel = MsToTicks(config.travelMs, config.tickMicros);
+            timings.openDwell = MsToTicks(config.openDwellMs, config.tickMicros);
+            timings.closedDwell = MsToTicks(config.closedDwellMs, config.tickMicros);
+            timings.obstructedHold = MsToTicks(config.obstructedHoldMs, config.tickMicros);
+            timings.publishPeriod = std::max<std::uint64_t>(1, 1'000'000 / (static_cast<std::uint64_t>(config.publishHz) * config.tickMicros));
+            timings.obstructionChance = config.obstructionChance;
+            return timings;
+        }
+
+        template <typename ShardT>
+        void AdvanceMotion(ShardT& s, std::uint32_t d, std::uint64_t now, const Timings& t)
+        {
+            const std::uint64_t elapsed = now - s.lastUpdate[d];
+            s.lastUpdate[d] = now;
+            if (elapsed == 0)
+            {
+                return;
+            }
+
+            const std::uint64_t delta = elapsed * kFullyOpen / t.travel;
+            switch (s.phase[d])
+            {
+            case DoorPhase::Opening:
+                s.position[d] = static_cast<std::uint16_t>(std::min<std::uint64_t>(kFullyOpen, s.position[d] + delta));
+                break;
+            case DoorPhase::Closing:
+                s.position[d] = static_cast<std::uint16_t>(s.position[d] > delta ? s.position[d] - delta : 0);
+                break;
+            default:
+                break;
+            }
+        }
+
+        /// Runs the state machine at the door's deadline.
+        template <typename ShardT>
+        void Transition(ShardT& s, std::uint32_t d, std::uint64_t now, const Timings& t)
+        {
+            switch (s.phase[d])
+            {
+            case DoorPhase::Closed:
+                s.phase[d] = DoorPhase::Opening;
+                s.current[d] = kMovingCurrentMa;
+                s.nextDeadline[d] = now + std::max<std::uint64_t>(1, (kFullyOpen - s.position[d]) * t.travel / kFullyOpen);
+                break;
+
+            case DoorPhase::Opening:
+                s.phase[d] = DoorPhase::Open;
+                s.position[d] = kFullyOpen;
+                s.current[d] = 0;
+                s.nextDeadline[d] = now + t.openDwell;
+                break;
+
+            case DoorPhase::Open:
+            {
+                s.phase[d] = DoorPhase::Closing;
+                s.current[d] = kMovingCurrentMa;
+                const std::uint64_t travel = std::max<std::uint64_t>(1, s.position[d] * t.travel / kFullyOpen);
+                if ((s.NextRandom() & 0xFFFF) < t.obstructionChance)
+                {
+                    // Stall somewhere along the closing stroke.
+                    s.obstructionPending[d] = 1;
+                    s.nextDeadline[d] = now + 1 + s.NextRandom() % travel;
+                }
+                else
+                {
+                    s.nextDeadline[d] = now + travel;
+                }
+                break;
+            }
+
+            case DoorPhase::Closing:
+                if (s.obstructionPending[d] != 0)
+                {
+                    s.obstructionPending[d] = 0;
+                    s.obstructed[d] = 1;
+                    s.phase[d] = DoorPhase::Obstructed;
+                    s.current[d] = kStalledCurrentMa;
+                    s.nextDeadline[d] = now + t.obstructedHold;
+                }
+                else
+                {
+                    s.phase[d] = DoorPhase::Closed;
+                    s.position[d] = 0;
+                    s.current[d] = 0;
+                    s.nextDeadline[d] = now + t.closedDwell;
+                }
+                break;
+
+            case DoorPhase::Obstructed:
+                // Reverse to fully open, then try closing again after the dwell.
+                s.obstructed[d] = 0;
+                s.phase[d] = DoorPhase::Opening;
+                s.current[d] = kMovingCurrentMa;
+                s.nextDeadline[d] = now + std::max<std::uint64_t>(1, (kFullyOpen - s.position[d]) * t.travel / kFullyOpen);
+                break;
+            }
+        }
+
+        /// Processes one wheel slot of a shard; returns the number of frames queued.
+        template <typename ShardT>
+        std::size_t ProcessTick(ShardT& s, const Timings& t, std::int64_t timestamp)
+        {
+            const std::uint64_t now = s.tick;
+            const std::size_t slot = static_cast<std::size_t>(now & s.wheelMask);
+
+            std::uint32_t d = s.wheelHead[slot];
+            s.wheelHead[slot] = kNone;
+
+            std::uint64_t transitions = 0;
+            while (d != kNone)
+            {
+                const std::uint32_t next = s.wheelNext[d];
+
+                if (s.WakeOf(d) <= now)
+                {
+                    AdvanceMotion(s, d, now, t);
+
+                    bool publish = s.nextPublish[d] <= now;
+                    if (s.nextDeadline[d] <= now)
+                    {
+                        const DoorState before = WireState(s.phase[d]);
+                        Transition(s, d, now, t);
+                        ++transitions;
+                        publish = publish || WireState(s.phase[d]) != before;
+                    }
+
+                    if (publish)
+                    {
+                        const std::uint32_t door = s.firstDoor + d;
+                        s.burstFrames.push_back(DoorStateFrame::Create(
+                            static_cast<std::uint8_t>(door % DoorStateFrame::kMaxDoors),
+                            WireState(s.phase[d]),
+                            timestamp));
+                        s.burstDoors.push_back(door);
+                        s.nextPublish[d] = now + t.publishPeriod;
+                    }
+                }
+
+                // Either rescheduled after an update, or a wheel wrap-around that is not due yet.
+                s.Schedule(d);
+                d = next;
+            }
+
+            ++s.tick;
+            Bump(s.ticks, 1);
+            Bump(s.transitions, transitions);
+            return s.burstFrames.size();
+        }
+
+        template <typename ShardT, typename Sink>
+        void FlushBurst(ShardT& s, const Sink& sink)
+        {
+            if (s.burstFrames.empty())
+            {
+                return;
+            }
+
+            Bump(s.publishes, s.burstFrames.size());
+            Bump(s.bursts, 1);
+            if (sink)
+            {
+                PublishBurst burst{ s.tick - 1, s.burstFrames, s.burstDoors };
+                sink(s.index, burst);
+            }
+            s.burstFrames.clear();
+            s.burstDoors.clear();
+        }
+    }
+
+    void DoorEngine::Start(PublishSink sink)
+    {
+        if (!_workers.empty())
+        {
+            return;
+        }
+
+        _sink = std::move(sink);
+        _stopping.store(false, std::memory_order_relaxed);
+        for (auto& shard : _shards)
+        {
+            Shard* s = shard.get();
+            _workers.emplace_back([this, s] { RunWorker(*s); });
+        }
+    }
+
+    void DoorEngine::Stop()
+    {
+        _stopping.store(true, std::memory_order_release);
+        for (std::thread& worker : _workers)
+        {
+            worker.join();
+        }
+        _workers.clear();
+    }
+
+    void DoorEngine::Step(std::uint64_t ticks, const PublishSink& sink)
+    {
+        const Timings timings = MakeTimings(_config);
+        for (std::uint64_t i = 0; i < ticks; ++i)
+        {
+            const std::int64_t timestamp = UtcNowTicks();
+            for (auto& shard : _shards)
+            {
+                ProcessTick(*shard, timings, timestamp);
+                FlushBurst(*shard, sink);
+            }
+        }
+    }
+
+    void DoorEngine::RunWorker(Shard& shard)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const Timings timings = MakeTimings(_config);
+        const auto tickDuration = std::chrono::microseconds(_config.tickMicros);
+
+        // Absolute schedule: tick n is due at start + n * tick, so sleep error never accumulates.
+        const Clock::time_point start = Clock::now();
+        std::uint64_t n = 0;
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            const Clock::time_point due = start + tickDuration * (n + 1);
+            Clock::time_point now = Clock::now();
+            if (now < due)
+            {
+                std::this_thread::sleep_until(due);
+                now = Clock::now();
+            }
+
+            const auto jitter = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+            shard.RecordJitter(static_cast<std::uint64_t>(std::max<std::int64_t>(0, jitter)), _config.tickMicros);
+
+            ProcessTick(shard, timings, UtcNowTicks());
+            FlushBurst(shard, _sink);
+            ++n;
+        }
+    }
+
+    DoorEngine::Shard& DoorEngine::ShardOf(std::uint32_t door, std::uint32_t& local) const
+    {
+        const std::uint32_t index = door / _doorsPerShard;
+        local = door - index * _doorsPerShard;
+        return *_shards[index];
+    }
+
+    DoorPhase DoorEngine::Phase(std::uint32_t door) const
+    {
+        std::uint32_t local;
+        return ShardOf(door, local).phase[local];
+    }
+
+    std::uint16_t DoorEngine::Position(std::uint32_t door) const
+    {
+        std::uint32_t local;
+        return ShardOf(door, local).position[local];
+    }
+
+    std::uint16_t DoorEngine::MotorCurrentMilliamps(std::uint32_t door) const
+    {
+        std::uint32_t local;
+        return ShardOf(door, local).current[local];
+    }
+
+    bool DoorEngine::IsObstructed(std::uint32_t door) const
+    {
+        std::uint32_t local;
+        return ShardOf(door, local).obstructed[local] != 0;
+    }
+
+    DoorEngineStats DoorEngine::Stats() const
+    {
+        DoorEngineStats stats;
+        for (const auto& shard : _shards)
+        {
+            stats.ticks += shard->ticks.load(std::memory_order_relaxed);
+            stats.publishes += shard->publishes.load(std::memory_order_relaxed);
+            stats.transitions += shard->transitions.load(std::memory_order_relaxed);
+            stats.bursts += shard->bursts.load(std::memory_order_relaxed);
+            stats.lateTicks += shard->lateTicks.load(std::memory_order_relaxed);
+            stats.jitterSumUs += shard->jitterSumUs.load(std::memory_order_relaxed);
+            stats.jitterMaxUs = std::max(stats.jitterMaxUs, shard->jitterMaxUs.load(std::memory_order_relaxed));
+            for (std::size_t i = 0; i < stats.jitterHistogram.size(); ++i)
+            {
+                stats.jitterHistogram[i] += shard->jitterHistogram[i].load(std::memory_order_relaxed);
+            }
+        }
+        return stats;
+    }
+}
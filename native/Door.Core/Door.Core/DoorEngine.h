@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "CanFrame.h"
+#include "DoorStateFrame.h"
+
+namespace DoorCore
+{
+    /// <summary>
+    /// Internal door phases; the wire only carries the coarser DoorState.
+    /// </summary>
+    enum class DoorPhase : std::uint8_t
+    {
+        Closed = 0,
+        Opening = 1,
+        Open = 2,
+        Closing = 3,
+        /// Closing was blocked; the leaf is stalled and will reverse.
+        Obstructed = 4
+    };
+
+    /// Maps an internal phase to the state published in DoorStateFrame. A moving door is
+    /// reported as Open: it is not safe to depart until it reads Closed.
+    constexpr DoorState WireState(DoorPhase phase)
+    {
+        switch (phase)
+        {
+        case DoorPhase::Closed: return DoorState::Closed;
+        case DoorPhase::Obstructed: return DoorState::Obstructed;
+        default: return DoorState::Open;
+        }
+    }
+
+    struct DoorEngineConfig
+    {
+        std::uint32_t doorCount = 1;
+
+        /// Engine tick; all timings are rounded to whole ticks.
+        std::uint32_t tickMicros = 1000;
+
+        /// Periodic status rate per door. Wire state changes are published immediately.
+        std::uint32_t publishHz = 10;
+
+        /// Doors are split into contiguous shards, each run by one worker thread with its own
+        /// timing wheel. Shards are aligned to 256 doors so one CAN bus never spans workers.
+        std::uint32_t workerThreads = 1;
+
+        std::uint32_t travelMs = 2500;
+        std::uint32_t openDwellMs = 3000;
+        std::uint32_t closedDwellMs = 4000;
+        std::uint32_t obstructedHoldMs = 1000;
+
+        /// Probability that a closing cycle hits an obstruction, in 1/65536 units.
+        std::uint32_t obstructionChance = 3277; // ~5%
+
+        std::uint64_t seed = 0x5eed;
+    };
+
+    /// <summary>
+    /// Frames published by one worker in one tick, with the engine-wide door index of each
+    /// frame (the bus is doorIndex / 256, the CAN door id doorIndex % 256).
+    /// </summary>
+    struct PublishBurst
+    {
+        std::uint64_t tick;
+        std::span<const CanFrame> frames;
+        std::span<const std::uint32_t> doors;
+    };
+
+    struct DoorEngineStats
+    {
+        /// Upper bounds (microseconds) of the jitter histogram buckets; the last is open-ended.
+        static constexpr std::array<std::uint32_t, 12> kJitterBucketsUs = {
+            10, 25, 50, 100, 250, 500, 1'000, 2'500, 5'000, 10'000, 50'000, UINT32_MAX
+        };
+
+        std::uint64_t ticks = 0;
+        std::uint64_t publishes = 0;
+        std::uint64_t transitions = 0;
+        std::uint64_t bursts = 0;
+        /// Ticks that started more than one tick late (the worker fell behind).
+        std::uint64_t lateTicks = 0;
+        std::uint64_t jitterSumUs = 0;
+        std::uint64_t jitterMaxUs = 0;
+        std::array<std::uint64_t, kJitterBucketsUs.size()> jitterHistogram{};
+
+        /// Smallest bucket bound covering the given fraction of ticks.
+        std::uint32_t JitterPercentileUs(double fraction) const;
+    };
+
+    /// <summary>
+    /// Simulates many doors in one process with a struct-of-arrays state table and one
+    /// hashed timing wheel per worker.
+    /// </summary>
+    /// <remarks>
+    /// Replaces one DoorApp process + System.Timers.Timer per door. Each door has exactly one
+    /// wheel entry (an intrusive index list, so scheduling never allocates) keyed by its next
+    /// event: a state-machine deadline or its periodic publish. On each tick a worker
+    /// advances only the doors in the current slot and hands every resulting frame to the
+    /// sink as one burst, which maps directly onto ICanBus::SendBatch.
+    ///
+    /// Door state accessors read the table without synchronization; use them while the
+    /// engine is stopped, between Step() calls, or from the sink of the owning worker.
+    /// </remarks>
+    class DoorEngine
+    {
+    public:
+        using PublishSink = std::function<void(std::uint32_t worker, const PublishBurst& burst)>;
+
+        explicit DoorEngine(DoorEngineConfig config);
+        ~DoorEngine();
+
+        DoorEngine(const DoorEngine&) = delete;
+        DoorEngine& operator=(const DoorEngine&) = delete;
+
+        /// Starts one real-time worker per shard.
+        void Start(PublishSink sink);
+        void Stop();
+
+        /// Advances every shard by `ticks` without sleeping (single-threaded); for replay,
+        /// tests and capacity measurements. Must not be called while started.
+        void Step(std::uint64_t ticks, const PublishSink& sink);
+
+        std::uint32_t DoorCount() const { return _config.doorCount; }
+        std::uint32_t WorkerCount() const { return static_cast<std::uint32_t>(_shards.size()); }
+        const DoorEngineConfig& Config() const { return _config; }
+
+        DoorPhase Phase(std::uint32_t door) const;
+        /// Leaf position in per-mille: 0 closed, 1000 fully open.
+        std::uint16_t Position(std::uint32_t door) const;
+        std::uint16_t MotorCurrentMilliamps(std::uint32_t door) const;
+        bool IsObstructed(std::uint32_t door) const;
+
+        DoorEngineStats Stats() const;
+
+    private:
+        struct Shard;
+
+        Shard& ShardOf(std::uint32_t door, std::uint32_t& local) const;
+        void RunWorker(Shard& shard);
+
+        DoorEngineConfig _config;
+        std::vector<std::unique_ptr<Shard>> _shards;
+        std::uint32_t _doorsPerShard = 0;
+
+        PublishSink _sink;
+        std::vector<std::thread> _workers;
+        std::atomic<bool> _stopping{ false };
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CanFrame.h"
+
+namespace DoorCore
+{
+    /// <summary>
+    /// Supported door states for the CAN door status frame.
+    /// </summary>
+    enum class DoorState : std::uint8_t
+    {
+        /// Door is closed.
+        Closed = 0,
+        /// Door is open.
+        Open = 1,
+        /// Door movement is obstructed.
+        Obstructed = 2
+    };
+
+    /// <summary>
+    /// Helper for building and parsing the standardized door state CAN frame.
+    /// </summary>
+    /// <remarks>
+    /// Mirrors Common.Can.DoorStateFrame:
+    /// - Identifier: 0x200 + doorId (standard 11-bit ID).
+    /// - DLC: 2 bytes.
+    /// - Data[0]: doorId (0..255).
+    /// - Data[1]: DoorState enum value.
+    /// </remarks>
+    struct DoorStateFrame
+    {
+        /// Base CAN identifier for door state frames.
+        static constexpr std::uint32_t kBaseId = 0x200u;
+
+        /// Payload length in bytes.
+        static constexpr std::uint8_t kPayloadLength = 2;
+
+        /// Number of addressable doors on one bus.
+        static constexpr std::uint32_t kMaxDoors = 256;
+
+        static constexpr bool IsDefined(std::uint8_t value)
+        {
+            return value <= static_cast<std::uint8_t>(DoorState::Obstructed);
+        }
+
+        /// Builds a door state frame for the provided door and state.
+        static constexpr CanFrame Create(std::uint8_t doorId, DoorState state, std::int64_t timestamp)
+        {
+            CanFrame frame{};
+            frame.id = kBaseId + doorId;
+            frame.dlc = kPayloadLength;
+            frame.data[0] = doorId;
+            frame.data[1] = static_cast<std::uint8_t>(state);
+            frame.timestamp = timestamp;
+            return frame;
+        }
+
+        /// Parses a door state frame, validating identifier, payload, and enum value.
+        static constexpr bool TryParse(const CanFrame& frame, std::uint8_t& doorId, DoorState& state)
+        {
+            doorId = 0;
+            state = DoorState::Closed;
+
+            if (frame.dlc < kPayloadLength)
+            {
+                return false;
+            }
+
+            // Unsigned wrap makes this a single compare for the 0x200..0x2FF window.
+            const std::uint32_t offset = frame.id - kBaseId;
+            if (offset >= kMaxDoors)
+            {
+                return false;
+            }
+
+            if (frame.data[0] != offset || !IsDefined(frame.data[1]))
+            {
+                return false;
+            }
+
+            doorId = static_cast<std::uint8_t>(offset);
+            state = static_cast<DoorState>(frame.data[1]);
+            return true;
+        }
+    };
+}
@@ -0,0 +1,73 @@
+#include "pch.h"
+
+#include "FrameCodec.h"
+
+#include <algorithm>
+
+namespace DoorCore
+{
+    namespace FrameCodec
+    {
+        BatchEncodeResult EncodeBatch(std::span<const CanFrame> frames, std::span<std::uint8_t> out)
+        {
+            std::uint8_t* cursor = out.data();
+            std::size_t remaining = out.size();
+            std::size_t count = 0;
+
+            for (const CanFrame& frame : frames)
+            {
+                const std::uint8_t dlc = ClampDlc(frame.dlc);
+                const std::size_t size = kLengthPrefixSize + kHeaderSize + dlc;
+                if (remaining < size)
+                {
+                    break;
+                }
+
+                Detail::EncodeUnchecked(frame, dlc, cursor);
+                cursor += size;
+                remaining -= size;
+                ++count;
+            }
+
+            return { count, out.size() - remaining };
+        }
+
+        BatchDecodeResult DecodeBatch(std::span<const std::uint8_t> in, std::span<CanFrame> out)
+        {
+            std::size_t consumed = 0;
+            std::size_t count = 0;
+
+            while (count < out.size() && consumed < in.size())
+            {
+                const DecodeResult result = Decode(in.subspan(consumed), out[count]);
+                if (result.status != DecodeStatus::Ok)
+                {
+                    return { result.status, count, consumed };
+                }
+
+                consumed += result.consumed;
+                ++count;
+            }
+
+            return { DecodeStatus::Ok, count, consumed };
+        }
+    }
+
+    std::size_t DoorStateCodec::EncodeBatch(
+        std::span<const std::uint8_t> doorIds,
+        std::span<const DoorState> states,
+        std::int64_t timestamp,
+        std::span<std::uint8_t> out)
+    {
+        const std::size_t count = std::min({ doorIds.size(), states.size(), out.size() / kRecordSize });
+
+        std::uint8_t* cursor = out.data();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Encode(doorIds[i], states[i], timestamp, std::span<std::uint8_t, kRecordSize>(cursor, kRecordSize));
+            cursor += kRecordSize;
+        }
+
+        return count;
+    }
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "CanFrame.h"
+#include "DoorStateFrame.h"
+
+namespace DoorCore
+{
+    /// <summary>
+    /// Encoder/decoder for the length-prefixed IPC wire format used by Common.Transport.Ipc.
+    /// </summary>
+    /// <remarks>
+    /// Record layout (little-endian, matching BinaryWriter):
+    ///   Length:i32 | Id:u32 | Dlc:u8 | Ticks:i64 | Data[Dlc]
+    /// Length counts the bytes after the prefix. All functions work on caller-provided
+    /// buffers and never allocate.
+    /// </remarks>
+    namespace FrameCodec
+    {
+        constexpr std::size_t kLengthPrefixSize = 4;
+        constexpr std::size_t kHeaderSize = 4 + 1 + 8;
+        constexpr std::size_t kMaxPayloadSize = kHeaderSize + kMaxDlc;
+        constexpr std::size_t kMaxRecordSize = kLengthPrefixSize + kMaxPayloadSize;
+
+        /// Upper bound accepted for the length prefix; larger values mean a corrupt stream.
+        constexpr std::int32_t kMaxAcceptedLength = 1024;
+
+        enum class DecodeStatus
+        {
+            /// A complete record was decoded.
+            Ok,
+            /// The buffer holds only part of a record; read more bytes and retry.
+            NeedMoreData,
+            /// The record is malformed; the stream cannot be resynchronized.
+            Invalid
+        };
+
+        struct DecodeResult
+        {
+            DecodeStatus status;
+            /// Bytes consumed from the input (0 unless status is Ok).
+            std::size_t consumed;
+        };
+
+        struct BatchEncodeResult
+        {
+            std::size_t frames;
+            std::size_t bytes;
+        };
+
+        struct BatchDecodeResult
+        {
+            /// Status of the record that stopped the batch (Ok if the output span filled up
+            /// or the input was consumed exactly).
+            DecodeStatus status;
+            std::size_t frames;
+            std::size_t consumed;
+        };
+
+        namespace Detail
+        {
+            constexpr void StoreU32(std::uint8_t* out, std::uint32_t value)
+            {
+                out[0] = static_cast<std::uint8_t>(value);
+                out[1] = static_cast<std::uint8_t>(value >> 8);
+                out[2] = static_cast<std::uint8_t>(value >> 16);
+                out[3] = static_cast<std::uint8_t>(value >> 24);
+            }
+
+            constexpr void StoreI64(std::uint8_t* out, std::int64_t value)
+            {
+                const auto bits = static_cast<std::uint64_t>(value);
+                StoreU32(out, static_cast<std::uint32_t>(bits));
+                StoreU32(out + 4, static_cast<std::uint32_t>(bits >> 32));
+            }
+
+            constexpr std::uint32_t LoadU32(const std::uint8_t* in)
+            {
+                return static_cast<std::uint32_t>(in[0])
+                    | static_cast<std::uint32_t>(in[1]) << 8
+                    | static_cast<std::uint32_t>(in[2]) << 16
+                    | static_cast<std::uint32_t>(in[3]) << 24;
+            }
+
+            constexpr std::int64_t LoadI64(const std::uint8_t* in)
+            {
+                const std::uint64_t lo = LoadU32(in);
+                const std::uint64_t hi = LoadU32(in + 4);
+                return static_cast<std::int64_t>(lo | hi << 32);
+            }
+
+            /// Writes one record whose payload length is dlc; out must hold the full record.
+            constexpr void EncodeUnchecked(const CanFrame& frame, std::uint8_t dlc, std::uint8_t* out)
+            {
+                StoreU32(out, static_cast<std::uint32_t>(kHeaderSize + dlc));
+                StoreU32(out + 4, frame.id);
+                out[8] = dlc;
+                StoreI64(out + 9, frame.timestamp);
+                for (std::size_t i = 0; i < dlc; ++i)
+                {
+                    out[17 + i] = frame.data[i];
+                }
+            }
+        }
+
+        /// Size in bytes of the encoded record for frame, including the length prefix.
+        constexpr std::size_t EncodedSize(const CanFrame& frame)
+        {
+            return kLengthPrefixSize + kHeaderSize + ClampDlc(frame.dlc);
+        }
+
+        /// Encodes one frame. Returns the bytes written, or 0 if out is too small.
+        constexpr std::size_t Encode(const CanFrame& frame, std::span<std::uint8_t> out)
+        {
+            const std::uint8_t dlc = ClampDlc(frame.dlc);
+            const std::size_t size = kLengthPrefixSize + kHeaderSize + dlc;
+            if (out.size() < size)
+            {
+                return 0;
+            }
+
+            Detail::EncodeUnchecked(frame, dlc, out.data());
+            return size;
+        }
+
+        /// Decodes one record from the front of in.
+        constexpr DecodeResult Decode(std::span<const std::uint8_t> in, CanFrame& frame)
+        {
+            if (in.size() < kLengthPrefixSize)
+            {
+                return { DecodeStatus::NeedMoreData, 0 };
+            }
+
+            const auto length = static_cast<std::int32_t>(Detail::LoadU32(in.data()));
+            if (length <= 0 || length > kMaxAcceptedLength || static_cast<std::size_t>(length) < kHeaderSize)
+            {
+                return { DecodeStatus::Invalid, 0 };
+            }
+
+            const std::size_t total = kLengthPrefixSize + static_cast<std::size_t>(length);
+            if (in.size() < total)
+            {
+                return { DecodeStatus::NeedMoreData, 0 };
+            }
+
+            const std::uint8_t* payload = in.data() + kLengthPrefixSize;
+            const std::uint8_t dlc = ClampDlc(payload[4]);
+            if (kHeaderSize + dlc > static_cast<std::size_t>(length))
+            {
+                return { DecodeStatus::Invalid, 0 };
+            }
+
+            frame = CanFrame{};
+            frame.id = Detail::LoadU32(payload);
+            frame.dlc = dlc;
+            frame.timestamp = Detail::LoadI64(payload + 5);
+            for (std::size_t i = 0; i < dlc; ++i)
+            {
+                frame.data[i] = payload[kHeaderSize + i];
+            }
+
+            // Trailing bytes inside the declared length are skipped, like the C# reader.
+            return { DecodeStatus::Ok, total };
+        }
+
+        /// Encodes as many frames as fit into out, in order.
+        BatchEncodeResult EncodeBatch(std::span<const CanFrame> frames, std::span<std::uint8_t> out);
+
+        /// Decodes consecutive records from in until out is full, the input is exhausted or a
+        /// record is incomplete/invalid. A trailing partial record is left unconsumed.
+        BatchDecodeResult DecodeBatch(std::span<const std::uint8_t> in, std::span<CanFrame> out);
+    }
+
+    /// <summary>
+    /// Fixed-layout codec for frames whose DLC is known at compile time.
+    /// </summary>
+    /// <remarks>
+    /// Every offset and the record size are constants, so the compiler emits straight-line
+    /// stores/loads without the DLC clamp or per-byte loop bounds of the generic path.
+    /// </remarks>
+    template <std::uint8_t Dlc>
+    struct FixedFrameCodec
+    {
+        static_assert(Dlc <= kMaxDlc, "Classic CAN payload is at most 8 bytes");
+
+        static constexpr std::size_t kPayloadSize = FrameCodec::kHeaderSize + Dlc;
+        static constexpr std::size_t kRecordSize = FrameCodec::kLengthPrefixSize + kPayloadSize;
+
+        /// Encodes frame (whose dlc must equal Dlc) into exactly kRecordSize bytes.
+        static constexpr void Encode(const CanFrame& frame, std::span<std::uint8_t, kRecordSize> out)
+        {
+            FrameCodec::Detail::EncodeUnchecked(frame, Dlc, out.data());
+        }
+
+        /// Decodes a record known to have this layout. Returns false if the header disagrees.
+        static constexpr bool Decode(std::span<const std::uint8_t, kRecordSize> in, CanFrame& frame)
+        {
+            const std::uint8_t* p = in.data();
+            if (FrameCodec::Detail::LoadU32(p) != kPayloadSize || p[8] != Dlc)
+            {
+                return false;
+            }
+
+            frame = CanFrame{};
+            frame.id = FrameCodec::Detail::LoadU32(p + 4);
+            frame.dlc = Dlc;
+            frame.timestamp = FrameCodec::Detail::LoadI64(p + 9);
+            for (std::size_t i = 0; i < Dlc; ++i)
+            {
+                frame.data[i] = p[17 + i];
+            }
+            return true;
+        }
+    };
+
+    /// <summary>
+    /// Wire codec specialized for DoorStateFrame (0x200 + doorId, DLC 2).
+    /// </summary>
+    struct DoorStateCodec
+    {
+        using Layout = FixedFrameCodec<DoorStateFrame::kPayloadLength>;
+
+        static constexpr std::size_t kRecordSize = Layout::kRecordSize;
+
+        static constexpr void Encode(
+            std::uint8_t doorId,
+            DoorState state,
+            std::int64_t timestamp,
+            std::span<std::uint8_t, kRecordSize> out)
+        {
+            Layout::Encode(DoorStateFrame::Create(doorId, state, timestamp), out);
+        }
+
+        static constexpr bool Decode(
+            std::span<const std::uint8_t, kRecordSize> in,
+            std::uint8_t& doorId,
+            DoorState& state,
+            std::int64_t& timestamp)
+        {
+            CanFrame frame{};
+            if (!Layout::Decode(in, frame) || !DoorStateFrame::TryParse(frame, doorId, state))
+            {
+                return false;
+            }
+
+            timestamp = frame.timestamp;
+            return true;
+        }
+
+        /// Encodes a run of door states into consecutive records. out must hold
+        /// doorIds.size() * kRecordSize bytes; returns the number of records written.
+        static std::size_t EncodeBatch(
+            std::span<const std::uint8_t> doorIds,
+            std::span<const DoorState> states,
+            std::int64_t timestamp,
+            std::span<std::uint8_t> out);
+    };
+
+    static_assert(DoorStateCodec::kRecordSize == 19, "Door state record is 4 + 13 + 2 bytes");
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace DoorCore
+{
+    /// Adds to a statistics counter that has a single writer and any number of readers. A
+    /// relaxed load/store pair is enough for that and keeps a locked read-modify-write off
+    /// the hot path; counters with several writers need fetch_add instead.
+    inline void Bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /// Fibonacci hash of a CAN ID into a power-of-two table of 2^(32 - shift) slots.
+    constexpr std::uint32_t HashId(std::uint32_t id, std::uint32_t shift)
+    {
+        return (id * 0x9E3779B1u) >> shift;
+    }
+
+    /// Monotonic nanoseconds for timeouts, heartbeats and latency; not related to wall time.
+    inline std::int64_t SteadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr std::int64_t MsToNs(std::uint32_t milliseconds)
+    {
+        return static_cast<std::int64_t>(milliseconds) * 1'000'000;
+    }
+}
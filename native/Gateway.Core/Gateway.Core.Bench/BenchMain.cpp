@@ -0,0 +1,19 @@
+// Gateway.Core.Bench: benchmarks and stress runs for the Gateway.Core static library.
+//
+// Usage: Gateway.Core.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "ring-stress", "N producers into the fan-in ring; checks per-producer ordering and counters", GatewayCoreBench::RunRingStress },
+        { "route", "Compiled ID routing table: ns/frame with thousands of rules and mixed 11/29-bit traffic", GatewayCoreBench::RunRouteBench },
+        { "trace", "Trace record rate, mmap replay/seek throughput, paced replay, stop, quiet-bus seal and .asc/.trc round trip", GatewayCoreBench::RunTraceBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Gateway.Core.Bench", kBenchmarks, argc, argv);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GatewayCoreBench
+{
+    int RunRingStress(int argc, char** argv);
+    int RunRouteBench(int argc, char** argv);
+    int RunTraceBench(int argc, char** argv);
+}
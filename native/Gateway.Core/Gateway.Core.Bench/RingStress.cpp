@@ -0,0 +1,259 @@
+// Stress run for FanInRing + FrameDispatcher.
+//
+// Usage: Gateway.Core.Bench ring-stress [producers] [framesPerProducer] [laneCapacity] [consumerDelayNs] [producerPaceNs]
+//
+// Every producer thread owns one lane and pushes frames tagged with its index (id) and a
+// sequence number (payload). The dispatcher thread checks that each producer's sequence is
+// strictly increasing (contiguous under Block) and that the ring counters add up. All three
+// overflow policies are exercised.
+//
+// Free-running producers finish long before an idle-sleeping dispatcher catches up, so most
+// frames are dropped unchecked. A second round paces every producer (producerPaceNs per
+// frame) so the dispatcher stays busy and drains while lanes are being written; it must
+// check at least kPacedCheckedPercent of the frames.
+
+#include "BenchSupport.h"
+
+#include "FrameDispatcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace GatewayCore;
+using DoorCore::CanFrame;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::size_t kProducerBatch = 16;
+
+    /// Frames per producer in the paced round, capped so it stays short at low rates.
+    constexpr std::uint64_t kPacedFrames = 250'000;
+
+    /// Share of the paced frames the dispatcher must see (and order-check).
+    constexpr std::uint64_t kPacedCheckedPercent = 90;
+
+    const char* PolicyName(OverflowPolicy policy)
+    {
+        switch (policy)
+        {
+        case OverflowPolicy::DropOldest: return "drop-oldest";
+        case OverflowPolicy::DropNewest: return "drop-newest";
+        case OverflowPolicy::Block: return "block";
+        }
+        return "?";
+    }
+
+    CanFrame MakeFrame(std::uint32_t producer, std::uint64_t sequence)
+    {
+        CanFrame frame{};
+        frame.id = producer;
+        frame.dlc = 8;
+        std::memcpy(frame.data, &sequence, sizeof(sequence));
+        return frame;
+    }
+
+    struct ConsumerState
+    {
+        std::vector<std::int64_t> lastSequence;
+        std::uint64_t received = 0;
+        std::uint64_t gaps = 0;
+        std::uint64_t orderErrors = 0;
+    };
+
+    void BusyWait(std::chrono::nanoseconds duration)
+    {
+        const auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until)
+        {
+        }
+    }
+
+    /// Holds a paced producer to `pace` per frame. Sleeping until the schedule rather than
+    /// spinning leaves the core to the dispatcher, and a late producer catches up in a burst.
+    void Pace(std::chrono::steady_clock::time_point start, std::chrono::nanoseconds pace, std::uint64_t pushed)
+    {
+        if (pace.count() == 0)
+        {
+            return;
+        }
+
+        const auto due = start + pace * static_cast<std::int64_t>(pushed);
+        if (std::chrono::steady_clock::now() < due)
+        {
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    bool RunPolicy(
+        OverflowPolicy policy,
+        std::uint32_t producers,
+        std::uint64_t framesPerProducer,
+        std::size_t laneCapacity,
+        std::chrono::nanoseconds consumerDelay,
+        std::chrono::nanoseconds producerPace)
+    {
+        FrameFanIn ring(producers, laneCapacity, policy);
+
+        ConsumerState state;
+        state.lastSequence.assign(producers, -1);
+
+        FrameDispatcher dispatcher(ring, [&](std::span<const CanFrame> batch)
+        {
+            for (const CanFrame& frame : batch)
+            {
+                std::uint64_t sequence;
+                std::memcpy(&sequence, frame.data, sizeof(sequence));
+
+                std::int64_t& last = state.lastSequence[frame.id];
+                if (static_cast<std::int64_t>(sequence) <= last)
+                {
+                    ++state.orderErrors;
+                }
+                else if (static_cast<std::int64_t>(sequence) != last + 1)
+                {
+                    ++state.gaps;
+                }
+                last = static_cast<std::int64_t>(sequence);
+            }
+            state.received += batch.size();
+
+            if (consumerDelay.count() > 0)
+            {
+                BusyWait(consumerDelay);
+            }
+        });
+        dispatcher.Start();
+
+        std::atomic<bool> go{ false };
+        std::vector<std::thread> threads;
+        Stopwatch watch;
+        for (std::uint32_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]
+            {
+                FrameFanIn::Lane* lane = ring.AcquireLane();
+                while (!go.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                const auto paceStart = std::chrono::steady_clock::now();
+
+                // Odd producers push in batches to exercise PushBatch wrap-around.
+                if (p % 2 == 0)
+                {
+                    for (std::uint64_t s = 0; s < framesPerProducer; ++s)
+                    {
+                        lane->TryPush(MakeFrame(p, s));
+                        Pace(paceStart, producerPace, s + 1);
+                    }
+                }
+                else
+                {
+                    CanFrame batch[kProducerBatch];
+                    for (std::uint64_t s = 0; s < framesPerProducer; s += kProducerBatch)
+                    {
+                        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kProducerBatch, framesPerProducer - s));
+                        for (std::size_t i = 0; i < n; ++i)
+                        {
+                            batch[i] = MakeFrame(p, s + i);
+                        }
+                        lane->PushBatch(std::span<const CanFrame>(batch, n));
+                        Pace(paceStart, producerPace, s + n);
+                    }
+                }
+                ring.ReleaseLane(lane);
+            });
+        }
+
+        go.store(true, std::memory_order_release);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        dispatcher.Stop();
+        const double seconds = watch.ElapsedSeconds();
+
+        const RingStats stats = ring.Stats();
+        const std::uint64_t sent = static_cast<std::uint64_t>(producers) * framesPerProducer;
+
+        // DropOldest accepts every push and evicts queued frames; the other policies reject
+        // the incoming frame instead.
+        const std::uint64_t accepted = policy == OverflowPolicy::DropOldest ? sent : sent - stats.dropped;
+
+        bool ok = state.orderErrors == 0
+            && stats.enqueued == accepted
+            && stats.dequeued == state.received
+            && state.received + stats.dropped == sent;
+        if (policy == OverflowPolicy::Block)
+        {
+            ok = ok && stats.dropped == 0 && state.gaps == 0 && state.received == sent;
+        }
+        if (producerPace.count() > 0)
+        {
+            ok = ok && state.received * 100 >= sent * kPacedCheckedPercent;
+        }
+
+        std::printf(
+            "%-12s %s  %10.0f frames/s  recv %llu  dropped %llu  gaps %llu  order-errors %llu  high-water %zu/%zu  batches %llu\n",
+            PolicyName(policy),
+            ok ? "PASS" : "FAIL",
+            sent / seconds,
+            static_cast<unsigned long long>(state.received),
+            static_cast<unsigned long long>(stats.dropped),
+            static_cast<unsigned long long>(state.gaps),
+            static_cast<unsigned long long>(state.orderErrors),
+            stats.highWater,
+            laneCapacity,
+            static_cast<unsigned long long>(dispatcher.BatchesDelivered()));
+        return ok;
+    }
+}
+
+int GatewayCoreBench::RunRingStress(int argc, char** argv)
+{
+    const auto producers = static_cast<std::uint32_t>(argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 4);
+    const std::uint64_t framesPerProducer = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    const std::size_t laneCapacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1024;
+    const std::chrono::nanoseconds consumerDelay(argc > 3 ? std::strtoll(argv[3], nullptr, 10) : 0);
+    const std::chrono::nanoseconds producerPace(argc > 4 ? std::strtoll(argv[4], nullptr, 10) : 500);
+
+    if (producers == 0 || framesPerProducer == 0)
+    {
+        std::fprintf(stderr, "producers and framesPerProducer must be > 0\n");
+        return 1;
+    }
+
+    std::printf(
+        "ring-stress: %u producers x %llu frames, lane capacity %zu, consumer delay %lld ns/batch\n\n",
+        producers,
+        static_cast<unsigned long long>(framesPerProducer),
+        laneCapacity,
+        static_cast<long long>(consumerDelay.count()));
+
+    bool ok = true;
+    for (OverflowPolicy policy : { OverflowPolicy::DropOldest, OverflowPolicy::DropNewest, OverflowPolicy::Block })
+    {
+        ok = RunPolicy(policy, producers, framesPerProducer, laneCapacity, consumerDelay, std::chrono::nanoseconds(0)) && ok;
+    }
+
+    if (producerPace.count() > 0)
+    {
+        const std::uint64_t pacedFrames = std::min(framesPerProducer, kPacedFrames);
+        std::printf(
+            "\npaced: %llu frames per producer, one every %lld ns, at least %llu%% checked\n\n",
+            static_cast<unsigned long long>(pacedFrames),
+            static_cast<long long>(producerPace.count()),
+            static_cast<unsigned long long>(kPacedCheckedPercent));
+        for (OverflowPolicy policy : { OverflowPolicy::DropOldest, OverflowPolicy::DropNewest, OverflowPolicy::Block })
+        {
+            ok = RunPolicy(policy, producers, pacedFrames, laneCapacity, consumerDelay, producerPace) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+// Compiled CAN ID routing table.
+//
+// Usage: Gateway.Core.Bench route [frames] [rules]
+//
+// Registers `rules` random ID/range/mask rules (door ranges, exact 11- and 29-bit IDs,
+// extended ranges, J1939-style PGN and source-address masks) over 32 routes, then feeds
+// mixed 11/29-bit traffic at 100k frames/s of frame time.
+//
+// compile   time to build the tables
+// verify    compiled lookup against a linear scan of the rules, for traffic and random IDs
+// linear    the linear scan every subscriber would otherwise do, ns/frame
+// match     uncached table lookup, ns/frame
+// route     lookup through the extended-ID cache plus rate limiting/decimation, ns/frame
+// dispatch  route and gather into per-route spans, ns/frame
+// limits    delivered counts of the decimated and rate-limited routes
+
+#include "BenchSupport.h"
+
+#include "FrameRouter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace GatewayCore;
+using DoorCore::CanFrame;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::size_t kRoutes = 32;
+    constexpr std::int64_t kFrameSpacingTicks = 100; // 10 us: 100k frames/s
+    constexpr std::size_t kDecimatedRoute = 1;
+    constexpr std::uint32_t kDecimation = 10;
+    constexpr std::size_t kLimitedRoute = 2;
+    constexpr double kLimitRate = 100.0;
+    constexpr std::uint32_t kLimitBurst = 10;
+    /// Rule evaluations spent on each linear-scan phase, so large rule sets stay quick to run.
+    constexpr std::size_t kLinearBudget = 1'000'000'000;
+
+    class Rng
+    {
+    public:
+        explicit Rng(std::uint64_t seed)
+            : _state(seed)
+        {
+        }
+
+        std::uint32_t Next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return static_cast<std::uint32_t>(_state >> 16);
+        }
+
+        std::uint32_t Below(std::uint32_t bound)
+        {
+            return Next() % bound;
+        }
+
+    private:
+        std::uint64_t _state;
+    };
+
+    /// The rules as registered, for the linear-scan reference.
+    struct PlainRule
+    {
+        std::size_t route;
+        bool isMask;
+        bool extended;
+        std::uint32_t first;
+        std::uint32_t second;
+    };
+
+    RouteSet LinearMatch(const std::vector<PlainRule>& rules, std::uint32_t id)
+    {
+        RouteSet routes = 0;
+        const bool extended = id > DoorCore::kStandardIdMask;
+        for (const PlainRule& rule : rules)
+        {
+            const bool hit = rule.isMask
+                ? rule.extended == extended && (id & rule.second) == (rule.first & rule.second)
+                : id >= rule.first && id <= rule.second;
+            if (hit)
+            {
+                routes |= RouteSet{ 1 } << rule.route;
+            }
+        }
+        return routes;
+    }
+
+    struct Setup
+    {
+        std::vector<PlainRule> rules;
+        /// IDs seen on the simulated bus, roughly half of them subscribed.
+        std::vector<std::uint32_t> busIds;
+    };
+
+    bool Register(FrameRouter& router, std::size_t ruleCount, Setup& setup, std::string& error)
+    {
+        Rng rng(0x5EED'0007);
+
+        for (std::size_t route = 0; route < kRoutes; ++route)
+        {
+            RouteLimits limits;
+            if (route == kDecimatedRoute)
+            {
+                limits.decimation = kDecimation;
+            }
+            if (route == kLimitedRoute)
+            {
+                limits.maxFramesPerSecond = kLimitRate;
+                limits.burst = kLimitBurst;
+            }
+            std::size_t index = 0;
+            if (!router.AddRoute("route-" + std::to_string(route), limits, index, error))
+            {
+                return false;
+            }
+        }
+
+        auto add = [&](const PlainRule& rule) {
+            const bool ok = rule.isMask
+                ? router.AddMask(rule.route, rule.first, rule.second, rule.extended, error)
+                : rule.first == rule.second ? router.AddId(rule.route, rule.first, error) : router.AddRange(rule.route, rule.first, rule.second, error);
+            setup.rules.push_back(rule);
+            return ok;
+        };
+
+        // The door state consumers, including the limited routes.
+        for (std::size_t route = 0; route <= kLimitedRoute; ++route)
+        {
+            if (!add({ route, false, false, 0x200, 0x2FF }))
+            {
+                return false;
+            }
+        }
+        // J1939-style subscriptions: one PGN from any source, everything from one source.
+        if (!add({ 3, true, true, 0x18FEF100, 0x03FFFF00 }) || !add({ 4, true, true, 0x000000F9, 0xFF }) || !add({ 5, true, false, 0x100, 0x7F0 }))
+        {
+            return false;
+        }
+
+        for (std::size_t i = setup.rules.size(); i < ruleCount; ++i)
+        {
+            const std::size_t route = rng.Below(kRoutes);
+            const std::uint32_t kind = rng.Below(100);
+            PlainRule rule{ route, false, false, 0, 0 };
+            if (kind < 40)
+            {
+                rule.first = rule.second = 0x800 + rng.Below(DoorCore::kExtendedIdMask - 0x800);
+            }
+            else if (kind < 65)
+            {
+                rule.first = rule.second = rng.Below(DoorCore::kStandardIdMask + 1);
+            }
+            else if (kind < 80)
+            {
+                rule.first = rng.Below(DoorCore::kStandardIdMask + 1);
+                rule.second = std::min(DoorCore::kStandardIdMask, rule.first + rng.Below(16));
+            }
+            else if (kind < 95)
+            {
+                rule.first = 0x800 + rng.Below(DoorCore::kExtendedIdMask - 0x10000);
+                rule.second = rule.first + rng.Below(4096);
+            }
+            else
+            {
+                // A handful of distinct masks, as real filter sets have.
+                static constexpr std::uint32_t kMasks[] = { 0x03FFFF00, 0x1FFFFF00, 0x1FFF0000, 0xFF };
+                rule.isMask = true;
+                rule.extended = true;
+                rule.second = kMasks[rng.Below(4)];
+                rule.first = (0x800 + rng.Below(DoorCore::kExtendedIdMask - 0x800)) & rule.second;
+            }
+            if (!add(rule))
+            {
+                return false;
+            }
+        }
+
+        // Bus traffic: door frames, subscribed IDs and about as many foreign ones.
+        for (std::uint32_t door = 0; door < 64; ++door)
+        {
+            setup.busIds.push_back(0x200 + door);
+        }
+        for (std::size_t i = 0; i < 600; ++i)
+        {
+            const PlainRule& rule = setup.rules[rng.Below(static_cast<std::uint32_t>(setup.rules.size()))];
+            std::uint32_t id = rule.isMask ? rule.first | (rng.Next() & ~rule.second & (rule.extended ? DoorCore::kExtendedIdMask : DoorCore::kStandardIdMask)) : rule.first + rng.Below(rule.second - rule.first + 1);
+            if (rule.extended && id <= DoorCore::kStandardIdMask)
+            {
+                id |= 0x800;
+            }
+            setup.busIds.push_back(id);
+        }
+        for (std::size_t i = 0; i < 300; ++i)
+        {
+            setup.busIds.push_back(rng.Below(DoorCore::kStandardIdMask + 1));
+            setup.busIds.push_back(0x800 + rng.Below(DoorCore::kExtendedIdMask - 0x800));
+        }
+        return true;
+    }
+
+    std::vector<CanFrame> MakeTraffic(const Setup& setup, std::size_t frames, std::int64_t start)
+    {
+        Rng rng(0x7AFF1C);
+        std::vector<CanFrame> traffic(frames);
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            CanFrame& frame = traffic[i];
+            // Door frames are a third of the load, like the HMI bus.
+            frame.id = rng.Below(3) == 0 ? setup.busIds[rng.Below(64)] : setup.busIds[rng.Below(static_cast<std::uint32_t>(setup.busIds.size()))];
+            frame.dlc = 8;
+            frame.timestamp = start + static_cast<std::int64_t>(i) * kFrameSpacingTicks;
+        }
+        return traffic;
+    }
+
+    double NsPerFrame(const Stopwatch& watch, std::size_t frames)
+    {
+        return watch.ElapsedSeconds() * 1e9 / static_cast<double>(frames);
+    }
+}
+
+int GatewayCoreBench::RunRouteBench(int argc, char** argv)
+{
+    const std::size_t frames = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 10'000'000;
+    const std::size_t ruleCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5'000;
+    if (frames < 100'000 || ruleCount < 16)
+    {
+        std::fprintf(stderr, "frames must be >= 100000 and rules >= 16\n");
+        return 1;
+    }
+
+    FrameRouter router;
+    Setup setup;
+    std::string error;
+    if (!Register(router, ruleCount, setup, error))
+    {
+        std::printf("FAIL: %s\n", error.c_str());
+        return 1;
+    }
+
+    Stopwatch compileWatch;
+    router.Compile();
+    std::printf("route: %zu rules over %zu routes, %zu bus IDs, %zu frames\n\n", setup.rules.size(), kRoutes, setup.busIds.size(), frames);
+    std::printf("compile   %12.2f ms\n", compileWatch.ElapsedSeconds() * 1e3);
+
+    // verify
+    const std::size_t randomProbes = std::max<std::size_t>(kLinearBudget / setup.rules.size(), 10'000);
+    std::size_t wrong = 0;
+    Rng probe(0xC0FFEE);
+    for (std::size_t i = 0; i < setup.busIds.size() + randomProbes; ++i)
+    {
+        const std::uint32_t id = i < setup.busIds.size() ? setup.busIds[i] : (i & 1) != 0 ? probe.Below(DoorCore::kStandardIdMask + 1) : probe.Below(DoorCore::kExtendedIdMask + 1);
+        if (router.Match(id) != LinearMatch(setup.rules, id))
+        {
+            ++wrong;
+        }
+    }
+    std::printf("verify    %zu IDs against a linear scan: %zu mismatches  %s\n", setup.busIds.size() + randomProbes, wrong, wrong == 0 ? "PASS" : "FAIL");
+
+    const std::int64_t start = DoorCore::UtcNowTicks();
+    const std::vector<CanFrame> traffic = MakeTraffic(setup, frames, start);
+    std::size_t extended = 0;
+    for (const CanFrame& frame : traffic)
+    {
+        extended += frame.id > DoorCore::kStandardIdMask ? 1 : 0;
+    }
+
+    // linear (a slice; it is orders of magnitude slower)
+    const std::size_t linearFrames = std::min(frames, std::max<std::size_t>(kLinearBudget / setup.rules.size() / 10, 1'000));
+    RouteSet sink = 0;
+    Stopwatch linearWatch;
+    for (std::size_t i = 0; i < linearFrames; ++i)
+    {
+        sink ^= LinearMatch(setup.rules, traffic[i].id);
+    }
+    std::printf("linear    %12.1f ns/frame  (%zu frames, %.0f%% extended)\n", NsPerFrame(linearWatch, linearFrames), linearFrames, 100.0 * extended / frames);
+
+    Stopwatch matchWatch;
+    for (const CanFrame& frame : traffic)
+    {
+        sink ^= router.Match(frame.id);
+    }
+    std::printf("match     %12.1f ns/frame\n", NsPerFrame(matchWatch, frames));
+
+    Stopwatch routeWatch;
+    for (const CanFrame& frame : traffic)
+    {
+        sink ^= router.Route(frame);
+    }
+    const RouterStats routed = router.Stats();
+    std::printf("route     %12.1f ns/frame  %.0f%% unrouted  extended cache hit rate %.1f%%\n",
+        NsPerFrame(routeWatch, frames),
+        100.0 * routed.unrouted / routed.frames,
+        100.0 * routed.extendedCacheHits / std::max<std::uint64_t>(1, routed.extendedCacheHits + routed.extendedCacheMisses));
+
+    // dispatch, with fresh limiter state so the limits check below covers exactly one pass
+    router.Compile();
+    std::vector<RouteStats> before(kRoutes);
+    for (std::size_t route = 0; route < kRoutes; ++route)
+    {
+        before[route] = router.Stats(route);
+    }
+
+    std::vector<std::uint64_t> received(kRoutes);
+    std::uint64_t calls = 0;
+    const std::size_t batch = 256;
+    Stopwatch dispatchWatch;
+    for (std::size_t offset = 0; offset < frames; offset += batch)
+    {
+        router.Dispatch(std::span<const CanFrame>(traffic).subspan(offset, std::min(batch, frames - offset)), [&](std::size_t route, std::span<const CanFrame> routeFrames) {
+            received[route] += routeFrames.size();
+            ++calls;
+        });
+    }
+    std::printf("dispatch  %12.1f ns/frame  %.1f frames/call\n", NsPerFrame(dispatchWatch, frames), static_cast<double>(frames) / std::max<std::uint64_t>(calls, 1));
+
+    bool ok = wrong == 0;
+    for (std::size_t route = 0; route < kRoutes; ++route)
+    {
+        const RouteStats after = router.Stats(route);
+        if (after.delivered - before[route].delivered != received[route])
+        {
+            std::printf("dispatch  route %zu: stats say %llu delivered, sink got %llu  FAIL\n", route,
+                static_cast<unsigned long long>(after.delivered - before[route].delivered), static_cast<unsigned long long>(received[route]));
+            ok = false;
+        }
+    }
+
+    const RouteStats decimated = router.Stats(kDecimatedRoute);
+    const std::uint64_t decimatedMatched = decimated.matched - before[kDecimatedRoute].matched;
+    const bool decimationOk = received[kDecimatedRoute] == (decimatedMatched + kDecimation - 1) / kDecimation;
+    std::printf("limits    decimate 1/%u: %llu of %llu delivered  %s\n", kDecimation,
+        static_cast<unsigned long long>(received[kDecimatedRoute]),
+        static_cast<unsigned long long>(decimatedMatched),
+        decimationOk ? "PASS" : "FAIL");
+
+    const double span = static_cast<double>(traffic.back().timestamp - traffic.front().timestamp) / DoorCore::kTicksPerSecond;
+    const double allowed = kLimitBurst + kLimitRate * span;
+    const bool rateOk = received[kLimitedRoute] <= allowed + 1 && received[kLimitedRoute] + 1 >= allowed;
+    std::printf("limits    %.0f frames/s burst %u over %.1f s: %llu delivered (expected %.0f)  %s\n", kLimitRate, kLimitBurst, span,
+        static_cast<unsigned long long>(received[kLimitedRoute]), allowed, rateOk ? "PASS" : "FAIL");
+
+    // Keeps the timed lookups from being optimized away.
+    volatile RouteSet keep = sink;
+    (void)keep;
+
+    ok = ok && decimationOk && rateOk;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,520 @@
+// Binary trace recorder and replay engine.
+//
+// Usage: Gateway.Core.Bench trace [frames] [directory]
+//
+// record    encodes `frames` synthetic frames (door states, 8-byte process data, extended
+//           IDs) through TraceWriter; reports sustained frames/s, MB/s and file size
+// replay    maps the file and replays it flat out, unfiltered and filtered to door frames
+// seek      random binary-search seeks by timestamp
+// paced     replays a window at 1x and 10x; reports achieved duration and lateness
+// stop      stops a background replay that waits seconds for its next frame
+// quiet     appends a few frames and no more; the I/O thread must seal and write them
+// text      exports up to 1M frames to .asc and .trc, re-imports them and compares
+// recover   truncates a copy of the trace and checks the index is rebuilt
+// corrupt   damages index entries and block headers of a small trace (wrapping offsets,
+//           huge frame counts); the reader must fall back or stop at the bad block
+//
+// Pass e.g. 200000000 frames for a multi-GB (uncompressed) trace.
+
+#include "BenchSupport.h"
+
+#include "TraceReplayer.h"
+#include "TraceText.h"
+#include "TraceWriter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace GatewayCore;
+using DoorCore::CanFrame;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::size_t kRecordBatch = 256;
+    constexpr std::int64_t kFrameSpacingTicks = 100; // 10 us: ~100k frames/s aggregate
+    constexpr std::uint64_t kTextFrames = 1'000'000;
+    constexpr int kSeeks = 10'000;
+
+    /// Deterministic traffic mix; the same index always yields the same frame.
+    CanFrame MakeFrame(std::uint64_t index, std::int64_t start)
+    {
+        std::uint64_t x = index * 0x9E3779B97F4A7C15ULL;
+        x ^= x >> 29;
+
+        CanFrame frame{};
+        frame.timestamp = start + static_cast<std::int64_t>(index) * kFrameSpacingTicks + static_cast<std::int64_t>(x % 37);
+        const unsigned kind = static_cast<unsigned>(x % 10);
+        if (kind < 7)
+        {
+            const auto doorId = static_cast<std::uint8_t>(index % 64);
+            frame.id = 0x200 + doorId;
+            frame.dlc = 2;
+            frame.data[0] = doorId;
+            frame.data[1] = static_cast<std::uint8_t>((index / 4096 + doorId) % 3);
+        }
+        else if (kind < 9)
+        {
+            frame.id = 0x300 + static_cast<std::uint32_t>(index % 128);
+            frame.dlc = 8;
+            for (int b = 0; b < 8; ++b)
+            {
+                frame.data[b] = static_cast<std::uint8_t>(index >> (b * 3));
+            }
+        }
+        else
+        {
+            frame.id = 0x18FF0000u + static_cast<std::uint32_t>(index % 16);
+            frame.dlc = 8;
+            for (int b = 0; b < 8; ++b)
+            {
+                frame.data[b] = static_cast<std::uint8_t>(x >> (b * 8));
+            }
+        }
+        return frame;
+    }
+
+    std::uint64_t Mix(std::uint64_t hash, const CanFrame& frame)
+    {
+        std::uint64_t value = frame.id ^ (static_cast<std::uint64_t>(frame.dlc) << 32) ^ static_cast<std::uint64_t>(frame.timestamp);
+        for (std::uint8_t b = 0; b < frame.dlc; ++b)
+        {
+            value = value * 31 + frame.data[b];
+        }
+        return (hash ^ value) * 0x100000001B3ULL;
+    }
+
+    bool SameFrame(const CanFrame& a, const CanFrame& b, std::int64_t toleranceTicks)
+    {
+        return a.id == b.id
+            && a.dlc == b.dlc
+            && std::equal(a.data, a.data + a.dlc, b.data)
+            && std::llabs(a.timestamp - b.timestamp) <= toleranceTicks;
+    }
+
+    struct Recorded
+    {
+        std::uint64_t frames;
+        std::int64_t start;
+        std::uint64_t hash;
+    };
+
+    bool Record(const std::string& path, std::uint64_t frames, std::int64_t start, Recorded& recorded)
+    {
+        TraceWriter writer;
+        std::string error;
+        if (!writer.Open(path, {}, error))
+        {
+            std::printf("FAIL: %s\n", error.c_str());
+            return false;
+        }
+
+        std::vector<CanFrame> batch(kRecordBatch);
+        std::uint64_t hash = 0;
+        Stopwatch watch;
+        for (std::uint64_t i = 0; i < frames; i += kRecordBatch)
+        {
+            const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kRecordBatch, frames - i));
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                batch[k] = MakeFrame(i + k, start);
+                hash = Mix(hash, batch[k]);
+            }
+            writer.AppendBatch(std::span<const CanFrame>(batch.data(), n));
+        }
+        if (!writer.Close(error))
+        {
+            std::printf("FAIL: %s\n", error.c_str());
+            return false;
+        }
+        const double seconds = watch.ElapsedSeconds();
+
+        const TraceWriterStats stats = writer.Stats();
+        std::printf("record    %12.0f frames/s  %8.1f MB/s (24-byte frames)  %8.1f MB/s to disk  file %.1f MB  %.2f bytes/frame  %llu blocks  %llu stalls\n",
+            frames / seconds,
+            frames * sizeof(CanFrame) / seconds / 1e6,
+            stats.bytesWritten / seconds / 1e6,
+            stats.bytesWritten / 1e6,
+            static_cast<double>(stats.bytesWritten) / static_cast<double>(frames),
+            static_cast<unsigned long long>(stats.blocks),
+            static_cast<unsigned long long>(stats.stalls));
+
+        recorded = { frames, start, hash };
+        return true;
+    }
+
+    bool ReplayMax(const TraceReader& reader, const Recorded& recorded)
+    {
+        TraceReplayer replayer(reader);
+        TraceReplayOptions options;
+        options.speed = 0;
+        options.maxBatch = 1024;
+
+        std::uint64_t hash = 0;
+        const TraceReplayStats all = replayer.Run(options, [&](std::span<const CanFrame> frames)
+        {
+            for (const CanFrame& frame : frames)
+            {
+                hash = Mix(hash, frame);
+            }
+        });
+        const bool intact = all.frames == recorded.frames && hash == recorded.hash;
+        std::printf("replay    %12.0f frames/s  %8.1f MB/s (24-byte frames)  %llu frames  %s\n",
+            all.frames / all.seconds,
+            all.frames * sizeof(CanFrame) / all.seconds / 1e6,
+            static_cast<unsigned long long>(all.frames),
+            intact ? "content identical" : "FAIL: content differs");
+
+        options.filter.AllowRange(0x200, 0x2FF);
+        std::uint64_t doorFrames = 0;
+        const TraceReplayStats filtered = replayer.Run(options, [&](std::span<const CanFrame> frames)
+        {
+            for (const CanFrame& frame : frames)
+            {
+                doorFrames += (frame.id & 0xF00) == 0x200 ? 1 : 0;
+            }
+        });
+        const bool filterOk = doorFrames == filtered.frames;
+        std::printf("replay    %12.0f frames/s  filtered to 0x200-0x2FF: %llu frames (%.0f%%)  %s\n",
+            filtered.frames / filtered.seconds,
+            static_cast<unsigned long long>(filtered.frames),
+            100.0 * filtered.frames / static_cast<double>(recorded.frames),
+            filterOk ? "" : "FAIL: foreign IDs");
+        return intact && filterOk;
+    }
+
+    bool Seek(const TraceReader& reader, const Recorded& recorded)
+    {
+        TraceCursor cursor(reader);
+        CanFrame frame{};
+        std::uint64_t rng = 12345;
+        int wrong = 0;
+
+        Stopwatch watch;
+        for (int i = 0; i < kSeeks; ++i)
+        {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            const std::uint64_t index = (rng >> 16) % recorded.frames;
+            const std::int64_t target = recorded.start + static_cast<std::int64_t>(index) * kFrameSpacingTicks;
+            cursor.Seek(target);
+            if (cursor.Read({ &frame, 1 }) == 1 && frame.timestamp < target)
+            {
+                ++wrong;
+            }
+        }
+        const double seconds = watch.ElapsedSeconds();
+
+        std::printf("seek      %12.2f us/seek (decode one block each)  %s\n",
+            seconds * 1e6 / kSeeks,
+            wrong == 0 ? "all positioned at or after target" : "FAIL: landed before target");
+        return wrong == 0;
+    }
+
+    void Paced(const TraceReader& reader, const Recorded& recorded)
+    {
+        for (double speed : { 1.0, 10.0 })
+        {
+            TraceReplayer replayer(reader);
+            TraceReplayOptions options;
+            options.speed = speed;
+            options.startTicks = recorded.start + (recorded.frames / 4) * kFrameSpacingTicks;
+            options.endTicks = options.startTicks + static_cast<std::int64_t>(speed * 0.25 * DoorCore::kTicksPerSecond);
+
+            const TraceReplayStats stats = replayer.Run(options, [](std::span<const CanFrame>) {});
+            const double expected = static_cast<double>(options.endTicks - options.startTicks) / DoorCore::kTicksPerSecond / speed;
+            std::printf("paced     %4.0fx  %8llu frames in %6.3f s (trace window / speed = %.3f s)  %6.1f frames/batch  max late %llu us\n",
+                speed,
+                static_cast<unsigned long long>(stats.frames),
+                stats.seconds,
+                expected,
+                stats.batches == 0 ? 0.0 : static_cast<double>(stats.frames) / stats.batches,
+                static_cast<unsigned long long>(stats.maxLateMicros));
+        }
+    }
+
+    bool StopWhileWaiting(const TraceReader& reader, const Recorded& recorded)
+    {
+        // 10 us frame spacing at a millionth of real time: 10 s between frames.
+        TraceReplayer replayer(reader);
+        TraceReplayOptions options;
+        options.speed = 1e-6;
+        options.startTicks = recorded.start;
+
+        replayer.Start(options, [](std::span<const CanFrame>) {});
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Stopwatch watch;
+        replayer.Stop();
+        const double seconds = watch.ElapsedSeconds();
+
+        const TraceReplayStats stats = replayer.LastStats();
+        const bool ok = seconds < 0.5 && !replayer.IsRunning() && stats.frames <= 1;
+        std::printf("stop      %12.2f ms to stop a replay waiting for its next frame  %llu frames sent  %s\n",
+            seconds * 1e3,
+            static_cast<unsigned long long>(stats.frames),
+            ok ? "" : "FAIL");
+        return ok;
+    }
+
+    bool QuietBus(const std::string& directory)
+    {
+        const std::string path = directory + "/trace-bench-quiet.rtrc";
+        TraceWriter writer;
+        std::string error;
+        const bool refused = !writer.Append(MakeFrame(0, 0));
+
+        TraceWriterOptions options;
+        options.maxBlockSpanTicks = DoorCore::kTicksPerSecond / 10;
+        if (!writer.Open(path, options, error))
+        {
+            std::printf("FAIL: %s\n", error.c_str());
+            return false;
+        }
+        const std::int64_t start = DoorCore::UtcNowTicks();
+        for (std::uint64_t i = 0; i < 10; ++i)
+        {
+            writer.Append(MakeFrame(i, start));
+        }
+
+        // No Flush: the block must be sealed by the I/O thread within about two spans.
+        Stopwatch watch;
+        while (writer.Stats().blocks == 0 && watch.ElapsedSeconds() < 2)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        const double seconds = watch.ElapsedSeconds();
+        const bool written = writer.Stats().blocks == 1;
+        writer.Close(error);
+        std::filesystem::remove(path);
+
+        const bool ok = refused && written && seconds < 0.5;
+        std::printf("quiet     %12.2f ms until 10 frames reached the disk (block span 100 ms)  append before open %s  %s\n",
+            seconds * 1e3,
+            refused ? "refused" : "accepted",
+            ok ? "" : "FAIL");
+        return ok;
+    }
+
+    bool TextRoundTrip(const std::string& directory, const Recorded& recorded)
+    {
+        const std::uint64_t frames = std::min(recorded.frames, kTextFrames);
+        const std::string small = directory + "/trace-bench-text.rtrc";
+        {
+            TraceWriter writer;
+            std::string error;
+            writer.Open(small, {}, error);
+            for (std::uint64_t i = 0; i < frames; ++i)
+            {
+                writer.Append(MakeFrame(i, recorded.start));
+            }
+            writer.Close(error);
+        }
+
+        TraceReader reader;
+        std::string error;
+        if (!reader.Open(small, error))
+        {
+            std::printf("FAIL: %s\n", error.c_str());
+            return false;
+        }
+
+        bool ok = true;
+        for (TraceText::Format format : { TraceText::Format::Asc, TraceText::Format::Trc })
+        {
+            const bool asc = format == TraceText::Format::Asc;
+            const std::string path = directory + (asc ? "/trace-bench.asc" : "/trace-bench.trc");
+
+            std::uint64_t exported = 0;
+            Stopwatch exportWatch;
+            if (!TraceText::Export(reader, path, format, {}, exported, error))
+            {
+                std::printf("FAIL: %s\n", error.c_str());
+                return false;
+            }
+            const double exportSeconds = exportWatch.ElapsedSeconds();
+
+            std::uint64_t index = 0;
+            std::uint64_t mismatches = 0;
+            TraceText::ImportResult result;
+            Stopwatch importWatch;
+            const bool imported = TraceText::Import(path, format, [&](std::span<const CanFrame> batch)
+            {
+                for (const CanFrame& frame : batch)
+                {
+                    // .asc keeps microseconds, .trc (ms with 3 decimals) as well.
+                    mismatches += SameFrame(frame, MakeFrame(index++, recorded.start), 10) ? 0 : 1;
+                }
+            }, result, error);
+            const double importSeconds = importWatch.ElapsedSeconds();
+
+            const bool match = imported && result.frames == frames && mismatches == 0;
+            ok = ok && match;
+            std::printf("text      %s  export %10.0f frames/s  import %10.0f frames/s  %.1f MB  %llu skipped  %s\n",
+                asc ? ".asc" : ".trc",
+                exported / exportSeconds,
+                result.frames / importSeconds,
+                static_cast<double>(std::filesystem::file_size(path)) / 1e6,
+                static_cast<unsigned long long>(result.skipped),
+                match ? "round trip identical" : "FAIL: round trip differs");
+            std::filesystem::remove(path);
+        }
+
+        reader.Close();
+        std::filesystem::remove(small);
+        return ok;
+    }
+
+    bool Recover(const TraceReader& original, const std::string& path, const std::string& directory, const Recorded& recorded)
+    {
+        // A recorder killed mid-run leaves no index/trailer and a partial last block: cut the
+        // copy in the middle of a block (at most 8 MB in).
+        const std::string copy = directory + "/trace-bench-crashed.rtrc";
+        const TraceFormat::IndexEntry& last = original.Block(original.BlockCount() - 1);
+        const std::uint64_t keep = std::min<std::uint64_t>(last.offset + sizeof(TraceFormat::BlockHeader) + last.payloadBytes / 2, 8u << 20);
+        std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::resize_file(copy, keep);
+
+        TraceReader reader;
+        std::string error;
+        const bool opened = reader.Open(copy, error);
+        const bool ok = opened && reader.Recovered() && reader.FrameCount() > 0 && reader.FrameCount() < recorded.frames;
+        std::printf("recover   truncated copy (%.1f MB): index rebuilt from %zu blocks, %llu frames readable  %s\n",
+            keep / 1e6,
+            reader.BlockCount(),
+            static_cast<unsigned long long>(reader.FrameCount()),
+            ok ? "" : "FAIL");
+        reader.Close();
+        std::filesystem::remove(copy);
+        return ok;
+    }
+
+    bool Corrupt(const std::string& directory, const Recorded& recorded)
+    {
+        const std::string path = directory + "/trace-bench-corrupt.rtrc";
+        {
+            TraceWriter writer;
+            std::string error;
+            writer.Open(path, {}, error);
+            for (std::uint64_t i = 0; i < kTextFrames; ++i)
+            {
+                writer.Append(MakeFrame(i, recorded.start));
+            }
+            writer.Close(error);
+        }
+
+        std::vector<std::uint8_t> clean;
+        {
+            std::ifstream in(path, std::ios::binary);
+            clean.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        TraceFormat::Trailer trailer{};
+        std::memcpy(&trailer, clean.data() + clean.size() - sizeof(trailer), sizeof(trailer));
+        TraceFormat::IndexEntry first{};
+        TraceFormat::IndexEntry second{};
+        std::memcpy(&first, clean.data() + trailer.indexOffset, sizeof(first));
+        std::memcpy(&second, clean.data() + trailer.indexOffset + sizeof(first), sizeof(second));
+
+        // Writes a damaged copy, reopens it and reports what the reader made of it.
+        auto check = [&](const char* what, std::size_t at, const auto& value, std::size_t keep, bool wholeTrace)
+        {
+            std::vector<std::uint8_t> bytes(clean.begin(), clean.begin() + static_cast<std::ptrdiff_t>(keep));
+            std::memcpy(bytes.data() + at, &value, sizeof(value));
+            {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            }
+
+            TraceReader reader;
+            std::string error;
+            const bool opened = reader.Open(path, error);
+            std::uint64_t read = 0;
+            if (opened)
+            {
+                TraceCursor cursor(reader);
+                std::vector<CanFrame> out(4096);
+                for (std::size_t n; (n = cursor.Read(out)) != 0;)
+                {
+                    read += n;
+                }
+            }
+
+            // Whole trace: the index is rebuilt from the intact block headers. Otherwise the
+            // walk stops at the damaged second block and keeps the first.
+            const std::uint64_t expected = wholeTrace ? kTextFrames : first.frameCount;
+            const bool ok = opened && reader.Recovered() && read == expected
+                && reader.MaxBlockFrames() * TraceFormat::kMinEncodedFrame <= clean.size();
+            std::printf("corrupt   %-30s index rebuilt from %zu blocks, %llu frames read, max %zu frames/block  %s\n",
+                what,
+                reader.BlockCount(),
+                static_cast<unsigned long long>(read),
+                reader.MaxBlockFrames(),
+                ok ? "" : "FAIL");
+            return ok;
+        };
+
+        const std::size_t entryOffset = trailer.indexOffset + sizeof(TraceFormat::IndexEntry) + offsetof(TraceFormat::IndexEntry, offset);
+        const std::size_t entryFrames = trailer.indexOffset + sizeof(TraceFormat::IndexEntry) + offsetof(TraceFormat::IndexEntry, frameCount);
+        const std::size_t headerFrames = second.offset + offsetof(TraceFormat::BlockHeader, frameCount);
+        bool ok = check("index offset wraps", entryOffset, ~std::uint64_t{ 0 } - 16, clean.size(), true);
+        ok = check("index frame count 2^32-1", entryFrames, ~std::uint32_t{ 0 }, clean.size(), true) && ok;
+        ok = check("header frame count, no index", headerFrames, ~std::uint32_t{ 0 }, trailer.indexOffset, false) && ok;
+
+        std::filesystem::remove(path);
+        return ok;
+    }
+}
+
+int GatewayCoreBench::RunTraceBench(int argc, char** argv)
+{
+    const std::uint64_t frames = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 20'000'000;
+    const std::string directory = argc > 1 ? argv[1] : std::filesystem::temp_directory_path().string();
+    if (frames < 100'000)
+    {
+        std::fprintf(stderr, "frames must be >= 100000\n");
+        return 1;
+    }
+
+    const std::string path = directory + "/trace-bench.rtrc";
+    std::printf("trace: %llu frames (%.2f GB as 24-byte frames) in %s\n\n",
+        static_cast<unsigned long long>(frames),
+        frames * sizeof(CanFrame) / 1e9,
+        path.c_str());
+
+    Recorded recorded{};
+    const std::int64_t start = DoorCore::UtcNowTicks();
+    if (!Record(path, frames, start, recorded))
+    {
+        return 1;
+    }
+
+    TraceReader reader;
+    std::string error;
+    Stopwatch openWatch;
+    if (!reader.Open(path, error))
+    {
+        std::printf("FAIL: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("open      %12.2f ms  %zu blocks indexed\n", openWatch.ElapsedSeconds() * 1e3, reader.BlockCount());
+
+    bool ok = ReplayMax(reader, recorded);
+    ok = Seek(reader, recorded) && ok;
+    Paced(reader, recorded);
+    ok = StopWhileWaiting(reader, recorded) && ok;
+    ok = QuietBus(directory) && ok;
+    ok = TextRoundTrip(directory, recorded) && ok;
+    ok = Recover(reader, path, directory, recorded) && ok;
+    ok = Corrupt(directory, recorded) && ok;
+
+    reader.Close();
+    std::filesystem::remove(path);
+    return ok ? 0 : 1;
+}
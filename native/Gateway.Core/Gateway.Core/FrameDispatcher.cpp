@@ -0,0 +1,89 @@
+#include "pch.h"
+
+#include "FrameDispatcher.h"
+
+#include <chrono>
+#include <utility>
+
+namespace GatewayCore
+{
+    namespace
+    {
+        // Idle strategy: spin, then yield, then sleep, so a busy bus is served with low
+        // latency while an idle one costs almost no CPU.
+        constexpr std::uint32_t kSpinRounds = 64;
+        constexpr std::uint32_t kYieldRounds = 128;
+        constexpr auto kIdleSleep = std::chrono::microseconds(200);
+    }
+
+    FrameDispatcher::FrameDispatcher(FrameFanIn& ring, BatchHandler handler, std::size_t maxBatch)
+        : _ring(ring)
+        , _handler(std::move(handler))
+        , _batch(maxBatch == 0 ? 1 : maxBatch)
+    {
+    }
+
+    FrameDispatcher::~FrameDispatcher()
+    {
+        Stop();
+    }
+
+    void FrameDispatcher::Start()
+    {
+        if (_worker.joinable())
+        {
+            return;
+        }
+
+        _stopping.store(false, std::memory_order_relaxed);
+        _worker = std::thread([this] { Run(); });
+    }
+
+    void FrameDispatcher::Stop()
+    {
+        if (!_worker.joinable())
+        {
+            return;
+        }
+
+        _stopping.store(true, std::memory_order_release);
+        _worker.join();
+    }
+
+    void FrameDispatcher::Run()
+    {
+        std::uint32_t idle = 0;
+        for (;;)
+        {
+            // Sample the stop flag before draining so frames pushed before Stop() are
+            // always delivered.
+            const bool stopping = _stopping.load(std::memory_order_acquire);
+
+            const std::size_t count = _ring.Drain(_batch);
+            if (count != 0)
+            {
+                idle = 0;
+                _handler(std::span<const DoorCore::CanFrame>(_batch.data(), count));
+                _batches.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (stopping)
+            {
+                return;
+            }
+
+            ++idle;
+            if (idle < kSpinRounds)
+            {
+                continue;
+            }
+            if (idle < kSpinRounds + kYieldRounds)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "FrameRing.h"
+
+namespace GatewayCore
+{
+    /// <summary>
+    /// Drains a fan-in ring on its own thread and hands frames to a consumer in batches.
+    /// </summary>
+    /// <remarks>
+    /// Replaces the per-frame synchronous FrameReceived invocation on the pipe thread: read
+    /// loops only push into their lane, and a slow handler backs up the ring (subject to its
+    /// overflow policy) instead of stalling the transport.
+    /// </remarks>
+    class FrameDispatcher
+    {
+    public:
+        using BatchHandler = std::function<void(std::span<const DoorCore::CanFrame>)>;
+
+        FrameDispatcher(FrameFanIn& ring, BatchHandler handler, std::size_t maxBatch = 256);
+        ~FrameDispatcher();
+
+        FrameDispatcher(const FrameDispatcher&) = delete;
+        FrameDispatcher& operator=(const FrameDispatcher&) = delete;
+
+        void Start();
+
+        /// Stops the worker after delivering whatever is already queued.
+        void Stop();
+
+        std::uint64_t BatchesDelivered() const { return _batches.load(std::memory_order_relaxed); }
+
+    private:
+        void Run();
+
+        FrameFanIn& _ring;
+        BatchHandler _handler;
+        std::vector<DoorCore::CanFrame> _batch;
+        std::atomic<bool> _stopping{ false };
+        std::atomic<std::uint64_t> _batches{ 0 };
+        std::thread _worker;
+    };
+}
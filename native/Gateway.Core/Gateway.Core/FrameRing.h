@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "CanFrame.h"
+#include "Primitives.h"
+
+namespace GatewayCore
+{
+    /// <summary>
+    /// What a producer does when its ring is full.
+    /// </summary>
+    enum class OverflowPolicy
+    {
+        /// Discard the oldest unread item to make room (latest state wins).
+        DropOldest,
+        /// Discard the item being pushed.
+        DropNewest,
+        /// Wait until the consumer frees a slot or the ring is closed.
+        Block
+    };
+
+    /// <summary>
+    /// Point-in-time counters of a ring (or the sum over all lanes of a fan-in ring).
+    /// </summary>
+    struct RingStats
+    {
+        std::uint64_t enqueued = 0;
+        std::uint64_t dequeued = 0;
+        std::uint64_t dropped = 0;
+        /// Highest occupancy observed by the producer(s).
+        std::size_t highWater = 0;
+        std::size_t capacity = 0;
+    };
+
+    namespace Detail
+    {
+        constexpr std::size_t kCacheLine = 64;
+
+        constexpr std::size_t RoundUpPow2(std::size_t value)
+        {
+            std::size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        /// Spin briefly, then yield the time slice.
+        inline void Backoff(std::uint32_t& spins)
+        {
+            if (++spins < 64)
+            {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    /// <summary>
+    /// Bounded lock-free single-producer/single-consumer ring of trivially copyable items.
+    /// </summary>
+    /// <remarks>
+    /// Storage is allocated once in the constructor; push and drain never allocate.
+    /// Cursors are free-running 64-bit counters on separate cache lines, and each side keeps
+    /// a cached copy of the other's cursor so the shared line is only touched when the
+    /// cached value says the ring looks full/empty.
+    ///
+    /// With DropOldest the producer may advance the read cursor itself and overwrite a slot
+    /// the consumer is still copying. The consumer therefore copies items out first and
+    /// commits with a CAS on the read cursor; if the producer dropped items in the meantime
+    /// the CAS fails and the (possibly torn) copy is discarded, seqlock style. Under that
+    /// policy slots are copied as relaxed atomic 64-bit words so the overlap is a benign
+    /// race rather than undefined behaviour; the other policies never write an unread slot
+    /// and keep plain memcpy.
+    /// </remarks>
+    template <typename T>
+    class SpscRing
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "SpscRing holds POD items only");
+        static_assert(sizeof(T) % sizeof(std::uint64_t) == 0, "SpscRing copies items as 64-bit words");
+        static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free, "slot words must be lock-free");
+
+    public:
+        explicit SpscRing(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::DropNewest)
+            : _capacity(Detail::RoundUpPow2(std::max<std::size_t>(capacity, 2)))
+            , _mask(_capacity - 1)
+            , _policy(policy)
+            , _slots(new std::uint64_t[_capacity * kSlotWords])
+        {
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        std::size_t Capacity() const { return _capacity; }
+        OverflowPolicy Policy() const { return _policy; }
+
+        /// Producer: pushes one item. Returns false if the item was dropped (DropNewest) or
+        /// the ring was closed while blocked (Block).
+        bool TryPush(const T& item)
+        {
+            const std::uint64_t write = _write.load(std::memory_order_relaxed);
+            if (!ReserveSlot(write))
+            {
+                return false;
+            }
+
+            CopyIn(write, std::span<const T>(&item, 1));
+            _write.store(write + 1, std::memory_order_release);
+            CommitPush(write + 1, 1);
+            return true;
+        }
+
+        /// Producer: pushes a contiguous batch with a single cursor publish per run of free
+        /// slots. Returns the number of items accepted.
+        std::size_t PushBatch(std::span<const T> items)
+        {
+            std::size_t accepted = 0;
+            while (accepted < items.size())
+            {
+                const std::uint64_t write = _write.load(std::memory_order_relaxed);
+                if (!ReserveSlot(write))
+                {
+                    // ReserveSlot counted the current item; the rest of the batch goes too.
+                    DoorCore::Bump(_dropped, items.size() - accepted - 1);
+                    break;
+                }
+
+                const std::size_t free = _capacity - static_cast<std::size_t>(write - _cachedRead);
+                const std::size_t count = std::min(free, items.size() - accepted);
+                CopyIn(write, items.subspan(accepted, count));
+                _write.store(write + count, std::memory_order_release);
+                CommitPush(write + count, count);
+                accepted += count;
+            }
+            return accepted;
+        }
+
+        /// Consumer: moves up to out.size() items into out, oldest first.
+        std::size_t Drain(std::span<T> out)
+        {
+            if (out.empty())
+            {
+                return 0;
+            }
+
+            std::uint64_t read = _read.load(std::memory_order_acquire);
+            for (;;)
+            {
+                const std::uint64_t write = _write.load(std::memory_order_acquire);
+                const std::size_t available = static_cast<std::size_t>(std::min<std::uint64_t>(write - read, _capacity));
+                const std::size_t count = std::min(available, out.size());
+                if (count == 0)
+                {
+                    return 0;
+                }
+
+                CopyOut(read, out.first(count));
+
+                if (_policy != OverflowPolicy::DropOldest)
+                {
+                    _read.store(read + count, std::memory_order_release);
+                }
+                else if (!_read.compare_exchange_strong(read, read + count, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    // The producer dropped items under us; `read` now holds the new cursor.
+                    continue;
+                }
+
+                DoorCore::Bump(_dequeued, count);
+                return count;
+            }
+        }
+
+        /// Number of unread items (approximate while producer/consumer are active).
+        std::size_t Size() const
+        {
+            const std::uint64_t read = _read.load(std::memory_order_acquire);
+            const std::uint64_t write = _write.load(std::memory_order_acquire);
+            return static_cast<std::size_t>(std::min<std::uint64_t>(write - read, _capacity));
+        }
+
+        /// Releases producers waiting under the Block policy; later pushes on a full ring fail.
+        void Close() { _closed.store(true, std::memory_order_release); }
+
+        /// Re-opens a closed ring (used when a fan-in lane is handed to a new producer).
+        void Reopen() { _closed.store(false, std::memory_order_release); }
+
+        RingStats Stats() const
+        {
+            RingStats stats;
+            stats.enqueued = _enqueued.load(std::memory_order_relaxed);
+            stats.dequeued = _dequeued.load(std::memory_order_relaxed);
+            stats.dropped = _dropped.load(std::memory_order_relaxed);
+            stats.highWater = _highWater.load(std::memory_order_relaxed);
+            stats.capacity = _capacity;
+            return stats;
+        }
+
+    private:
+        static constexpr std::uint64_t kSampleInterval = 64;
+        static constexpr std::size_t kSlotWords = sizeof(T) / sizeof(std::uint64_t);
+
+        /// Ensures slot `write` is free, applying the overflow policy. Returns false if the
+        /// push must be abandoned.
+        bool ReserveSlot(std::uint64_t write)
+        {
+            if (write - _cachedRead < _capacity)
+            {
+                return true;
+            }
+
+            std::uint32_t spins = 0;
+            for (;;)
+            {
+                _cachedRead = _read.load(std::memory_order_acquire);
+                if (write - _cachedRead < _capacity)
+                {
+                    return true;
+                }
+
+                _highWater.store(_capacity, std::memory_order_relaxed);
+
+                switch (_policy)
+                {
+                case OverflowPolicy::DropNewest:
+                    DoorCore::Bump(_dropped, 1);
+                    return false;
+
+                case OverflowPolicy::DropOldest:
+                {
+                    std::uint64_t expected = _cachedRead;
+                    if (_read.compare_exchange_strong(expected, expected + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        _cachedRead = expected + 1;
+                        DoorCore::Bump(_dropped, 1);
+                        return true;
+                    }
+                    break;
+                }
+
+                case OverflowPolicy::Block:
+                    if (_closed.load(std::memory_order_acquire))
+                    {
+                        DoorCore::Bump(_dropped, 1);
+                        return false;
+                    }
+                    Detail::Backoff(spins);
+                    break;
+                }
+            }
+        }
+
+        void CommitPush(std::uint64_t newWrite, std::size_t count)
+        {
+            DoorCore::Bump(_enqueued, count);
+
+            // The cached read cursor lags behind, so occupancy is sampled against the real one
+            // every kSampleInterval items rather than touching the consumer's line per push.
+            if (((newWrite - count) ^ newWrite) >= kSampleInterval || count >= kSampleInterval)
+            {
+                _cachedRead = _read.load(std::memory_order_acquire);
+                const auto occupancy = static_cast<std::size_t>(std::min<std::uint64_t>(newWrite - _cachedRead, _capacity));
+                if (occupancy > _highWater.load(std::memory_order_relaxed))
+                {
+                    _highWater.store(occupancy, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void CopyIn(std::uint64_t position, std::span<const T> items)
+        {
+            const std::size_t start = static_cast<std::size_t>(position & _mask);
+            const std::size_t first = std::min(items.size(), _capacity - start);
+            if (_policy != OverflowPolicy::DropOldest)
+            {
+                std::memcpy(&_slots[start * kSlotWords], items.data(), first * sizeof(T));
+                std::memcpy(&_slots[0], items.data() + first, (items.size() - first) * sizeof(T));
+                return;
+            }
+
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                std::uint64_t words[kSlotWords];
+                std::memcpy(words, &items[i], sizeof(T));
+                std::uint64_t* slot = &_slots[((start + i) & _mask) * kSlotWords];
+                for (std::size_t w = 0; w < kSlotWords; ++w)
+                {
+                    std::atomic_ref<std::uint64_t>(slot[w]).store(words[w], std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void CopyOut(std::uint64_t position, std::span<T> out) const
+        {
+            const std::size_t start = static_cast<std::size_t>(position & _mask);
+            const std::size_t first = std::min(out.size(), _capacity - start);
+            if (_policy != OverflowPolicy::DropOldest)
+            {
+                std::memcpy(out.data(), &_slots[start * kSlotWords], first * sizeof(T));
+                std::memcpy(out.data() + first, &_slots[0], (out.size() - first) * sizeof(T));
+                return;
+            }
+
+            for (std::size_t i = 0; i < out.size(); ++i)
+            {
+                std::uint64_t words[kSlotWords];
+                std::uint64_t* slot = &_slots[((start + i) & _mask) * kSlotWords];
+                for (std::size_t w = 0; w < kSlotWords; ++w)
+                {
+                    words[w] = std::atomic_ref<std::uint64_t>(slot[w]).load(std::memory_order_relaxed);
+                }
+                std::memcpy(&out[i], words, sizeof(T));
+            }
+        }
+
+        const std::size_t _capacity;
+        const std::size_t _mask;
+        const OverflowPolicy _policy;
+        /// kSlotWords words per item, so DropOldest can copy slots with atomic_ref.
+        const std::unique_ptr<std::uint64_t[]> _slots;
+
+        // Producer-owned line.
+        alignas(Detail::kCacheLine) std::atomic<std::uint64_t> _write{ 0 };
+        std::uint64_t _cachedRead = 0;
+        std::atomic<std::uint64_t> _enqueued{ 0 };
+        std::atomic<std::uint64_t> _dropped{ 0 };
+        std::atomic<std::size_t> _highWater{ 0 };
+        std::atomic<bool> _closed{ false };
+
+        // Consumer-owned line.
+        alignas(Detail::kCacheLine) std::atomic<std::uint64_t> _read{ 0 };
+        std::atomic<std::uint64_t> _dequeued{ 0 };
+    };
+
+    /// <summary>
+    /// Multi-producer fan-in built from one SPSC lane per producer and a single consumer.
+    /// </summary>
+    /// <remarks>
+    /// Each pipe/socket read loop acquires its own lane, so producers never contend on a
+    /// shared cursor and ordering per producer is preserved. The consumer drains lanes
+    /// round-robin, rotating its starting lane on each call so a busy lane cannot starve the
+    /// others.
+    /// </remarks>
+    template <typename T>
+    class FanInRing
+    {
+    public:
+        using Lane = SpscRing<T>;
+
+        FanInRing(std::size_t maxProducers, std::size_t laneCapacity, OverflowPolicy policy = OverflowPolicy::DropNewest)
+            : _inUse(maxProducers)
+        {
+            _lanes.reserve(maxProducers);
+            for (std::size_t i = 0; i < maxProducers; ++i)
+            {
+                _lanes.push_back(std::make_unique<Lane>(laneCapacity, policy));
+            }
+        }
+
+        FanInRing(const FanInRing&) = delete;
+        FanInRing& operator=(const FanInRing&) = delete;
+
+        std::size_t MaxProducers() const { return _lanes.size(); }
+
+        /// Claims a free lane for a new producer, or returns nullptr if all are taken.
+        Lane* AcquireLane()
+        {
+            for (std::size_t i = 0; i < _lanes.size(); ++i)
+            {
+                bool expected = false;
+                if (_inUse[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    _lanes[i]->Reopen();
+                    return _lanes[i].get();
+                }
+            }
+            return nullptr;
+        }
+
+        /// Returns a lane to the pool. Frames already queued on it are still delivered.
+        void ReleaseLane(Lane* lane)
+        {
+            for (std::size_t i = 0; i < _lanes.size(); ++i)
+            {
+                if (_lanes[i].get() == lane)
+                {
+                    _inUse[i].store(false, std::memory_order_release);
+                    return;
+                }
+            }
+        }
+
+        /// Consumer: drains up to out.size() items across all lanes.
+        std::size_t Drain(std::span<T> out)
+        {
+            const std::size_t laneCount = _lanes.size();
+            std::size_t total = 0;
+            for (std::size_t i = 0; i < laneCount && total < out.size(); ++i)
+            {
+                total += _lanes[(_nextLane + i) % laneCount]->Drain(out.subspan(total));
+            }
+
+            _nextLane = laneCount == 0 ? 0 : (_nextLane + 1) % laneCount;
+            return total;
+        }
+
+        /// Releases every producer blocked under the Block policy.
+        void Close()
+        {
+            for (auto& lane : _lanes)
+            {
+                lane->Close();
+            }
+        }
+
+        RingStats Stats() const
+        {
+            RingStats total;
+            for (const auto& lane : _lanes)
+            {
+                const RingStats stats = lane->Stats();
+                total.enqueued += stats.enqueued;
+                total.dequeued += stats.dequeued;
+                total.dropped += stats.dropped;
+                total.highWater = std::max(total.highWater, stats.highWater);
+                total.capacity += stats.capacity;
+            }
+            return total;
+        }
+
+    private:
+        std::vector<std::unique_ptr<Lane>> _lanes;
+        std::vector<std::atomic<bool>> _inUse;
+        std::size_t _nextLane = 0;
+    };
+
+    using FrameRing = SpscRing<DoorCore::CanFrame>;
+    using FrameFanIn = FanInRing<DoorCore::CanFrame>;
+}
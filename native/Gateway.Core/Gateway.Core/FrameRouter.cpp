@@ -0,0 +1,414 @@
+#include "pch.h"
+
+#include "FrameRouter.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <map>
+
+using DoorCore::Bump;
+using DoorCore::CanFrame;
+using DoorCore::HashId;
+using DoorCore::kExtendedIdMask;
+using DoorCore::kStandardIdMask;
+
+namespace GatewayCore
+{
+    namespace
+    {
+        constexpr std::uint32_t kEmptyKey = UINT32_MAX;
+    }
+
+    void FrameRouter::MaskTable::Build(std::span<const std::pair<std::uint32_t, RouteSet>> entries)
+    {
+        // Load factor <= 0.5 keeps probe chains short for misses, which dominate on a busy bus.
+        const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(entries.size() * 2, 8));
+        shift = 32 - static_cast<std::uint32_t>(std::countr_zero(capacity));
+        keys.assign(capacity, kEmptyKey);
+        routes.assign(capacity, 0);
+
+        for (const auto& [key, set] : entries)
+        {
+            for (std::uint32_t slot = HashId(key, shift);; slot = (slot + 1) & (capacity - 1))
+            {
+                if (keys[slot] == kEmptyKey || keys[slot] == key)
+                {
+                    keys[slot] = key;
+                    routes[slot] |= set;
+                    break;
+                }
+            }
+        }
+    }
+
+    RouteSet FrameRouter::MaskTable::Find(std::uint32_t id) const
+    {
+        const std::uint32_t key = id & mask;
+        const std::size_t wrap = keys.size() - 1;
+        for (std::uint32_t slot = HashId(key, shift);; slot = (slot + 1) & wrap)
+        {
+            if (keys[slot] == key)
+            {
+                return routes[slot];
+            }
+            if (keys[slot] == kEmptyKey)
+            {
+                return 0;
+            }
+        }
+    }
+
+    FrameRouter::FrameRouter()
+    {
+        Compile();
+    }
+
+    bool FrameRouter::AddRoute(const std::string& name, const RouteLimits& limits, std::size_t& route, std::string& error)
+    {
+        if (_routeCount == kMaxRoutes)
+        {
+            error = "at most " + std::to_string(kMaxRoutes) + " routes are supported";
+            return false;
+        }
+        if (!(limits.maxFramesPerSecond >= 0))
+        {
+            error = "route '" + name + "': maxFramesPerSecond must be >= 0";
+            return false;
+        }
+
+        route = _routeCount++;
+        _routes[route].name = name;
+        _routes[route].limits = limits;
+        return true;
+    }
+
+    bool FrameRouter::CheckRoute(std::size_t route, std::string& error) const
+    {
+        if (route >= _routeCount)
+        {
+            error = "unknown route " + std::to_string(route);
+            return false;
+        }
+        return true;
+    }
+
+    bool FrameRouter::AddId(std::size_t route, std::uint32_t id, std::string& error)
+    {
+        if (id <= kStandardIdMask)
+        {
+            return AddRange(route, id, id, error);
+        }
+        return AddMask(route, id, kExtendedIdMask, true, error);
+    }
+
+    bool FrameRouter::AddRange(std::size_t route, std::uint32_t first, std::uint32_t last, std::string& error)
+    {
+        if (!CheckRoute(route, error))
+        {
+            return false;
+        }
+        if (first > last)
+        {
+            std::swap(first, last);
+        }
+        if (last > kExtendedIdMask)
+        {
+            error = "range ends beyond the 29-bit ID space";
+            return false;
+        }
+
+        _rules.push_back({ RuleKind::Range, static_cast<std::uint32_t>(route), first, last });
+        return true;
+    }
+
+    bool FrameRouter::AddMask(std::size_t route, std::uint32_t id, std::uint32_t mask, bool extended, std::string& error)
+    {
+        if (!CheckRoute(route, error))
+        {
+            return false;
+        }
+
+        const std::uint32_t space = extended ? kExtendedIdMask : kStandardIdMask;
+        if ((id & ~space) != 0)
+        {
+            error = extended ? "extended ID exceeds 29 bits" : "standard ID exceeds 11 bits";
+            return false;
+        }
+
+        mask &= space;
+        _rules.push_back({ extended ? RuleKind::ExtendedMask : RuleKind::StandardMask, static_cast<std::uint32_t>(route), id & mask, mask });
+        return true;
+    }
+
+    void FrameRouter::Compile()
+    {
+        _standard.assign(kStandardIdMask + 1, 0);
+        _segmentStarts.clear();
+        _segmentRoutes.clear();
+        _maskTables.clear();
+
+        // Range rules: fill the standard table directly; sweep the extended parts into
+        // disjoint segments, each carrying the union of the routes covering it.
+        struct Edge
+        {
+            std::uint32_t position;
+            std::uint32_t route;
+            int delta;
+        };
+        std::vector<Edge> edges;
+        std::map<std::uint32_t, std::vector<std::pair<std::uint32_t, RouteSet>>> maskEntries;
+
+        for (const Rule& rule : _rules)
+        {
+            const RouteSet bit = RouteSet{ 1 } << rule.route;
+            switch (rule.kind)
+            {
+            case RuleKind::Range:
+                for (std::uint32_t id = rule.first; id <= std::min(rule.second, kStandardIdMask); ++id)
+                {
+                    _standard[id] |= bit;
+                }
+                if (rule.second > kStandardIdMask)
+                {
+                    edges.push_back({ std::max(rule.first, kStandardIdMask + 1), rule.route, 1 });
+                    edges.push_back({ rule.second + 1, rule.route, -1 });
+                }
+                break;
+
+            case RuleKind::StandardMask:
+                for (std::uint32_t id = 0; id <= kStandardIdMask; ++id)
+                {
+                    if ((id & rule.second) == rule.first)
+                    {
+                        _standard[id] |= bit;
+                    }
+                }
+                break;
+
+            case RuleKind::ExtendedMask:
+                maskEntries[rule.second].emplace_back(rule.first, bit);
+                break;
+            }
+        }
+
+        if (!edges.empty())
+        {
+            std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.position < b.position; });
+
+            std::array<std::uint32_t, kMaxRoutes> depth{};
+            RouteSet current = 0;
+            _segmentStarts.push_back(kStandardIdMask + 1);
+            _segmentRoutes.push_back(0);
+
+            for (std::size_t i = 0; i < edges.size();)
+            {
+                const std::uint32_t position = edges[i].position;
+                for (; i < edges.size() && edges[i].position == position; ++i)
+                {
+                    depth[edges[i].route] += edges[i].delta;
+                    const RouteSet bit = RouteSet{ 1 } << edges[i].route;
+                    current = depth[edges[i].route] != 0 ? current | bit : current & ~bit;
+                }
+
+                if (current == _segmentRoutes.back())
+                {
+                    continue;
+                }
+                if (_segmentStarts.back() == position)
+                {
+                    _segmentRoutes.back() = current;
+                }
+                else
+                {
+                    _segmentStarts.push_back(position);
+                    _segmentRoutes.push_back(current);
+                }
+            }
+        }
+
+        // Most specific mask first so exact-ID hits stop probing early in practice.
+        for (auto it = maskEntries.rbegin(); it != maskEntries.rend(); ++it)
+        {
+            MaskTable& table = _maskTables.emplace_back();
+            table.mask = it->first;
+            table.Build(it->second);
+        }
+
+        _cache.assign(std::size_t{ 1 } << kCacheBits, CacheEntry{});
+        _gather.resize(kDispatchChunk * _routeCount);
+
+        _limited = 0;
+        for (std::size_t route = 0; route < _routeCount; ++route)
+        {
+            RouteState& state = _routes[route];
+            state.costTicks = 0;
+            if (state.limits.maxFramesPerSecond > 0)
+            {
+                state.costTicks = std::max<std::int64_t>(1, std::llround(DoorCore::kTicksPerSecond / state.limits.maxFramesPerSecond));
+            }
+            state.maxCredit = state.costTicks * std::max<std::uint32_t>(state.limits.burst, 1);
+            state.credit = 0;
+            state.primed = false;
+            state.decimationCount = 0;
+
+            if (state.costTicks != 0 || state.limits.decimation > 1)
+            {
+                _limited |= RouteSet{ 1 } << route;
+            }
+        }
+    }
+
+    RouteSet FrameRouter::MatchExtended(std::uint32_t id) const
+    {
+        RouteSet routes = 0;
+        if (!_segmentStarts.empty())
+        {
+            const auto it = std::upper_bound(_segmentStarts.begin(), _segmentStarts.end(), id);
+            routes = _segmentRoutes[static_cast<std::size_t>(it - _segmentStarts.begin()) - 1];
+        }
+        for (const MaskTable& table : _maskTables)
+        {
+            routes |= table.Find(id);
+        }
+        return routes;
+    }
+
+    RouteSet FrameRouter::Lookup(std::uint32_t id)
+    {
+        if (id <= kStandardIdMask)
+        {
+            return _standard[id];
+        }
+
+        // Extended IDs are > 0x7FF, so id 0 marks an empty slot.
+        CacheEntry& entry = _cache[HashId(id, static_cast<std::uint32_t>(32 - kCacheBits))];
+        if (entry.id == id)
+        {
+            Bump(_cacheHits, 1);
+            return entry.routes;
+        }
+
+        Bump(_cacheMisses, 1);
+        entry.id = id;
+        entry.routes = MatchExtended(id);
+        return entry.routes;
+    }
+
+    bool FrameRouter::Admit(RouteState& state, std::int64_t timestamp)
+    {
+        if (state.limits.decimation > 1)
+        {
+            const bool keep = state.decimationCount == 0;
+            if (++state.decimationCount == state.limits.decimation)
+            {
+                state.decimationCount = 0;
+            }
+            if (!keep)
+            {
+                Bump(state.decimated, 1);
+                return false;
+            }
+        }
+
+        if (state.costTicks != 0)
+        {
+            if (!state.primed)
+            {
+                state.primed = true;
+                state.credit = state.maxCredit;
+            }
+            else if (timestamp > state.lastTimestamp)
+            {
+                state.credit = std::min(state.maxCredit, state.credit + (timestamp - state.lastTimestamp));
+            }
+            // A replay that seeks backwards restarts accrual from the new position.
+            state.lastTimestamp = timestamp;
+
+            if (state.credit < state.costTicks)
+            {
+                Bump(state.rateLimited, 1);
+                return false;
+            }
+            state.credit -= state.costTicks;
+        }
+        return true;
+    }
+
+    RouteSet FrameRouter::Route(const CanFrame& frame)
+    {
+        Bump(_frames, 1);
+
+        const RouteSet routes = Lookup(frame.id);
+        if (routes == 0)
+        {
+            Bump(_unrouted, 1);
+            return 0;
+        }
+
+        RouteSet delivered = routes;
+        for (RouteSet pending = routes; pending != 0; pending &= pending - 1)
+        {
+            const int route = std::countr_zero(pending);
+            RouteState& state = _routes[route];
+            Bump(state.matched, 1);
+
+            if (((_limited >> route) & 1) != 0 && !Admit(state, frame.timestamp))
+            {
+                delivered &= ~(RouteSet{ 1 } << route);
+                continue;
+            }
+            Bump(state.delivered, 1);
+        }
+        return delivered;
+    }
+
+    void FrameRouter::Dispatch(std::span<const CanFrame> frames, const RouteSink& sink)
+    {
+        for (std::size_t offset = 0; offset < frames.size(); offset += kDispatchChunk)
+        {
+            const auto chunk = frames.subspan(offset, std::min(kDispatchChunk, frames.size() - offset));
+
+            std::array<std::uint32_t, kMaxRoutes> counts{};
+            RouteSet touched = 0;
+            for (const CanFrame& frame : chunk)
+            {
+                const RouteSet routes = Route(frame);
+                touched |= routes;
+                for (RouteSet pending = routes; pending != 0; pending &= pending - 1)
+                {
+                    const int route = std::countr_zero(pending);
+                    _gather[route * kDispatchChunk + counts[route]++] = frame;
+                }
+            }
+
+            for (; touched != 0; touched &= touched - 1)
+            {
+                const int route = std::countr_zero(touched);
+                sink(static_cast<std::size_t>(route), std::span<const CanFrame>(_gather.data() + route * kDispatchChunk, counts[route]));
+            }
+        }
+    }
+
+    RouteStats FrameRouter::Stats(std::size_t route) const
+    {
+        const RouteState& state = _routes[route];
+        RouteStats stats;
+        stats.matched = state.matched.load(std::memory_order_relaxed);
+        stats.delivered = state.delivered.load(std::memory_order_relaxed);
+        stats.decimated = state.decimated.load(std::memory_order_relaxed);
+        stats.rateLimited = state.rateLimited.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    RouterStats FrameRouter::Stats() const
+    {
+        RouterStats stats;
+        stats.frames = _frames.load(std::memory_order_relaxed);
+        stats.unrouted = _unrouted.load(std::memory_order_relaxed);
+        stats.extendedCacheHits = _cacheHits.load(std::memory_order_relaxed);
+        stats.extendedCacheMisses = _cacheMisses.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CanFrame.h"
+
+namespace GatewayCore
+{
+    /// Set of routes a frame goes to; bit i is route i.
+    using RouteSet = std::uint64_t;
+
+    struct RouteLimits
+    {
+        /// Deliver every Nth matching frame (1 delivers all).
+        std::uint32_t decimation = 1;
+
+        /// Upper bound on delivered frames per second of frame-timestamp time, so replays are
+        /// limited the same way as live traffic. 0 is unlimited.
+        double maxFramesPerSecond = 0;
+
+        /// Frames that may pass back to back before the rate limit applies.
+        std::uint32_t burst = 1;
+    };
+
+    struct RouteStats
+    {
+        /// Frames whose ID matched one of the route's rules.
+        std::uint64_t matched = 0;
+        std::uint64_t delivered = 0;
+        std::uint64_t decimated = 0;
+        std::uint64_t rateLimited = 0;
+    };
+
+    struct RouterStats
+    {
+        std::uint64_t frames = 0;
+        /// Frames no route subscribed to.
+        std::uint64_t unrouted = 0;
+        std::uint64_t extendedCacheHits = 0;
+        std::uint64_t extendedCacheMisses = 0;
+    };
+
+    /// <summary>
+    /// Maps CAN IDs to subscriber routes through tables compiled from ID, range and mask rules.
+    /// </summary>
+    /// <remarks>
+    /// Consumers register a route with the rules they care about instead of receiving every
+    /// frame and rejecting foreign traffic themselves. Compile() turns the rules into:
+    /// - a direct 2048-entry table for standard IDs (one load per frame);
+    /// - for extended IDs, sorted disjoint segments for ranges plus one hash table per
+    ///   distinct mask for ID/mask rules (exact IDs are the all-ones mask), fronted by a
+    ///   direct-mapped cache of recent IDs since a bus carries a small set of them.
+    /// Lookup cost therefore depends on the number of distinct masks, not the number of rules.
+    ///
+    /// As everywhere in the native code, IDs up to 0x7FF are standard and larger ones are
+    /// extended; CanFrame carries no IDE flag.
+    ///
+    /// Rules take effect at the next Compile(), which must not overlap Route()/Dispatch().
+    /// Route() and Dispatch() are called from one thread (typically the FrameDispatcher
+    /// handler); Stats() may be read from any thread.
+    /// </remarks>
+    class FrameRouter
+    {
+    public:
+        static constexpr std::size_t kMaxRoutes = 64;
+
+        /// Receives the frames of one route, in arrival order.
+        using RouteSink = std::function<void(std::size_t route, std::span<const DoorCore::CanFrame>)>;
+
+        FrameRouter();
+
+        FrameRouter(const FrameRouter&) = delete;
+        FrameRouter& operator=(const FrameRouter&) = delete;
+
+        /// Registers a subscriber and returns its route index. Fails once kMaxRoutes exist.
+        bool AddRoute(const std::string& name, const RouteLimits& limits, std::size_t& route, std::string& error);
+
+        bool AddId(std::size_t route, std::uint32_t id, std::string& error);
+        /// Inclusive range; may span standard and extended IDs.
+        bool AddRange(std::size_t route, std::uint32_t first, std::uint32_t last, std::string& error);
+        /// Matches IDs of one kind (standard or extended) with (frameId & mask) == (id & mask).
+        bool AddMask(std::size_t route, std::uint32_t id, std::uint32_t mask, bool extended, std::string& error);
+
+        /// Builds the lookup tables from the registered rules and resets limiter state.
+        void Compile();
+
+        /// Routes subscribed to `id`, before rate limiting and decimation.
+        RouteSet Match(std::uint32_t id) const
+        {
+            if (id <= DoorCore::kStandardIdMask)
+            {
+                return _standard[id];
+            }
+            return MatchExtended(id);
+        }
+
+        /// Routes that should receive `frame` after rate limiting and decimation.
+        RouteSet Route(const DoorCore::CanFrame& frame);
+
+        /// Routes a batch and hands each route its frames as one span per call.
+        void Dispatch(std::span<const DoorCore::CanFrame> frames, const RouteSink& sink);
+
+        std::size_t RouteCount() const { return _routeCount; }
+        const std::string& RouteName(std::size_t route) const { return _routes[route].name; }
+
+        RouteStats Stats(std::size_t route) const;
+        RouterStats Stats() const;
+
+    private:
+        enum class RuleKind
+        {
+            Range,
+            StandardMask,
+            ExtendedMask
+        };
+
+        struct Rule
+        {
+            RuleKind kind;
+            std::uint32_t route;
+            std::uint32_t first;
+            /// Range end, or the mask of a mask rule.
+            std::uint32_t second;
+        };
+
+        struct RouteState
+        {
+            std::string name;
+            RouteLimits limits;
+
+            // Token bucket in ticks of credit: each frame costs costTicks and credit
+            // accrues with frame time up to burst * cost.
+            std::int64_t costTicks = 0;
+            std::int64_t maxCredit = 0;
+            std::int64_t credit = 0;
+            std::int64_t lastTimestamp = 0;
+            bool primed = false;
+            std::uint32_t decimationCount = 0;
+
+            std::atomic<std::uint64_t> matched{ 0 };
+            std::atomic<std::uint64_t> delivered{ 0 };
+            std::atomic<std::uint64_t> decimated{ 0 };
+            std::atomic<std::uint64_t> rateLimited{ 0 };
+        };
+
+        /// Open-addressed table of (id & mask) -> routes for one mask.
+        struct MaskTable
+        {
+            std::uint32_t mask = 0;
+            std::uint32_t shift = 0;
+            std::vector<std::uint32_t> keys;
+            std::vector<RouteSet> routes;
+
+            void Build(std::span<const std::pair<std::uint32_t, RouteSet>> entries);
+            RouteSet Find(std::uint32_t id) const;
+        };
+
+        struct CacheEntry
+        {
+            std::uint32_t id = 0;
+            RouteSet routes = 0;
+        };
+
+        static constexpr std::size_t kCacheBits = 12;
+        static constexpr std::size_t kDispatchChunk = 256;
+
+        bool CheckRoute(std::size_t route, std::string& error) const;
+        RouteSet MatchExtended(std::uint32_t id) const;
+        RouteSet Lookup(std::uint32_t id);
+        bool Admit(RouteState& state, std::int64_t timestamp);
+
+        std::array<RouteState, kMaxRoutes> _routes;
+        std::size_t _routeCount = 0;
+        /// Routes with a rate limit or decimation; the rest skip the limiter entirely.
+        RouteSet _limited = 0;
+        std::vector<Rule> _rules;
+
+        std::vector<RouteSet> _standard;
+        std::vector<std::uint32_t> _segmentStarts;
+        std::vector<RouteSet> _segmentRoutes;
+        std::vector<MaskTable> _maskTables;
+        std::vector<CacheEntry> _cache;
+
+        std::vector<DoorCore::CanFrame> _gather;
+
+        std::atomic<std::uint64_t> _frames{ 0 };
+        std::atomic<std::uint64_t> _unrouted{ 0 };
+        std::atomic<std::uint64_t> _cacheHits{ 0 };
+        std::atomic<std::uint64_t> _cacheMisses{ 0 };
+    };
+}
@@ -1 +1,11 @@
 #pragma once
+
+// Public entry point for the Gateway.Core static library.
+#include "FrameDispatcher.h"
+#include "FrameRing.h"
+#include "FrameRouter.h"
+#include "TraceFormat.h"
+#include "TraceReader.h"
+#include "TraceReplayer.h"
+#include "TraceText.h"
+#include "TraceWriter.h"
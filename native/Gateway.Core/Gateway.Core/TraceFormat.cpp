@@ -0,0 +1,174 @@
+#include "pch.h"
+
+#include "TraceFormat.h"
+
+#include <bit>
+#include <cstring>
+
+using DoorCore::CanFrame;
+
+namespace GatewayCore::TraceFormat
+{
+    // Headers are written and mapped as raw structs.
+    static_assert(std::endian::native == std::endian::little, "trace files are little-endian");
+
+    namespace
+    {
+        std::uint64_t ZigZag(std::int64_t value)
+        {
+            return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+        }
+
+        std::int64_t UnZigZag(std::uint64_t value)
+        {
+            return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+        }
+
+        std::size_t PutVarint(std::uint8_t* out, std::uint64_t value)
+        {
+            std::size_t n = 0;
+            while (value >= 0x80)
+            {
+                out[n++] = static_cast<std::uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+            out[n++] = static_cast<std::uint8_t>(value);
+            return n;
+        }
+
+        bool GetVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& value)
+        {
+            value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if (p == end)
+                {
+                    return false;
+                }
+                const std::uint8_t byte = *p++;
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    std::uint32_t Checksum(std::span<const std::uint8_t> bytes)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (std::uint8_t b : bytes)
+        {
+            hash = (hash ^ b) * 16777619u;
+        }
+        return hash;
+    }
+
+    BlockEncoder::BlockEncoder(std::size_t capacity)
+        : _payload(capacity < kMaxEncodedFrame ? kMaxEncodedFrame : capacity)
+    {
+        Reset();
+    }
+
+    void BlockEncoder::Reset()
+    {
+        _size = 0;
+        _header = {};
+        _header.magic = kBlockMagic;
+        _header.minId = UINT32_MAX;
+    }
+
+    void BlockEncoder::Append(const CanFrame& frame)
+    {
+        const std::uint8_t dlc = DoorCore::ClampDlc(frame.dlc);
+        if (_header.frameCount == 0)
+        {
+            _header.firstTimestamp = frame.timestamp;
+            _previousTimestamp = frame.timestamp;
+            // Never matches a real ID, so the first frame always carries its ID.
+            _previousId = UINT32_MAX;
+        }
+
+        std::uint8_t* out = _payload.data() + _size;
+        const bool sameId = frame.id == _previousId;
+        std::size_t n = 0;
+        out[n++] = static_cast<std::uint8_t>(dlc | (sameId ? kTagSameId : 0));
+        n += PutVarint(out + n, ZigZag(frame.timestamp - _previousTimestamp));
+        if (!sameId)
+        {
+            n += PutVarint(out + n, frame.id);
+        }
+        std::memcpy(out + n, frame.data, dlc);
+        _size += n + dlc;
+
+        _previousTimestamp = frame.timestamp;
+        _previousId = frame.id;
+
+        ++_header.frameCount;
+        _header.lastTimestamp = frame.timestamp;
+        _header.minId = frame.id < _header.minId ? frame.id : _header.minId;
+        _header.maxId = frame.id > _header.maxId ? frame.id : _header.maxId;
+    }
+
+    const BlockHeader& BlockEncoder::Seal()
+    {
+        _header.payloadBytes = static_cast<std::uint32_t>(_size);
+        _header.checksum = Checksum(Payload());
+        return _header;
+    }
+
+    std::size_t DecodeBlock(const BlockHeader& header, std::span<const std::uint8_t> payload, std::span<CanFrame> out)
+    {
+        if (header.magic != kBlockMagic || header.frameCount > out.size() || header.payloadBytes > payload.size())
+        {
+            return 0;
+        }
+
+        const std::uint8_t* p = payload.data();
+        const std::uint8_t* const end = p + header.payloadBytes;
+        std::int64_t timestamp = header.firstTimestamp;
+        std::uint32_t id = 0;
+
+        for (std::uint32_t i = 0; i < header.frameCount; ++i)
+        {
+            if (p == end)
+            {
+                return 0;
+            }
+
+            const std::uint8_t tag = *p++;
+            const std::uint8_t dlc = tag & kTagDlcMask;
+            std::uint64_t value;
+            if (dlc > DoorCore::kMaxDlc || !GetVarint(p, end, value))
+            {
+                return 0;
+            }
+            timestamp += UnZigZag(value);
+
+            if ((tag & kTagSameId) == 0)
+            {
+                if (!GetVarint(p, end, value))
+                {
+                    return 0;
+                }
+                id = static_cast<std::uint32_t>(value);
+            }
+
+            if (static_cast<std::size_t>(end - p) < dlc)
+            {
+                return 0;
+            }
+
+            CanFrame& frame = out[i];
+            frame = {};
+            frame.id = id;
+            frame.dlc = dlc;
+            frame.timestamp = timestamp;
+            std::memcpy(frame.data, p, dlc);
+            p += dlc;
+        }
+        return header.frameCount;
+    }
+}
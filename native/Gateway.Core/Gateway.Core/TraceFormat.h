@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "CanFrame.h"
+
+namespace GatewayCore
+{
+    /// <summary>
+    /// On-disk layout of the binary CAN trace (.rtrc).
+    /// </summary>
+    /// <remarks>
+    /// File:  FileHeader | (BlockHeader | payload)* | IndexEntry[blockCount] | Trailer
+    ///
+    /// Each block is independently decodable. Frames in a block are delta-coded against
+    /// the previous frame of the same block:
+    ///   tag:u8      bits 0-3 DLC, bit 4 set if the ID repeats the previous frame's
+    ///   dt:varint   zigzag timestamp delta in ticks (first frame: against firstTimestamp)
+    ///   id:varint   only if bit 4 is clear
+    ///   data[DLC]
+    /// A door state frame shrinks from 24 bytes in memory to ~6 bytes on disk.
+    ///
+    /// The index and trailer are written on Close(). A file from a crashed recorder has no
+    /// trailer; readers rebuild the index by walking the block headers, so only the block
+    /// in flight is lost. All integers are little-endian.
+    /// </remarks>
+    namespace TraceFormat
+    {
+        constexpr std::uint32_t kVersion = 1;
+        constexpr std::uint64_t kFileMagic = 0x3143525454494152ULL; // "RAILTRC1"
+        constexpr std::uint32_t kBlockMagic = 0x4B4C4254u;          // "TBLK"
+        constexpr std::uint32_t kTrailerMagic = 0x444E4554u;        // "TEND"
+
+        /// Worst-case encoded size of one frame: tag + 10-byte dt + 5-byte id + data.
+        constexpr std::size_t kMaxEncodedFrame = 1 + 10 + 5 + DoorCore::kMaxDlc;
+        /// Smallest possible encoded frame (tag + dt, repeated ID, DLC 0).
+        constexpr std::size_t kMinEncodedFrame = 2;
+
+        constexpr std::uint8_t kTagDlcMask = 0x0F;
+        constexpr std::uint8_t kTagSameId = 0x10;
+
+        struct FileHeader
+        {
+            std::uint64_t magic;
+            std::uint32_t version;
+            /// Payload capacity the recorder used; bounds frames per block for readers.
+            std::uint32_t blockBytes;
+            std::int64_t createdTicks;
+            std::uint64_t reserved;
+        };
+
+        struct BlockHeader
+        {
+            std::uint32_t magic;
+            std::uint32_t frameCount;
+            std::uint32_t payloadBytes;
+            /// FNV-1a of the payload.
+            std::uint32_t checksum;
+            std::int64_t firstTimestamp;
+            std::int64_t lastTimestamp;
+            std::uint32_t minId;
+            std::uint32_t maxId;
+        };
+
+        struct IndexEntry
+        {
+            /// File offset of the BlockHeader.
+            std::uint64_t offset;
+            std::int64_t firstTimestamp;
+            std::int64_t lastTimestamp;
+            std::uint32_t frameCount;
+            std::uint32_t payloadBytes;
+            std::uint32_t minId;
+            std::uint32_t maxId;
+        };
+
+        struct Trailer
+        {
+            std::uint64_t indexOffset;
+            std::uint64_t blockCount;
+            std::uint64_t frameCount;
+            std::uint32_t magic;
+            std::uint32_t version;
+        };
+
+        static_assert(sizeof(FileHeader) == 32);
+        static_assert(sizeof(BlockHeader) == 40);
+        static_assert(sizeof(IndexEntry) == 40);
+        static_assert(sizeof(Trailer) == 32);
+
+        std::uint32_t Checksum(std::span<const std::uint8_t> bytes);
+
+        /// <summary>
+        /// Appends frames to one block payload; reused across blocks without reallocating.
+        /// </summary>
+        class BlockEncoder
+        {
+        public:
+            explicit BlockEncoder(std::size_t capacity);
+
+            /// False if the payload cannot take another worst-case frame.
+            bool HasRoom() const { return _size + kMaxEncodedFrame <= _payload.size(); }
+
+            void Append(const DoorCore::CanFrame& frame);
+
+            std::uint32_t FrameCount() const { return _header.frameCount; }
+            bool Empty() const { return _header.frameCount == 0; }
+            std::int64_t FirstTimestamp() const { return _header.firstTimestamp; }
+
+            /// Completes the header (size, checksum) and returns it with the payload.
+            const BlockHeader& Seal();
+            const BlockHeader& Header() const { return _header; }
+            std::span<const std::uint8_t> Payload() const { return { _payload.data(), _size }; }
+
+            void Reset();
+
+        private:
+            std::vector<std::uint8_t> _payload;
+            std::size_t _size = 0;
+            BlockHeader _header{};
+            std::int64_t _previousTimestamp = 0;
+            std::uint32_t _previousId = 0;
+        };
+
+        /// Decodes a block payload into `out` (which must hold frameCount frames). Returns the
+        /// number of frames decoded, or 0 if the payload is truncated or malformed.
+        std::size_t DecodeBlock(const BlockHeader& header, std::span<const std::uint8_t> payload, std::span<DoorCore::CanFrame> out);
+    }
+}
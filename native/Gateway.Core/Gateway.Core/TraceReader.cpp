@@ -0,0 +1,412 @@
+#include "pch.h"
+
+#include "TraceReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using DoorCore::CanFrame;
+
+namespace GatewayCore
+{
+    namespace
+    {
+        template <typename T>
+        T LoadStruct(const std::uint8_t* p)
+        {
+            // The mapping has no alignment guarantees past the file header.
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        /// Bounds a block taken from an index entry or a block header before anything is sized
+        /// or read from it: neither is covered by the payload checksum. Each bound is checked
+        /// on its own so a huge offset cannot wrap the sum past `end`.
+        bool BlockFits(std::uint64_t offset, std::uint32_t frameCount, std::uint32_t payloadBytes, std::uint64_t end)
+        {
+            constexpr std::uint64_t kHeader = sizeof(TraceFormat::BlockHeader);
+            return end >= kHeader
+                && offset >= sizeof(TraceFormat::FileHeader)
+                && offset <= end - kHeader
+                && payloadBytes <= end - offset - kHeader
+                && frameCount <= payloadBytes / TraceFormat::kMinEncodedFrame;
+        }
+    }
+
+    void TraceIdFilter::Allow(std::uint32_t id)
+    {
+        AllowRange(id, id);
+    }
+
+    void TraceIdFilter::AllowRange(std::uint32_t first, std::uint32_t last)
+    {
+        if (first > last)
+        {
+            std::swap(first, last);
+        }
+
+        _acceptAll = false;
+        _lowest = std::min(_lowest, first);
+        _highest = std::max(_highest, last);
+
+        for (std::uint32_t id = first; id <= std::min(last, DoorCore::kStandardIdMask); ++id)
+        {
+            _standard[id >> 6] |= std::uint64_t{ 1 } << (id & 63);
+        }
+        if (last > DoorCore::kStandardIdMask)
+        {
+            _extended.emplace_back(std::max(first, DoorCore::kStandardIdMask + 1), last);
+        }
+    }
+
+    bool TraceIdFilter::MayMatch(std::uint32_t minId, std::uint32_t maxId) const
+    {
+        return _acceptAll || (minId <= _highest && maxId >= _lowest);
+    }
+
+    TraceReader::~TraceReader()
+    {
+        Close();
+    }
+
+#if defined(_WIN32)
+
+    bool TraceReader::Open(const std::string& path, std::string& error)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            error = "cannot open '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+
+        LARGE_INTEGER size{};
+        GetFileSizeEx(file, &size);
+        if (static_cast<std::uint64_t>(size.QuadPart) < sizeof(TraceFormat::FileHeader))
+        {
+            error = "'" + path + "' is not a trace file";
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view == nullptr)
+        {
+            error = "cannot map '" + path + "' (error " + std::to_string(GetLastError()) + ")";
+            if (mapping != nullptr)
+            {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return false;
+        }
+
+        _fileHandle = file;
+        _mapping = mapping;
+        _base = static_cast<const std::uint8_t*>(view);
+        _size = static_cast<std::uint64_t>(size.QuadPart);
+
+        const auto header = LoadStruct<TraceFormat::FileHeader>(_base);
+        if (header.magic != TraceFormat::kFileMagic || header.version != TraceFormat::kVersion)
+        {
+            error = "'" + path + "' is not a trace file or has an unsupported version";
+            Close();
+            return false;
+        }
+
+        if (!LoadIndex())
+        {
+            RebuildIndex();
+        }
+        return true;
+    }
+
+    void TraceReader::Unmap()
+    {
+        if (_base != nullptr)
+        {
+            UnmapViewOfFile(_base);
+            CloseHandle(_mapping);
+            CloseHandle(_fileHandle);
+        }
+        _fileHandle = nullptr;
+        _mapping = nullptr;
+    }
+
+#else
+
+    bool TraceReader::Open(const std::string& path, std::string& error)
+    {
+        Close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            error = "cannot open '" + path + "': " + std::strerror(errno);
+            return false;
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < sizeof(TraceFormat::FileHeader))
+        {
+            error = "'" + path + "' is not a trace file";
+            ::close(fd);
+            return false;
+        }
+
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+        {
+            error = "cannot map '" + path + "': " + std::strerror(errno);
+            return false;
+        }
+        ::madvise(view, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+
+        _base = static_cast<const std::uint8_t*>(view);
+        _size = static_cast<std::uint64_t>(info.st_size);
+
+        const auto header = LoadStruct<TraceFormat::FileHeader>(_base);
+        if (header.magic != TraceFormat::kFileMagic || header.version != TraceFormat::kVersion)
+        {
+            error = "'" + path + "' is not a trace file or has an unsupported version";
+            Close();
+            return false;
+        }
+
+        if (!LoadIndex())
+        {
+            RebuildIndex();
+        }
+        return true;
+    }
+
+    void TraceReader::Unmap()
+    {
+        if (_base != nullptr)
+        {
+            ::munmap(const_cast<std::uint8_t*>(_base), static_cast<std::size_t>(_size));
+        }
+    }
+
+#endif
+
+    void TraceReader::Close()
+    {
+        Unmap();
+        _base = nullptr;
+        _size = 0;
+        _index.clear();
+        _lastTimestampPrefixMax.clear();
+        _frameCount = 0;
+        _maxBlockFrames = 0;
+        _recovered = false;
+    }
+
+    bool TraceReader::LoadIndex()
+    {
+        constexpr std::uint64_t kFixed = sizeof(TraceFormat::FileHeader) + sizeof(TraceFormat::Trailer);
+        if (_size < kFixed)
+        {
+            return false;
+        }
+
+        const auto trailer = LoadStruct<TraceFormat::Trailer>(_base + _size - sizeof(TraceFormat::Trailer));
+        if (trailer.magic != TraceFormat::kTrailerMagic
+            || trailer.version != TraceFormat::kVersion
+            || trailer.indexOffset < sizeof(TraceFormat::FileHeader)
+            || trailer.indexOffset > _size - sizeof(TraceFormat::Trailer)
+            || trailer.blockCount > (_size - kFixed) / sizeof(TraceFormat::IndexEntry)
+            || trailer.indexOffset + trailer.blockCount * sizeof(TraceFormat::IndexEntry) + sizeof(TraceFormat::Trailer) != _size)
+        {
+            return false;
+        }
+
+        _index.resize(static_cast<std::size_t>(trailer.blockCount));
+        std::memcpy(_index.data(), _base + trailer.indexOffset, _index.size() * sizeof(TraceFormat::IndexEntry));
+        for (const TraceFormat::IndexEntry& entry : _index)
+        {
+            if (!BlockFits(entry.offset, entry.frameCount, entry.payloadBytes, trailer.indexOffset))
+            {
+                _index.clear();
+                return false;
+            }
+        }
+
+        _frameCount = 0;
+        _maxBlockFrames = 0;
+        _lastTimestampPrefixMax.resize(_index.size());
+        for (std::size_t i = 0; i < _index.size(); ++i)
+        {
+            _frameCount += _index[i].frameCount;
+            _maxBlockFrames = std::max<std::size_t>(_maxBlockFrames, _index[i].frameCount);
+            _lastTimestampPrefixMax[i] = i == 0 ? _index[i].lastTimestamp : std::max(_lastTimestampPrefixMax[i - 1], _index[i].lastTimestamp);
+        }
+        return true;
+    }
+
+    void TraceReader::RebuildIndex()
+    {
+        _recovered = true;
+        _index.clear();
+        _frameCount = 0;
+        _maxBlockFrames = 0;
+
+        std::uint64_t offset = sizeof(TraceFormat::FileHeader);
+        while (offset + sizeof(TraceFormat::BlockHeader) <= _size)
+        {
+            const auto header = LoadStruct<TraceFormat::BlockHeader>(_base + offset);
+            const std::uint64_t payload = offset + sizeof(TraceFormat::BlockHeader);
+            if (header.magic != TraceFormat::kBlockMagic
+                || !BlockFits(offset, header.frameCount, header.payloadBytes, _size)
+                || TraceFormat::Checksum({ _base + payload, header.payloadBytes }) != header.checksum)
+            {
+                break;
+            }
+
+            _index.push_back({
+                offset,
+                header.firstTimestamp,
+                header.lastTimestamp,
+                header.frameCount,
+                header.payloadBytes,
+                header.minId,
+                header.maxId });
+            _frameCount += header.frameCount;
+            _maxBlockFrames = std::max<std::size_t>(_maxBlockFrames, header.frameCount);
+            offset = payload + header.payloadBytes;
+        }
+
+        _lastTimestampPrefixMax.resize(_index.size());
+        for (std::size_t i = 0; i < _index.size(); ++i)
+        {
+            _lastTimestampPrefixMax[i] = i == 0 ? _index[i].lastTimestamp : std::max(_lastTimestampPrefixMax[i - 1], _index[i].lastTimestamp);
+        }
+    }
+
+    std::int64_t TraceReader::FirstTimestamp() const
+    {
+        return _index.empty() ? 0 : _index.front().firstTimestamp;
+    }
+
+    std::int64_t TraceReader::LastTimestamp() const
+    {
+        return _lastTimestampPrefixMax.empty() ? 0 : _lastTimestampPrefixMax.back();
+    }
+
+    std::size_t TraceReader::FindBlock(std::int64_t timestamp) const
+    {
+        const auto it = std::lower_bound(_lastTimestampPrefixMax.begin(), _lastTimestampPrefixMax.end(), timestamp);
+        return static_cast<std::size_t>(it - _lastTimestampPrefixMax.begin());
+    }
+
+    std::size_t TraceReader::DecodeBlock(std::size_t block, std::span<CanFrame> out) const
+    {
+        const TraceFormat::IndexEntry& entry = _index[block];
+        const auto header = LoadStruct<TraceFormat::BlockHeader>(_base + entry.offset);
+        if (header.frameCount != entry.frameCount || header.payloadBytes != entry.payloadBytes)
+        {
+            return 0;
+        }
+        return TraceFormat::DecodeBlock(header, { _base + entry.offset + sizeof(TraceFormat::BlockHeader), header.payloadBytes }, out);
+    }
+
+    TraceCursor::TraceCursor(const TraceReader& reader, TraceIdFilter filter)
+        : _reader(reader)
+        , _filter(std::move(filter))
+        , _decoded(reader.MaxBlockFrames())
+    {
+    }
+
+    void TraceCursor::Rewind()
+    {
+        _block = 0;
+        _position = 0;
+        _count = 0;
+    }
+
+    void TraceCursor::Seek(std::int64_t timestamp)
+    {
+        Rewind();
+        _block = _reader.FindBlock(timestamp);
+        if (_block >= _reader.BlockCount() || !LoadBlock(_block))
+        {
+            return;
+        }
+
+        // Blocks are time-ordered internally when recorded live; a linear skip inside one
+        // block is cheap next to decoding it.
+        while (_position < _count && _decoded[_position].timestamp < timestamp)
+        {
+            ++_position;
+        }
+        ++_block;
+    }
+
+    bool TraceCursor::LoadBlock(std::size_t block)
+    {
+        _position = 0;
+        _count = _reader.DecodeBlock(block, _decoded);
+        if (_count == 0)
+        {
+            _corruptFrames += _reader.Block(block).frameCount;
+            return false;
+        }
+        return true;
+    }
+
+    std::size_t TraceCursor::Read(std::span<CanFrame> out)
+    {
+        std::size_t written = 0;
+        while (written < out.size())
+        {
+            if (_position == _count)
+            {
+                // Advance to the next block whose ID range can match.
+                while (_block < _reader.BlockCount() && !_filter.MayMatch(_reader.Block(_block).minId, _reader.Block(_block).maxId))
+                {
+                    ++_block;
+                }
+                if (_block >= _reader.BlockCount())
+                {
+                    break;
+                }
+                LoadBlock(_block++);
+                continue;
+            }
+
+            if (_filter.AcceptsAll())
+            {
+                const std::size_t n = std::min(out.size() - written, _count - _position);
+                std::memcpy(out.data() + written, _decoded.data() + _position, n * sizeof(CanFrame));
+                written += n;
+                _position += n;
+                continue;
+            }
+
+            for (; _position < _count && written < out.size(); ++_position)
+            {
+                if (_filter.Accepts(_decoded[_position].id))
+                {
+                    out[written++] = _decoded[_position];
+                }
+            }
+        }
+        return written;
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CanFrame.h"
+#include "TraceFormat.h"
+
+namespace GatewayCore
+{
+    /// <summary>
+    /// Set of CAN IDs to keep when reading or replaying a trace; empty accepts everything.
+    /// </summary>
+    class TraceIdFilter
+    {
+    public:
+        void Allow(std::uint32_t id);
+        /// Inclusive range.
+        void AllowRange(std::uint32_t first, std::uint32_t last);
+
+        bool AcceptsAll() const { return _acceptAll; }
+
+        bool Accepts(std::uint32_t id) const
+        {
+            if (_acceptAll)
+            {
+                return true;
+            }
+            if (id <= DoorCore::kStandardIdMask)
+            {
+                return (_standard[id >> 6] >> (id & 63)) & 1;
+            }
+            for (const auto& range : _extended)
+            {
+                if (id >= range.first && id <= range.second)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// False only if no ID in [minId, maxId] can pass; used to skip whole blocks.
+        bool MayMatch(std::uint32_t minId, std::uint32_t maxId) const;
+
+    private:
+        bool _acceptAll = true;
+        std::array<std::uint64_t, (DoorCore::kStandardIdMask + 1) / 64> _standard{};
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> _extended;
+        std::uint32_t _lowest = UINT32_MAX;
+        std::uint32_t _highest = 0;
+    };
+
+    /// <summary>
+    /// Read-only memory mapping of a trace file with its block index.
+    /// </summary>
+    /// <remarks>
+    /// Blocks are decoded straight from the mapping; the OS pages them in on demand, so a
+    /// multi-GB trace opens in the time it takes to read the index. Files without a trailer
+    /// (recorder killed) are recovered by walking the block headers up to the first block
+    /// that is truncated or fails its checksum.
+    /// </remarks>
+    class TraceReader
+    {
+    public:
+        TraceReader() = default;
+        ~TraceReader();
+
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        bool Open(const std::string& path, std::string& error);
+        void Close();
+
+        bool IsOpen() const { return _base != nullptr; }
+        /// True if the index was rebuilt because the trailer was missing or damaged.
+        bool Recovered() const { return _recovered; }
+
+        std::size_t BlockCount() const { return _index.size(); }
+        std::uint64_t FrameCount() const { return _frameCount; }
+        std::size_t MaxBlockFrames() const { return _maxBlockFrames; }
+        std::uint64_t FileBytes() const { return _size; }
+        std::int64_t FirstTimestamp() const;
+        std::int64_t LastTimestamp() const;
+
+        const TraceFormat::IndexEntry& Block(std::size_t block) const { return _index[block]; }
+
+        /// First block that may contain a frame at or after `timestamp` (binary search; also
+        /// correct when blocks overlap in time). Returns BlockCount() if there is none.
+        std::size_t FindBlock(std::int64_t timestamp) const;
+
+        /// Decodes one block into `out` (at least Block(block).frameCount frames). Returns the
+        /// frame count, or 0 if the block is corrupt.
+        std::size_t DecodeBlock(std::size_t block, std::span<DoorCore::CanFrame> out) const;
+
+    private:
+        bool LoadIndex();
+        void RebuildIndex();
+        void Unmap();
+
+        const std::uint8_t* _base = nullptr;
+        std::uint64_t _size = 0;
+#if defined(_WIN32)
+        void* _fileHandle = nullptr;
+        void* _mapping = nullptr;
+#endif
+        std::vector<TraceFormat::IndexEntry> _index;
+        /// Running maximum of lastTimestamp, so FindBlock can binary-search overlapping blocks.
+        std::vector<std::int64_t> _lastTimestampPrefixMax;
+        std::uint64_t _frameCount = 0;
+        std::size_t _maxBlockFrames = 0;
+        bool _recovered = false;
+    };
+
+    /// <summary>
+    /// Sequential, filtered frame reader over a TraceReader.
+    /// </summary>
+    class TraceCursor
+    {
+    public:
+        explicit TraceCursor(const TraceReader& reader, TraceIdFilter filter = {});
+
+        /// Positions at the first frame with timestamp >= `timestamp`.
+        void Seek(std::int64_t timestamp);
+        void Rewind();
+
+        /// Copies up to out.size() matching frames; 0 means end of trace.
+        std::size_t Read(std::span<DoorCore::CanFrame> out);
+
+        /// Frames skipped because their block failed to decode.
+        std::uint64_t CorruptFrames() const { return _corruptFrames; }
+
+    private:
+        bool LoadBlock(std::size_t block);
+
+        const TraceReader& _reader;
+        TraceIdFilter _filter;
+        std::vector<DoorCore::CanFrame> _decoded;
+        std::size_t _block = 0;
+        std::size_t _position = 0;
+        std::size_t _count = 0;
+        std::uint64_t _corruptFrames = 0;
+    };
+}
@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include "TraceReplayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+using DoorCore::CanFrame;
+
+namespace GatewayCore
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        /// Frames read from the cursor per refill.
+        constexpr std::size_t kReadChunk = 4096;
+
+        /// Sleeps shorter than this are spun instead; OS sleeps overshoot by more.
+        constexpr auto kSpinThreshold = std::chrono::microseconds(200);
+    }
+
+    TraceReplayer::TraceReplayer(const TraceReader& reader)
+        : _reader(reader)
+    {
+    }
+
+    TraceReplayer::~TraceReplayer()
+    {
+        Stop();
+    }
+
+    TraceReplayStats TraceReplayer::Run(const TraceReplayOptions& options, const FrameSink& sink)
+    {
+        _stopping.store(false, std::memory_order_relaxed);
+        _running.store(true, std::memory_order_release);
+        return Replay(options, sink);
+    }
+
+    TraceReplayStats TraceReplayer::Replay(const TraceReplayOptions& options, const FrameSink& sink)
+    {
+        TraceReplayStats stats;
+        TraceCursor cursor(_reader, options.filter);
+        if (options.startTicks != INT64_MIN)
+        {
+            cursor.Seek(options.startTicks);
+        }
+
+        const std::size_t maxBatch = std::max<std::size_t>(options.maxBatch, 1);
+        const bool timed = options.speed > 0;
+        std::vector<CanFrame> chunk(std::max(kReadChunk, maxBatch));
+
+        const Clock::time_point start = Clock::now();
+        Clock::time_point anchor{};
+        std::int64_t traceAnchor = 0;
+        bool anchored = false;
+
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            const std::size_t read = cursor.Read(chunk);
+            if (read == 0)
+            {
+                break;
+            }
+
+            std::size_t count = read;
+            bool ended = false;
+            for (std::size_t i = 0; i < read; ++i)
+            {
+                if (chunk[i].timestamp >= options.endTicks)
+                {
+                    count = i;
+                    ended = true;
+                    break;
+                }
+            }
+
+            std::size_t position = 0;
+            while (position < count && !_stopping.load(std::memory_order_acquire))
+            {
+                std::size_t end = std::min(count, position + maxBatch);
+
+                if (timed)
+                {
+                    if (!anchored)
+                    {
+                        anchor = Clock::now();
+                        traceAnchor = chunk[position].timestamp;
+                        anchored = true;
+                    }
+
+                    const auto dueOf = [&](const CanFrame& frame)
+                    {
+                        const double offsetTicks = static_cast<double>(frame.timestamp - traceAnchor) / options.speed;
+                        return anchor + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::ratio<1, DoorCore::kTicksPerSecond>>(offsetTicks));
+                    };
+
+                    // Wait for the head frame, then send it with every frame already due.
+                    const Clock::time_point due = dueOf(chunk[position]);
+                    Clock::time_point now = Clock::now();
+                    if (now < due)
+                    {
+                        if (due - now > kSpinThreshold)
+                        {
+                            std::unique_lock<std::mutex> lock(_mutex);
+                            _wake.wait_until(lock, due - kSpinThreshold, [this] { return _stopping.load(std::memory_order_acquire); });
+                        }
+                        while ((now = Clock::now()) < due && !_stopping.load(std::memory_order_acquire))
+                        {
+                        }
+                        if (now < due)
+                        {
+                            break;
+                        }
+                    }
+
+                    const auto late = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+                    stats.maxLateMicros = std::max<std::uint64_t>(stats.maxLateMicros, static_cast<std::uint64_t>(std::max<std::int64_t>(late, 0)));
+
+                    std::size_t dueEnd = position + 1;
+                    while (dueEnd < end && dueOf(chunk[dueEnd]) <= now)
+                    {
+                        ++dueEnd;
+                    }
+                    end = dueEnd;
+                }
+
+                if (options.restamp)
+                {
+                    const std::int64_t timestamp = DoorCore::UtcNowTicks();
+                    for (std::size_t i = position; i < end; ++i)
+                    {
+                        chunk[i].timestamp = timestamp;
+                    }
+                }
+
+                sink(std::span<const CanFrame>(chunk.data() + position, end - position));
+                stats.frames += end - position;
+                ++stats.batches;
+                position = end;
+            }
+
+            if (ended)
+            {
+                break;
+            }
+        }
+
+        stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _lastStats = stats;
+        }
+        _running.store(false, std::memory_order_release);
+        return stats;
+    }
+
+    TraceReplayStats TraceReplayer::LastStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _lastStats;
+    }
+
+    void TraceReplayer::Start(TraceReplayOptions options, FrameSink sink)
+    {
+        Stop();
+        _stopping.store(false, std::memory_order_relaxed);
+        _running.store(true, std::memory_order_release);
+        _worker = std::thread([this, options = std::move(options), sink = std::move(sink)]
+        {
+            Replay(options, sink);
+        });
+    }
+
+    void TraceReplayer::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping.store(true, std::memory_order_release);
+        }
+        _wake.notify_all();
+        Wait();
+    }
+
+    void TraceReplayer::Wait()
+    {
+        if (_worker.joinable())
+        {
+            _worker.join();
+        }
+    }
+}
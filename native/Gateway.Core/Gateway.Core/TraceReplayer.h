@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+
+#include "CanFrame.h"
+#include "TraceReader.h"
+
+namespace GatewayCore
+{
+    struct TraceReplayOptions
+    {
+        /// Playback rate relative to recorded time: 1 real time, 10 ten times faster,
+        /// 0 as fast as the sink accepts frames.
+        double speed = 1.0;
+
+        /// Replay window in trace ticks (inclusive start, exclusive end).
+        std::int64_t startTicks = INT64_MIN;
+        std::int64_t endTicks = INT64_MAX;
+
+        TraceIdFilter filter;
+
+        /// Re-stamp frames with the send time instead of the recorded time.
+        bool restamp = false;
+
+        /// Upper bound on frames per sink call.
+        std::size_t maxBatch = 256;
+    };
+
+    struct TraceReplayStats
+    {
+        std::uint64_t frames = 0;
+        std::uint64_t batches = 0;
+        /// Largest delay between a frame's scheduled and actual send time (timed modes).
+        std::uint64_t maxLateMicros = 0;
+        double seconds = 0;
+    };
+
+    /// <summary>
+    /// Replays a mapped trace into a frame sink at recorded pace, N times faster, or flat out.
+    /// </summary>
+    /// <remarks>
+    /// Frames that are due together go to the sink as one batch, so a replay feeds
+    /// ICanBus::SendBatch or FrameDispatcher-style consumers the same way live traffic does.
+    /// The schedule is absolute (trace time mapped onto a steady clock anchor), so a slow
+    /// sink delays frames but never stretches the replay.
+    /// </remarks>
+    class TraceReplayer
+    {
+    public:
+        using FrameSink = std::function<void(std::span<const DoorCore::CanFrame>)>;
+
+        explicit TraceReplayer(const TraceReader& reader);
+        ~TraceReplayer();
+
+        TraceReplayer(const TraceReplayer&) = delete;
+        TraceReplayer& operator=(const TraceReplayer&) = delete;
+
+        /// Replays on the calling thread until the window ends or Stop() is called from
+        /// another thread.
+        TraceReplayStats Run(const TraceReplayOptions& options, const FrameSink& sink);
+
+        /// Replays on a background thread (the reader must outlive it).
+        void Start(TraceReplayOptions options, FrameSink sink);
+        /// Interrupts a replay waiting for its next frame and joins the background thread.
+        void Stop();
+        /// Waits for a background replay to finish on its own.
+        void Wait();
+
+        bool IsRunning() const { return _running.load(std::memory_order_acquire); }
+        /// Statistics of the last replay that finished.
+        TraceReplayStats LastStats() const;
+
+    private:
+        TraceReplayStats Replay(const TraceReplayOptions& options, const FrameSink& sink);
+
+        const TraceReader& _reader;
+        std::atomic<bool> _stopping{ false };
+        std::atomic<bool> _running{ false };
+
+        // Guards _lastStats; Stop() notifies _wake under it so a timed wait cannot miss it.
+        mutable std::mutex _mutex;
+        std::condition_variable _wake;
+        TraceReplayStats _lastStats;
+        std::thread _worker;
+    };
+}
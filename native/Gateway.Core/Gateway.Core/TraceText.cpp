@@ -0,0 +1,732 @@
+#include "pch.h"
+
+#include "TraceText.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+using DoorCore::CanFrame;
+
+namespace GatewayCore::TraceText
+{
+    namespace
+    {
+        constexpr std::int64_t kTicksPerDay = 24LL * 3600 * DoorCore::kTicksPerSecond;
+        /// DateTime(1899-12-30).Ticks: day 0 of OLE automation dates used by $STARTTIME.
+        constexpr std::int64_t kOleEpochTicks = 599'264'352'000'000'000;
+
+        constexpr std::size_t kMaxLine = 4096;
+        constexpr std::size_t kMaxTokens = 96;
+        constexpr std::size_t kImportBatch = 1024;
+        constexpr std::size_t kExportChunk = 4096;
+        constexpr std::size_t kOutputBuffer = 1 << 20;
+
+        constexpr const char* kMonths[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        constexpr const char* kWeekdays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+        // ------------------------------------------------------------------
+        // Calendar helpers (proleptic Gregorian, H. Hinnant's algorithms).
+        // ------------------------------------------------------------------
+
+        std::int64_t DaysFromCivil(std::int64_t y, unsigned m, unsigned d)
+        {
+            y -= m <= 2;
+            const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+            const auto yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+        }
+
+        void CivilFromDays(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d)
+        {
+            z += 719468;
+            const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const auto doe = static_cast<unsigned>(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            d = doy - (153 * mp + 2) / 5 + 1;
+            m = mp < 10 ? mp + 3 : mp - 9;
+            y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+        }
+
+        // ------------------------------------------------------------------
+        // Tokenizing and number parsing.
+        // ------------------------------------------------------------------
+
+        struct Tokens
+        {
+            std::array<std::string_view, kMaxTokens> items;
+            std::size_t count = 0;
+
+            std::string_view operator[](std::size_t i) const { return i < count ? items[i] : std::string_view(); }
+        };
+
+        void Tokenize(std::string_view line, Tokens& tokens)
+        {
+            tokens.count = 0;
+            std::size_t i = 0;
+            while (i < line.size() && tokens.count < kMaxTokens)
+            {
+                while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i])))
+                {
+                    ++i;
+                }
+                const std::size_t start = i;
+                while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i])))
+                {
+                    ++i;
+                }
+                if (i > start)
+                {
+                    tokens.items[tokens.count++] = line.substr(start, i - start);
+                }
+            }
+        }
+
+        template <typename T>
+        bool ParseInt(std::string_view text, T& value, int base)
+        {
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+            return result.ec == std::errc() && result.ptr == text.data() + text.size();
+        }
+
+        bool ParseDouble(std::string_view text, double& value)
+        {
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            return result.ec == std::errc() && result.ptr == text.data() + text.size();
+        }
+
+        bool EqualsNoCase(std::string_view a, std::string_view b)
+        {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+            {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        std::int64_t SecondsToTicks(double seconds)
+        {
+            return static_cast<std::int64_t>(std::llround(seconds * DoorCore::kTicksPerSecond));
+        }
+
+        /// Parses data bytes from tokens[first..]; returns false unless exactly `dlc` hex bytes.
+        bool ParseData(const Tokens& tokens, std::size_t first, std::uint8_t dlc, CanFrame& frame)
+        {
+            if (first + dlc > tokens.count)
+            {
+                return false;
+            }
+            for (std::uint8_t b = 0; b < dlc; ++b)
+            {
+                if (!ParseInt(tokens[first + b], frame.data[b], 16))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // ------------------------------------------------------------------
+        // Line input with batched output to the sink.
+        // ------------------------------------------------------------------
+
+        class LineFile
+        {
+        public:
+            bool Open(const std::string& path, const char* mode, std::string& error)
+            {
+#if defined(_WIN32)
+                if (fopen_s(&_file, path.c_str(), mode) != 0)
+                {
+                    _file = nullptr;
+                }
+#else
+                _file = std::fopen(path.c_str(), mode);
+#endif
+                if (_file == nullptr)
+                {
+                    error = "cannot open '" + path + "': " + std::strerror(errno);
+                    return false;
+                }
+                std::setvbuf(_file, nullptr, _IOFBF, kOutputBuffer);
+                return true;
+            }
+
+            ~LineFile()
+            {
+                if (_file != nullptr)
+                {
+                    std::fclose(_file);
+                }
+            }
+
+            bool ReadLine(std::string_view& line)
+            {
+                if (std::fgets(_line, sizeof(_line), _file) == nullptr)
+                {
+                    return false;
+                }
+                std::size_t length = std::strlen(_line);
+                while (length > 0 && (_line[length - 1] == '\n' || _line[length - 1] == '\r'))
+                {
+                    --length;
+                }
+                line = std::string_view(_line, length);
+                return true;
+            }
+
+            bool Write(std::string_view text)
+            {
+                return std::fwrite(text.data(), 1, text.size(), _file) == text.size();
+            }
+
+            bool Close()
+            {
+                const bool ok = std::fclose(_file) == 0;
+                _file = nullptr;
+                return ok;
+            }
+
+        private:
+            std::FILE* _file = nullptr;
+            char _line[kMaxLine];
+        };
+
+        class BatchSink
+        {
+        public:
+            explicit BatchSink(const FrameSink& sink)
+                : _sink(sink)
+            {
+                _frames.reserve(kImportBatch);
+            }
+
+            void Add(const CanFrame& frame)
+            {
+                _frames.push_back(frame);
+                if (_frames.size() == kImportBatch)
+                {
+                    Flush();
+                }
+            }
+
+            void Flush()
+            {
+                if (!_frames.empty())
+                {
+                    _sink(_frames);
+                    _frames.clear();
+                }
+            }
+
+        private:
+            const FrameSink& _sink;
+            std::vector<CanFrame> _frames;
+        };
+
+        // ------------------------------------------------------------------
+        // Vector .asc
+        // ------------------------------------------------------------------
+
+        /// "date Fri Oct 16 03:04:05.123 pm 2026" (weekday, am/pm and milliseconds optional).
+        bool ParseAscDate(const Tokens& tokens, std::int64_t& ticks)
+        {
+            std::size_t i = 1;
+            if (tokens[i].size() == 3 && std::any_of(std::begin(kWeekdays), std::end(kWeekdays), [&](const char* w) { return EqualsNoCase(tokens[i], w); }))
+            {
+                ++i;
+            }
+
+            unsigned month = 0;
+            for (unsigned m = 0; m < 12; ++m)
+            {
+                if (EqualsNoCase(tokens[i], kMonths[m]))
+                {
+                    month = m + 1;
+                }
+            }
+            unsigned day = 0;
+            if (month == 0 || !ParseInt(tokens[i + 1], day, 10))
+            {
+                return false;
+            }
+
+            const std::string_view time = tokens[i + 2];
+            unsigned hour = 0;
+            unsigned minute = 0;
+            double second = 0;
+            if (time.size() < 8 || !ParseInt(time.substr(0, 2), hour, 10) || !ParseInt(time.substr(3, 2), minute, 10) || !ParseDouble(time.substr(6), second))
+            {
+                return false;
+            }
+
+            std::size_t next = i + 3;
+            if (EqualsNoCase(tokens[next], "am") || EqualsNoCase(tokens[next], "pm"))
+            {
+                const bool pm = EqualsNoCase(tokens[next], "pm");
+                hour = hour % 12 + (pm ? 12 : 0);
+                ++next;
+            }
+
+            std::int64_t year = 0;
+            if (!ParseInt(tokens[next], year, 10))
+            {
+                return false;
+            }
+
+            ticks = DoorCore::kUnixEpochTicks
+                + DaysFromCivil(year, month, day) * kTicksPerDay
+                + (static_cast<std::int64_t>(hour) * 3600 + minute * 60) * DoorCore::kTicksPerSecond
+                + SecondsToTicks(second);
+            return true;
+        }
+
+        bool ImportAsc(LineFile& file, BatchSink& sink, ImportResult& result)
+        {
+            std::int64_t base = DoorCore::kUnixEpochTicks;
+            int idBase = 16;
+            bool relative = false;
+            std::int64_t previous = 0;
+
+            Tokens tokens;
+            std::string_view line;
+            while (file.ReadLine(line))
+            {
+                Tokenize(line, tokens);
+                if (tokens.count == 0)
+                {
+                    continue;
+                }
+
+                double seconds;
+                if (!ParseDouble(tokens[0], seconds))
+                {
+                    if (tokens[0] == "date")
+                    {
+                        ParseAscDate(tokens, base);
+                    }
+                    else if (tokens[0] == "base")
+                    {
+                        idBase = tokens[1] == "dec" ? 10 : 16;
+                        relative = tokens[3] == "relative";
+                    }
+                    continue;
+                }
+
+                // <time> <channel> <id>[x] <Rx|Tx> d <dlc> <data...>
+                std::uint8_t channel;
+                if (!ParseInt(tokens[1], channel, 10) || tokens[4] != "d")
+                {
+                    if (tokens.count > 2 && tokens[1] != "Start")
+                    {
+                        ++result.skipped;
+                    }
+                    continue;
+                }
+
+                std::string_view idText = tokens[2];
+                if (!idText.empty() && (idText.back() == 'x' || idText.back() == 'X'))
+                {
+                    idText.remove_suffix(1);
+                }
+
+                CanFrame frame{};
+                std::uint8_t dlc;
+                if (!ParseInt(idText, frame.id, idBase) || !ParseInt(tokens[5], dlc, 10) || dlc > DoorCore::kMaxDlc || !ParseData(tokens, 6, dlc, frame))
+                {
+                    ++result.skipped;
+                    continue;
+                }
+
+                const std::int64_t offset = SecondsToTicks(seconds);
+                previous = relative ? previous + offset : offset;
+                frame.dlc = dlc;
+                frame.timestamp = base + previous;
+                sink.Add(frame);
+                ++result.frames;
+            }
+            return true;
+        }
+
+        std::string FormatAscDate(std::int64_t ticks)
+        {
+            const std::int64_t sinceEpoch = ticks - DoorCore::kUnixEpochTicks;
+            std::int64_t days = sinceEpoch / kTicksPerDay;
+            std::int64_t rest = sinceEpoch % kTicksPerDay;
+            if (rest < 0)
+            {
+                rest += kTicksPerDay;
+                --days;
+            }
+
+            std::int64_t year;
+            unsigned month;
+            unsigned day;
+            CivilFromDays(days, year, month, day);
+            const int weekday = static_cast<int>(((days % 7) + 11) % 7); // 1970-01-01 was a Thursday
+
+            const int hour = static_cast<int>(rest / (3600 * DoorCore::kTicksPerSecond));
+            const int minute = static_cast<int>(rest / (60 * DoorCore::kTicksPerSecond) % 60);
+            const int second = static_cast<int>(rest / DoorCore::kTicksPerSecond % 60);
+            const int millisecond = static_cast<int>(rest / DoorCore::kTicksPerMillisecond % 1000);
+
+            char text[64];
+            std::snprintf(text, sizeof(text), "%s %s %02u %02d:%02d:%02d.%03d %s %lld",
+                kWeekdays[weekday],
+                kMonths[month - 1],
+                day,
+                hour % 12 == 0 ? 12 : hour % 12,
+                minute,
+                second,
+                millisecond,
+                hour < 12 ? "am" : "pm",
+                static_cast<long long>(year));
+            return text;
+        }
+
+        // ------------------------------------------------------------------
+        // PEAK .trc
+        // ------------------------------------------------------------------
+
+        struct TrcLayout
+        {
+            double version = 1.1;
+            std::string columns = "NOTIdlD";
+        };
+
+        bool IsDirection(std::string_view token)
+        {
+            return token == "Rx" || token == "Tx";
+        }
+
+        /// Version 1.x: "N) offset [bus] [Rx|Tx] id [-] dlc data..."
+        bool ParseTrcV1(const Tokens& tokens, std::int64_t start, CanFrame& frame)
+        {
+            double offsetMs;
+            if (tokens[0].empty() || tokens[0].back() != ')' || !ParseDouble(tokens[1], offsetMs))
+            {
+                return false;
+            }
+
+            std::size_t i = 2;
+            std::uint8_t bus;
+            if (ParseInt(tokens[i], bus, 10) && IsDirection(tokens[i + 1]))
+            {
+                ++i;
+            }
+            if (IsDirection(tokens[i]))
+            {
+                ++i;
+            }
+
+            // Status records (Warng, Error, ...) fail here.
+            if (!ParseInt(tokens[i], frame.id, 16))
+            {
+                return false;
+            }
+            ++i;
+            if (tokens[i] == "-")
+            {
+                ++i;
+            }
+
+            std::uint8_t dlc;
+            if (!ParseInt(tokens[i], dlc, 10) || dlc > DoorCore::kMaxDlc || !ParseData(tokens, i + 1, dlc, frame))
+            {
+                return false;
+            }
+
+            frame.dlc = dlc;
+            frame.timestamp = start + SecondsToTicks(offsetMs / 1000.0);
+            return true;
+        }
+
+        /// Version 2.x: one token per $COLUMNS entry, data bytes last.
+        bool ParseTrcV2(const Tokens& tokens, const TrcLayout& layout, std::int64_t start, CanFrame& frame)
+        {
+            double offsetMs = 0;
+            std::uint8_t dlc = 0;
+            bool haveId = false;
+            std::size_t t = 0;
+            for (char column : layout.columns)
+            {
+                const std::string_view token = tokens[t];
+                switch (column)
+                {
+                case 'N':
+                    break;
+                case 'O':
+                    if (!ParseDouble(token, offsetMs))
+                    {
+                        return false;
+                    }
+                    break;
+                case 'T':
+                    if (token != "DT" && token != "FD")
+                    {
+                        return false;
+                    }
+                    break;
+                case 'I':
+                    haveId = ParseInt(token, frame.id, 16);
+                    break;
+                case 'l':
+                case 'L':
+                    if (!ParseInt(token, dlc, 10) || dlc > DoorCore::kMaxDlc)
+                    {
+                        return false;
+                    }
+                    break;
+                case 'D':
+                    if (!haveId || !ParseData(tokens, t, dlc, frame))
+                    {
+                        return false;
+                    }
+                    frame.dlc = dlc;
+                    frame.timestamp = start + SecondsToTicks(offsetMs / 1000.0);
+                    return true;
+                default:
+                    // B (bus), d (direction), R (reserved), ...: one token, ignored.
+                    break;
+                }
+                ++t;
+            }
+            return false;
+        }
+
+        bool ImportTrc(LineFile& file, BatchSink& sink, ImportResult& result)
+        {
+            TrcLayout layout;
+            std::int64_t start = DoorCore::kUnixEpochTicks;
+
+            Tokens tokens;
+            std::string_view line;
+            while (file.ReadLine(line))
+            {
+                if (line.empty())
+                {
+                    continue;
+                }
+
+                if (line[0] == ';')
+                {
+                    const auto value = [&](std::string_view key) -> std::string_view
+                    {
+                        const std::size_t at = line.find(key);
+                        return at == std::string_view::npos ? std::string_view() : line.substr(at + key.size());
+                    };
+
+                    double number;
+                    if (const std::string_view v = value("$FILEVERSION="); !v.empty() && ParseDouble(v, number))
+                    {
+                        layout.version = number;
+                        if (number >= 2.0)
+                        {
+                            layout.columns = "NOTIdlD";
+                        }
+                    }
+                    else if (const std::string_view s = value("$STARTTIME="); !s.empty() && ParseDouble(s, number))
+                    {
+                        start = kOleEpochTicks + static_cast<std::int64_t>(std::llround(number * static_cast<double>(kTicksPerDay)));
+                    }
+                    else if (const std::string_view c = value("$COLUMNS="); !c.empty())
+                    {
+                        layout.columns.clear();
+                        for (char ch : c)
+                        {
+                            if (std::isalpha(static_cast<unsigned char>(ch)))
+                            {
+                                layout.columns.push_back(ch);
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                Tokenize(line, tokens);
+                if (tokens.count == 0)
+                {
+                    continue;
+                }
+
+                CanFrame frame{};
+                const bool parsed = layout.version >= 2.0
+                    ? ParseTrcV2(tokens, layout, start, frame)
+                    : ParseTrcV1(tokens, start, frame);
+                if (!parsed)
+                {
+                    ++result.skipped;
+                    continue;
+                }
+
+                sink.Add(frame);
+                ++result.frames;
+            }
+            return true;
+        }
+
+        // ------------------------------------------------------------------
+        // Export
+        // ------------------------------------------------------------------
+
+        char* PutHexByte(char* out, std::uint8_t value)
+        {
+            static constexpr char kHex[] = "0123456789ABCDEF";
+            out[0] = kHex[value >> 4];
+            out[1] = kHex[value & 0xF];
+            return out + 2;
+        }
+
+        std::size_t FormatId(char* out, std::uint32_t id, bool ascSuffix)
+        {
+            // Extended IDs: 'x' suffix in .asc, 8 digits in .trc.
+            const bool extended = id > DoorCore::kStandardIdMask;
+            const int n = ascSuffix
+                ? std::snprintf(out, 16, "%X%s", id, extended ? "x" : "")
+                : std::snprintf(out, 16, extended ? "%08X" : "%04X", id);
+            return static_cast<std::size_t>(n);
+        }
+    }
+
+    bool FormatFromPath(const std::string& path, Format& format)
+    {
+        const std::size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos)
+        {
+            return false;
+        }
+        const std::string_view extension(path.data() + dot + 1, path.size() - dot - 1);
+        if (EqualsNoCase(extension, "asc"))
+        {
+            format = Format::Asc;
+            return true;
+        }
+        if (EqualsNoCase(extension, "trc"))
+        {
+            format = Format::Trc;
+            return true;
+        }
+        return false;
+    }
+
+    bool Import(const std::string& path, Format format, const FrameSink& sink, ImportResult& result, std::string& error)
+    {
+        result = {};
+        LineFile file;
+        if (!file.Open(path, "rb", error))
+        {
+            return false;
+        }
+
+        BatchSink batch(sink);
+        const bool ok = format == Format::Asc ? ImportAsc(file, batch, result) : ImportTrc(file, batch, result);
+        batch.Flush();
+        return ok;
+    }
+
+    bool Export(const TraceReader& reader, const std::string& path, Format format, const TraceIdFilter& filter, std::uint64_t& frames, std::string& error)
+    {
+        frames = 0;
+        LineFile file;
+        if (!file.Open(path, "wb", error))
+        {
+            return false;
+        }
+
+        // Offsets are written against the start time as the header can express it, so an
+        // import reproduces the original timestamps to the offset resolution.
+        std::int64_t start = reader.FirstTimestamp();
+        std::string header;
+        if (format == Format::Asc)
+        {
+            start -= ((start - DoorCore::kUnixEpochTicks) % DoorCore::kTicksPerMillisecond + DoorCore::kTicksPerMillisecond) % DoorCore::kTicksPerMillisecond;
+            const std::string date = FormatAscDate(start);
+            header = "date " + date + "\nbase hex  timestamps absolute\nno internal events logged\n// version 7.0.0\n"
+                "Begin Triggerblock " + date + "\n   0.000000 Start of measurement\n";
+        }
+        else
+        {
+            char startTime[64];
+            std::snprintf(startTime, sizeof(startTime), "%.10f", static_cast<double>(start - kOleEpochTicks) / static_cast<double>(kTicksPerDay));
+            double days = 0;
+            ParseDouble(startTime, days);
+            start = kOleEpochTicks + static_cast<std::int64_t>(std::llround(days * static_cast<double>(kTicksPerDay)));
+            header = std::string(";$FILEVERSION=2.1\n;$STARTTIME=") + startTime + "\n;$COLUMNS=N,O,T,I,d,l,D\n;\n"
+                ";   Exported by Gateway.Core\n"
+                ";   Message   Time    Type ID     Rx/Tx\n"
+                ";   Number    Offset  |    [hex]  |  Data Length\n"
+                ";   |         [ms]    |    |      |  |  Data [hex] ...\n"
+                ";   |         |       |    |      |  |  |\n"
+                ";---+-- ------+------ +- --+----- +- +- +- -- -- -- -- -- -- --\n";
+        }
+        bool ok = file.Write(header);
+
+        TraceCursor cursor(reader, filter);
+        std::vector<CanFrame> chunk(kExportChunk);
+        std::vector<char> text(kExportChunk * 96);
+        while (ok)
+        {
+            const std::size_t count = cursor.Read(chunk);
+            if (count == 0)
+            {
+                break;
+            }
+
+            char* out = text.data();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const CanFrame& frame = chunk[i];
+                const std::uint8_t dlc = DoorCore::ClampDlc(frame.dlc);
+                char id[16];
+                const std::size_t idLength = FormatId(id, frame.id, format == Format::Asc);
+
+                if (format == Format::Asc)
+                {
+                    out += std::snprintf(out, 64, "%11.6f 1  %-15.*s Rx   d %u",
+                        static_cast<double>(frame.timestamp - start) / DoorCore::kTicksPerSecond,
+                        static_cast<int>(idLength), id,
+                        dlc);
+                }
+                else
+                {
+                    out += std::snprintf(out, 64, "%7llu %13.3f DT %8.*s Rx %2u   ",
+                        static_cast<unsigned long long>(frames + i + 1),
+                        static_cast<double>(frame.timestamp - start) / DoorCore::kTicksPerMillisecond,
+                        static_cast<int>(idLength), id,
+                        dlc);
+                }
+
+                for (std::uint8_t b = 0; b < dlc; ++b)
+                {
+                    *out++ = ' ';
+                    out = PutHexByte(out, frame.data[b]);
+                }
+                *out++ = '\n';
+            }
+
+            ok = file.Write({ text.data(), static_cast<std::size_t>(out - text.data()) });
+            frames += count;
+        }
+
+        if (ok && format == Format::Asc)
+        {
+            ok = file.Write("End TriggerBlock\n");
+        }
+        if (!file.Close() || !ok)
+        {
+            error = "write to '" + path + "' failed: " + std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+}
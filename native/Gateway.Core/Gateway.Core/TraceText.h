@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+
+#include "CanFrame.h"
+#include "TraceReader.h"
+
+namespace GatewayCore
+{
+    /// <summary>
+    /// Import/export between binary traces and the common ASCII trace formats.
+    /// </summary>
+    /// <remarks>
+    /// .asc is the Vector CANalyzer/CANoe log (classic CAN lines, hex or dec base, absolute or
+    /// relative timestamps). .trc is the PEAK PCAN-View trace, file versions 1.0-1.3 and
+    /// 2.0-2.1 (column layout taken from $COLUMNS). Both formats store local wall-clock start
+    /// times without a zone; they are read and written as UTC.
+    ///
+    /// Only classic data frames are imported. Error frames, remote frames, events and CAN FD
+    /// frames with more than 8 data bytes are counted as skipped.
+    /// </remarks>
+    namespace TraceText
+    {
+        enum class Format
+        {
+            Asc,
+            Trc
+        };
+
+        /// Picks the format from the file extension (.asc or .trc, any case).
+        bool FormatFromPath(const std::string& path, Format& format);
+
+        struct ImportResult
+        {
+            std::uint64_t frames = 0;
+            /// Records that are not classic data frames, or lines that failed to parse.
+            std::uint64_t skipped = 0;
+        };
+
+        using FrameSink = std::function<void(std::span<const DoorCore::CanFrame>)>;
+
+        /// Parses a text trace and hands its frames to `sink` in batches (e.g. a TraceWriter's
+        /// AppendBatch). Returns false and fills error if the file cannot be read.
+        bool Import(const std::string& path, Format format, const FrameSink& sink, ImportResult& result, std::string& error);
+
+        /// Writes the frames of `reader` accepted by `filter` as a text trace.
+        bool Export(const TraceReader& reader, const std::string& path, Format format, const TraceIdFilter& filter, std::uint64_t& frames, std::string& error);
+    }
+}
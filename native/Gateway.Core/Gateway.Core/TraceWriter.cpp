@@ -0,0 +1,335 @@
+#include "pch.h"
+
+#include "TraceWriter.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+using DoorCore::Bump;
+using DoorCore::CanFrame;
+
+namespace GatewayCore
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+        using Ticks = std::chrono::duration<std::int64_t, std::ratio<1, DoorCore::kTicksPerSecond>>;
+
+        /// Wall time after which the I/O thread seals an idle block; capped so huge spans
+        /// do not overflow the clock.
+        Clock::duration IdleSealAfter(const TraceWriterOptions& options)
+        {
+            return std::chrono::duration_cast<Clock::duration>(Ticks(std::min<std::int64_t>(options.maxBlockSpanTicks, 3600 * DoorCore::kTicksPerSecond)));
+        }
+
+        /// stdio buffer for the trace file; blocks are written whole, so this mostly
+        /// coalesces small header writes with their payload.
+        constexpr std::size_t kFileBufferBytes = 1 << 20;
+    }
+
+    TraceWriter::~TraceWriter()
+    {
+        std::string ignored;
+        Close(ignored);
+    }
+
+    bool TraceWriter::Open(const std::string& path, const TraceWriterOptions& options, std::string& error)
+    {
+        std::string ignored;
+        Close(ignored);
+
+        _options = options;
+        if (_options.queueBlocks == 0)
+        {
+            _options.queueBlocks = 1;
+        }
+
+#if defined(_WIN32)
+        if (fopen_s(&_file, path.c_str(), "wb") != 0)
+        {
+            _file = nullptr;
+        }
+#else
+        _file = std::fopen(path.c_str(), "wb");
+#endif
+        if (_file == nullptr)
+        {
+            error = "cannot create '" + path + "': " + std::strerror(errno);
+            return false;
+        }
+        std::setvbuf(_file, nullptr, _IOFBF, kFileBufferBytes);
+
+        _failed.store(false, std::memory_order_relaxed);
+        _error.clear();
+        _frames.store(0, std::memory_order_relaxed);
+        _blocksWritten.store(0, std::memory_order_relaxed);
+        _bytesWritten.store(0, std::memory_order_relaxed);
+        _stalls.store(0, std::memory_order_relaxed);
+        _index.clear();
+        _offset = 0;
+
+        TraceFormat::FileHeader header{};
+        header.magic = TraceFormat::kFileMagic;
+        header.version = TraceFormat::kVersion;
+        header.blockBytes = static_cast<std::uint32_t>(_options.blockBytes);
+        header.createdTicks = DoorCore::UtcNowTicks();
+        if (!WriteAll(&header, sizeof(header)))
+        {
+            error = _error;
+            std::fclose(_file);
+            _file = nullptr;
+            return false;
+        }
+
+        // One buffer being filled, queueBlocks waiting for or in I/O.
+        _blocks.clear();
+        _free.clear();
+        _pending.clear();
+        for (std::size_t i = 0; i <= _options.queueBlocks; ++i)
+        {
+            _blocks.push_back(std::make_unique<Block>(_options.blockBytes));
+            _free.push_back(_blocks.back().get());
+        }
+        _current = _free.front();
+        _free.pop_front();
+
+        _closing = false;
+        _io = std::thread([this] { RunIo(); });
+        return true;
+    }
+
+    bool TraceWriter::Append(const CanFrame& frame)
+    {
+        return AppendBatch({ &frame, 1 });
+    }
+
+    bool TraceWriter::AppendBatch(std::span<const CanFrame> frames)
+    {
+        std::lock_guard<std::mutex> append(_appendMutex);
+        if (_current == nullptr)
+        {
+            return false;
+        }
+
+        for (const CanFrame& frame : frames)
+        {
+            TraceFormat::BlockEncoder& encoder = _current->encoder;
+            if (!encoder.HasRoom()
+                || (_options.maxBlockSpanTicks > 0 && !encoder.Empty() && frame.timestamp - encoder.FirstTimestamp() > _options.maxBlockSpanTicks))
+            {
+                Seal();
+            }
+            if (_current->encoder.Empty())
+            {
+                _currentOpened = Clock::now();
+            }
+            _current->encoder.Append(frame);
+        }
+
+        Bump(_frames, frames.size());
+        return !_failed.load(std::memory_order_relaxed);
+    }
+
+    void TraceWriter::Flush()
+    {
+        std::lock_guard<std::mutex> append(_appendMutex);
+        if (_current != nullptr && !_current->encoder.Empty())
+        {
+            Seal();
+        }
+    }
+
+    void TraceWriter::Seal()
+    {
+        // Caller holds _appendMutex.
+        _current->encoder.Seal();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _pending.push_back(_current);
+        _ioReady.notify_one();
+
+        if (_free.empty())
+        {
+            Bump(_stalls, 1);
+            _bufferReady.wait(lock, [this] { return !_free.empty(); });
+        }
+        _current = _free.front();
+        _free.pop_front();
+    }
+
+    void TraceWriter::SealIdle()
+    {
+        // An appender that is busy seals by trace time on its own.
+        std::unique_lock<std::mutex> append(_appendMutex, std::try_to_lock);
+        if (!append.owns_lock() || _current->encoder.Empty() || Clock::now() - _currentOpened < IdleSealAfter(_options))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_free.empty())
+        {
+            return;
+        }
+        _current->encoder.Seal();
+        _pending.push_back(_current);
+        _current = _free.front();
+        _free.pop_front();
+    }
+
+    void TraceWriter::RunIo()
+    {
+        const auto ready = [this] { return !_pending.empty() || _closing; };
+        const Clock::duration idleSealAfter = IdleSealAfter(_options);
+        for (;;)
+        {
+            Block* block = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_options.maxBlockSpanTicks > 0)
+                {
+                    if (!_ioReady.wait_for(lock, idleSealAfter, ready))
+                    {
+                        lock.unlock();
+                        SealIdle();
+                        continue;
+                    }
+                }
+                else
+                {
+                    _ioReady.wait(lock, ready);
+                }
+                if (_pending.empty())
+                {
+                    return;
+                }
+                block = _pending.front();
+                _pending.pop_front();
+            }
+
+            TraceFormat::BlockEncoder& encoder = block->encoder;
+            const TraceFormat::BlockHeader& header = encoder.Header();
+            const std::span<const std::uint8_t> payload = encoder.Payload();
+
+            if (!_failed.load(std::memory_order_relaxed))
+            {
+                const std::uint64_t offset = _offset;
+                if (WriteAll(&header, sizeof(header)) && WriteAll(payload.data(), payload.size()))
+                {
+                    _index.push_back({
+                        offset,
+                        header.firstTimestamp,
+                        header.lastTimestamp,
+                        header.frameCount,
+                        header.payloadBytes,
+                        header.minId,
+                        header.maxId });
+                    Bump(_blocksWritten, 1);
+                }
+            }
+
+            encoder.Reset();
+            bool idle;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _free.push_back(block);
+                idle = _pending.empty();
+            }
+            _bufferReady.notify_one();
+
+            // Caught up: push the stdio buffer to the OS so a crash loses at most the
+            // blocks still in flight.
+            if (idle && !_failed.load(std::memory_order_relaxed) && std::fflush(_file) != 0)
+            {
+                Fail(std::string("trace write failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    bool TraceWriter::WriteAll(const void* data, std::size_t size)
+    {
+        if (std::fwrite(data, 1, size, _file) != size)
+        {
+            Fail(std::string("trace write failed: ") + std::strerror(errno));
+            return false;
+        }
+        _offset += size;
+        Bump(_bytesWritten, size);
+        return true;
+    }
+
+    void TraceWriter::Fail(const std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_failed.load(std::memory_order_relaxed))
+        {
+            _error = error;
+            _failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool TraceWriter::Close(std::string& error)
+    {
+        if (_file == nullptr)
+        {
+            return true;
+        }
+
+        Flush();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closing = true;
+        }
+        _ioReady.notify_one();
+        _io.join();
+
+        if (!_failed.load(std::memory_order_relaxed))
+        {
+            TraceFormat::Trailer trailer{};
+            trailer.indexOffset = _offset;
+            trailer.blockCount = _index.size();
+            trailer.frameCount = _frames.load(std::memory_order_relaxed);
+            trailer.magic = TraceFormat::kTrailerMagic;
+            trailer.version = TraceFormat::kVersion;
+
+            if (WriteAll(_index.data(), _index.size() * sizeof(TraceFormat::IndexEntry)))
+            {
+                WriteAll(&trailer, sizeof(trailer));
+            }
+        }
+
+        if (std::fclose(_file) != 0)
+        {
+            Fail(std::string("trace close failed: ") + std::strerror(errno));
+        }
+        _file = nullptr;
+        _current = nullptr;
+        _blocks.clear();
+        _free.clear();
+
+        if (_failed.load(std::memory_order_relaxed))
+        {
+            error = _error;
+            return false;
+        }
+        return true;
+    }
+
+    std::string TraceWriter::LastError() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _error;
+    }
+
+    TraceWriterStats TraceWriter::Stats() const
+    {
+        TraceWriterStats stats;
+        stats.frames = _frames.load(std::memory_order_relaxed);
+        stats.blocks = _blocksWritten.load(std::memory_order_relaxed);
+        stats.bytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+        stats.stalls = _stalls.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CanFrame.h"
+#include "TraceFormat.h"
+
+namespace GatewayCore
+{
+    struct TraceWriterOptions
+    {
+        /// Encoded payload per block. Larger blocks compress the index; smaller ones make
+        /// seeks and crash loss finer.
+        std::size_t blockBytes = 64 * 1024;
+
+        /// Sealed blocks that may wait for the I/O thread before Append() blocks.
+        std::size_t queueBlocks = 16;
+
+        /// A block is sealed once it spans this much trace time. The I/O thread also seals a
+        /// block that has been open this long in wall time while the appender is idle, so the
+        /// frames of a quiet bus reach the disk within about twice this. 0 seals on size only.
+        std::int64_t maxBlockSpanTicks = DoorCore::kTicksPerSecond;
+    };
+
+    struct TraceWriterStats
+    {
+        std::uint64_t frames = 0;
+        std::uint64_t blocks = 0;
+        /// Bytes handed to the OS, including headers and index.
+        std::uint64_t bytesWritten = 0;
+        /// Times Append() waited because every block buffer was queued for I/O.
+        std::uint64_t stalls = 0;
+    };
+
+    /// <summary>
+    /// Records frames into a block-compressed binary trace (see TraceFormat).
+    /// </summary>
+    /// <remarks>
+    /// Append() only encodes into the current block buffer; sealed blocks are handed to a
+    /// dedicated I/O thread through a small pool of buffers, so the caller never waits on the
+    /// disk unless the whole pool is queued. Append/Flush/Close are called from one thread
+    /// (typically the FrameDispatcher handler).
+    /// </remarks>
+    class TraceWriter
+    {
+    public:
+        TraceWriter() = default;
+        ~TraceWriter();
+
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        /// Creates (truncates) the file. Returns false and fills error on failure.
+        bool Open(const std::string& path, const TraceWriterOptions& options, std::string& error);
+
+        /// Returns false before Open() and once the I/O thread has failed; see LastError().
+        bool Append(const DoorCore::CanFrame& frame);
+        bool AppendBatch(std::span<const DoorCore::CanFrame> frames);
+
+        /// Seals the current block and hands it to the I/O thread (does not fsync).
+        void Flush();
+
+        /// Writes the remaining block, the index and the trailer, then closes the file.
+        bool Close(std::string& error);
+
+        bool IsOpen() const { return _file != nullptr; }
+        std::string LastError() const;
+        TraceWriterStats Stats() const;
+
+    private:
+        struct Block
+        {
+            explicit Block(std::size_t capacity)
+                : encoder(capacity)
+            {
+            }
+
+            TraceFormat::BlockEncoder encoder;
+        };
+
+        void Seal();
+        void SealIdle();
+        void RunIo();
+        bool WriteAll(const void* data, std::size_t size);
+        void Fail(const std::string& error);
+
+        std::FILE* _file = nullptr;
+        TraceWriterOptions _options;
+
+        std::vector<std::unique_ptr<Block>> _blocks;
+
+        // Held by the appending thread while it fills _current; the I/O thread only try-locks
+        // it to seal an idle block.
+        std::mutex _appendMutex;
+        Block* _current = nullptr;
+        std::chrono::steady_clock::time_point _currentOpened;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _ioReady;
+        std::condition_variable _bufferReady;
+        std::deque<Block*> _pending;
+        std::deque<Block*> _free;
+        bool _closing = false;
+        std::thread _io;
+
+        // Owned by the I/O thread until it is joined.
+        std::vector<TraceFormat::IndexEntry> _index;
+        std::uint64_t _offset = 0;
+
+        std::atomic<bool> _failed{ false };
+        std::string _error;
+
+        std::atomic<std::uint64_t> _frames{ 0 };
+        std::atomic<std::uint64_t> _blocksWritten{ 0 };
+        std::atomic<std::uint64_t> _bytesWritten{ 0 };
+        std::atomic<std::uint64_t> _stalls{ 0 };
+    };
+}
@@ -0,0 +1,17 @@
+// Hmi.Core.Bench: benchmarks for the Hmi.Core static library.
+//
+// Usage: Hmi.Core.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "table", "Door table apply cost per frame and coalesced deltas vs. per-frame UI updates", HmiCoreBench::RunTableBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Hmi.Core.Bench", kBenchmarks, argc, argv);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HmiCoreBench
+{
+    int RunTableBench(int argc, char** argv);
+}
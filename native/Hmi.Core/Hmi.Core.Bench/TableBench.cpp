@@ -0,0 +1,260 @@
+// Feeds door state frames through DoorTable and a C++ replica of the per-frame UI path in
+// Hmi.Host.MainWindow.OnDoorStateReceived.
+//
+// Usage: Hmi.Core.Bench table [frames] [buses] [frameRateHz] [changePermille]
+//
+// Frames are generated up front (round-robin over all doors, a state flip with the given
+// probability) and stamped at frameRateHz of simulated time, so the refresh cadence and
+// stale detection run against a reproducible clock. The last door of every bus goes silent
+// halfway through to exercise stale detection.
+
+#include "BenchSupport.h"
+
+#include "DoorTable.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+using DoorCore::CanFrame;
+using DoorCore::DoorState;
+using DoorCore::DoorStateFrame;
+using HmiCore::DoorDelta;
+using HmiCore::DoorTable;
+using HmiCore::DoorTableConfig;
+
+namespace
+{
+    constexpr std::size_t kReceiveBatch = 64;
+
+    struct Feed
+    {
+        std::vector<CanFrame> frames;
+        std::vector<std::uint32_t> buses;
+        std::int64_t tickStep = 0;
+    };
+
+    Feed MakeFeed(std::uint64_t count, std::uint32_t buses, std::uint32_t frameRateHz, std::uint32_t changePermille)
+    {
+        Feed feed;
+        feed.frames.resize(static_cast<std::size_t>(count));
+        feed.buses.resize(static_cast<std::size_t>(count));
+        feed.tickStep = std::max<std::int64_t>(1, DoorCore::kTicksPerSecond / frameRateHz);
+
+        const std::uint32_t slots = buses * DoorStateFrame::kMaxDoors;
+        std::vector<DoorState> states(slots, DoorState::Closed);
+        std::uint64_t rng = 0x9E3779B97F4A7C15ULL;
+        std::uint32_t slot = 0;
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+
+            // The last door of each bus stops reporting after the first half.
+            do
+            {
+                slot = (slot + 1) % slots;
+            } while (i > count / 2 && slot % DoorStateFrame::kMaxDoors == DoorStateFrame::kMaxDoors - 1);
+
+            if (rng % 1000 < changePermille)
+            {
+                states[slot] = static_cast<DoorState>((static_cast<std::uint8_t>(states[slot]) + 1 + (rng >> 32) % 2) % 3);
+            }
+
+            const auto doorId = static_cast<std::uint8_t>(slot % DoorStateFrame::kMaxDoors);
+            feed.frames[i] = DoorStateFrame::Create(doorId, states[slot], 0);
+            feed.buses[i] = slot / DoorStateFrame::kMaxDoors;
+        }
+        return feed;
+    }
+
+    // ------------------------------------------------------------------
+    // Replica of MainWindow: linear FindDoor, string state, DateTime.Now formatting and a
+    // dispatched UI update for every frame.
+    // ------------------------------------------------------------------
+
+    struct LegacyDoorViewModel
+    {
+        std::uint32_t bus;
+        std::uint8_t doorId;
+        std::string state;
+        std::string lastUpdated;
+    };
+
+    struct LegacyResult
+    {
+        double seconds;
+        std::uint64_t uiUpdates;
+    };
+
+    LegacyResult RunLegacy(const Feed& feed)
+    {
+        static const char* const kStateNames[] = { "Closed", "Open", "Obstructed" };
+
+        std::vector<LegacyDoorViewModel> doors;
+        std::uint64_t uiUpdates = 0;
+        std::function<void(std::function<void()>)> dispatcherInvoke = [&](std::function<void()> action)
+        {
+            ++uiUpdates;
+            action();
+        };
+
+        BenchCommon::Stopwatch watch;
+        for (std::size_t i = 0; i < feed.frames.size(); ++i)
+        {
+            std::uint8_t doorId;
+            DoorState state;
+            if (!DoorStateFrame::TryParse(feed.frames[i], doorId, state))
+            {
+                continue;
+            }
+
+            const std::uint32_t bus = feed.buses[i];
+            dispatcherInvoke([&]
+            {
+                LegacyDoorViewModel* existing = nullptr;
+                for (LegacyDoorViewModel& door : doors)
+                {
+                    if (door.bus == bus && door.doorId == doorId)
+                    {
+                        existing = &door;
+                        break;
+                    }
+                }
+                if (existing == nullptr)
+                {
+                    doors.push_back({ bus, doorId, "Unknown", "--" });
+                    existing = &doors.back();
+                }
+
+                existing->state = kStateNames[static_cast<std::uint8_t>(state)];
+
+                char text[16];
+                const std::time_t now = std::time(nullptr);
+                std::strftime(text, sizeof(text), "%H:%M:%S", std::localtime(&now));
+                existing->lastUpdated = text;
+            });
+        }
+        return { watch.ElapsedSeconds(), uiUpdates };
+    }
+
+    // ------------------------------------------------------------------
+    // DoorTable: batched apply on the receive side, PollDeltas at the UI refresh rate.
+    // ------------------------------------------------------------------
+
+    struct TableResult
+    {
+        double applySeconds;
+        double collectSeconds;
+        std::uint64_t refreshes;
+        std::uint64_t deltas;
+        std::uint64_t staleDeltas;
+        HmiCore::DoorTableStats stats;
+    };
+
+    TableResult RunTable(const Feed& feed, std::uint32_t buses, std::uint32_t refreshHz)
+    {
+        DoorTableConfig config;
+        config.busCount = buses;
+        config.refreshHz = refreshHz;
+        DoorTable table(config);
+
+        std::vector<DoorDelta> deltas(table.SlotCount());
+        TableResult result{};
+
+        // Split the feed into receive batches (a run of frames from one bus), then interleave
+        // the UI poll between batches as the two threads would.
+        const std::size_t n = feed.frames.size();
+        std::int64_t now = DoorCore::kUnixEpochTicks;
+        std::size_t i = 0;
+        BenchCommon::Stopwatch total;
+        double collect = 0;
+        while (i < n)
+        {
+            std::size_t end = i + 1;
+            while (end < n && end - i < kReceiveBatch && feed.buses[end] == feed.buses[i])
+            {
+                ++end;
+            }
+
+            now += feed.tickStep * static_cast<std::int64_t>(end - i);
+            table.ApplyBatch(feed.buses[i], std::span<const CanFrame>(feed.frames.data() + i, end - i), now);
+            i = end;
+
+            BenchCommon::Stopwatch poll;
+            const std::size_t count = table.PollDeltas(now, deltas);
+            collect += poll.ElapsedSeconds();
+            result.deltas += count;
+            for (std::size_t d = 0; d < count; ++d)
+            {
+                result.staleDeltas += deltas[d].stale ? 1 : 0;
+            }
+        }
+
+        result.collectSeconds = collect;
+        result.applySeconds = total.ElapsedSeconds() - collect;
+        result.stats = table.Stats();
+        result.refreshes = result.stats.collections;
+        return result;
+    }
+}
+
+int HmiCoreBench::RunTableBench(int argc, char** argv)
+{
+    const std::uint64_t frames = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 5'000'000;
+    const std::uint32_t buses = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 4;
+    const std::uint32_t frameRateHz = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100'000;
+    const std::uint32_t changePermille = argc > 3 ? static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 20;
+    if (frames == 0 || buses == 0 || frameRateHz == 0 || changePermille > 1000)
+    {
+        std::fprintf(stderr, "frames, buses and frameRateHz must be > 0; changePermille <= 1000\n");
+        return 1;
+    }
+
+    const Feed feed = MakeFeed(frames, buses, frameRateHz, changePermille);
+    const double simulated = static_cast<double>(frames) * feed.tickStep / DoorCore::kTicksPerSecond;
+    std::printf("table: %llu frames, %u buses (%u doors), %u frames/s simulated (%.1f s), %u/1000 state changes\n\n",
+        static_cast<unsigned long long>(frames),
+        buses,
+        buses * DoorStateFrame::kMaxDoors,
+        frameRateHz,
+        simulated,
+        changePermille);
+
+    const LegacyResult legacy = RunLegacy(feed);
+    std::printf("%-22s %10.2f ns/frame  %12llu UI updates\n",
+        "legacy (MainWindow)",
+        legacy.seconds * 1e9 / static_cast<double>(frames),
+        static_cast<unsigned long long>(legacy.uiUpdates));
+
+    for (std::uint32_t refreshHz : { 30u, 60u })
+    {
+        const TableResult table = RunTable(feed, buses, refreshHz);
+        char name[32];
+        std::snprintf(name, sizeof(name), "DoorTable @ %u Hz", refreshHz);
+        std::printf("%-22s %10.2f ns/frame  %12llu deltas (%llu stale) from %llu state changes, "
+                    "%llu refreshes, %.2f us/refresh, %.1fx fewer UI updates\n",
+            name,
+            table.applySeconds * 1e9 / static_cast<double>(frames),
+            static_cast<unsigned long long>(table.deltas),
+            static_cast<unsigned long long>(table.staleDeltas),
+            static_cast<unsigned long long>(table.stats.stateChanges),
+            static_cast<unsigned long long>(table.refreshes),
+            table.refreshes == 0 ? 0.0 : table.collectSeconds * 1e6 / static_cast<double>(table.refreshes),
+            static_cast<double>(legacy.uiUpdates) / static_cast<double>(std::max<std::uint64_t>(table.deltas, 1)));
+
+        if (table.stats.framesApplied != frames || table.stats.framesRejected != 0)
+        {
+            std::printf("FAIL: applied %llu of %llu frames\n",
+                static_cast<unsigned long long>(table.stats.framesApplied),
+                static_cast<unsigned long long>(frames));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include "pch.h"
+
+#include "DoorTable.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <bit>
+
+using DoorCore::Bump;
+using DoorCore::CanFrame;
+using DoorCore::DoorState;
+using DoorCore::DoorStateFrame;
+
+namespace HmiCore
+{
+    namespace
+    {
+        constexpr std::size_t kBitsPerWord = 64;
+    }
+
+    DoorTable::DoorTable(DoorTableConfig config)
+        : _config(config)
+    {
+        _config.busCount = std::max<std::uint32_t>(_config.busCount, 1);
+        _config.refreshHz = std::max<std::uint32_t>(_config.refreshHz, 1);
+
+        _slotCount = static_cast<std::size_t>(_config.busCount) * DoorStateFrame::kMaxDoors;
+        _wordCount = (_slotCount + kBitsPerWord - 1) / kBitsPerWord;
+        _refreshIntervalTicks = DoorCore::kTicksPerSecond / _config.refreshHz;
+
+        _state = std::make_unique<std::atomic<std::uint8_t>[]>(_slotCount);
+        _lastSeen = std::make_unique<std::atomic<std::int64_t>[]>(_slotCount);
+        _lastChange = std::make_unique<std::atomic<std::int64_t>[]>(_slotCount);
+        _changes = std::make_unique<std::atomic<std::uint32_t>[]>(_slotCount);
+        _dirty = std::make_unique<std::atomic<std::uint64_t>[]>(_wordCount);
+        for (std::size_t slot = 0; slot < _slotCount; ++slot)
+        {
+            _state[slot].store(kUnknown, std::memory_order_relaxed);
+            _lastSeen[slot].store(0, std::memory_order_relaxed);
+            _lastChange[slot].store(0, std::memory_order_relaxed);
+            _changes[slot].store(0, std::memory_order_relaxed);
+        }
+        for (std::size_t word = 0; word < _wordCount; ++word)
+        {
+            _dirty[word].store(0, std::memory_order_relaxed);
+        }
+
+        _reportedStale.assign(_slotCount, 0);
+        _reportedChanges.assign(_slotCount, 0);
+    }
+
+    bool DoorTable::ApplyParsed(std::size_t slot, DoorState state, std::int64_t receivedTicks)
+    {
+        _lastSeen[slot].store(receivedTicks, std::memory_order_relaxed);
+
+        const auto value = static_cast<std::uint8_t>(state);
+        if (_state[slot].load(std::memory_order_relaxed) == value)
+        {
+            return false;
+        }
+
+        _state[slot].store(value, std::memory_order_relaxed);
+        _lastChange[slot].store(receivedTicks, std::memory_order_relaxed);
+        _changes[slot].store(_changes[slot].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        // Release publishes the stores above to the collector that clears this bit. Always
+        // RMW: skipping the write when the bit looks set races with the collector's exchange.
+        const std::uint64_t bit = std::uint64_t{ 1 } << (slot % kBitsPerWord);
+        _dirty[slot / kBitsPerWord].fetch_or(bit, std::memory_order_release);
+        return true;
+    }
+
+    bool DoorTable::Apply(std::uint32_t bus, const CanFrame& frame, std::int64_t receivedTicks)
+    {
+        std::uint8_t doorId;
+        DoorState state;
+        if (bus >= _config.busCount || !DoorStateFrame::TryParse(frame, doorId, state))
+        {
+            Bump(_framesRejected, 1);
+            return false;
+        }
+
+        Bump(_framesApplied, 1);
+        const bool changed = ApplyParsed(Slot(bus, doorId), state, receivedTicks);
+        if (changed)
+        {
+            Bump(_stateChanges, 1);
+        }
+        return changed;
+    }
+
+    std::size_t DoorTable::ApplyBatch(std::uint32_t bus, std::span<const CanFrame> frames, std::int64_t receivedTicks)
+    {
+        if (bus >= _config.busCount)
+        {
+            Bump(_framesRejected, frames.size());
+            return 0;
+        }
+
+        std::size_t applied = 0;
+        std::uint64_t changed = 0;
+        for (const CanFrame& frame : frames)
+        {
+            std::uint8_t doorId;
+            DoorState state;
+            if (!DoorStateFrame::TryParse(frame, doorId, state))
+            {
+                continue;
+            }
+
+            ++applied;
+            changed += ApplyParsed(Slot(bus, doorId), state, receivedTicks) ? 1 : 0;
+        }
+
+        Bump(_framesApplied, applied);
+        Bump(_framesRejected, frames.size() - applied);
+        Bump(_stateChanges, changed);
+        return applied;
+    }
+
+    bool DoorTable::EmitDelta(std::size_t slot, std::int64_t nowTicks, std::span<DoorDelta> out, std::size_t& count)
+    {
+        if (count == out.size())
+        {
+            return false;
+        }
+
+        const std::uint8_t state = _state[slot].load(std::memory_order_relaxed);
+        const std::int64_t lastSeen = _lastSeen[slot].load(std::memory_order_relaxed);
+        const std::uint32_t changes = _changes[slot].load(std::memory_order_relaxed);
+        const bool stale = _config.staleAfterTicks > 0 && nowTicks - lastSeen > _config.staleAfterTicks;
+
+        DoorDelta& delta = out[count++];
+        delta.bus = static_cast<std::uint16_t>(slot / DoorStateFrame::kMaxDoors);
+        delta.doorId = static_cast<std::uint8_t>(slot % DoorStateFrame::kMaxDoors);
+        delta.state = static_cast<DoorState>(state);
+        delta.stale = stale;
+        delta.lastChange = _lastChange[slot].load(std::memory_order_relaxed);
+        delta.lastSeen = lastSeen;
+        delta.changes = changes - _reportedChanges[slot];
+
+        _reportedStale[slot] = stale ? 1 : 0;
+        _reportedChanges[slot] = changes;
+        return true;
+    }
+
+    std::size_t DoorTable::CollectDeltas(std::int64_t nowTicks, std::span<DoorDelta> out)
+    {
+        std::size_t count = 0;
+
+        for (std::size_t w = 0; w < _wordCount; ++w)
+        {
+            if (_dirty[w].load(std::memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+
+            std::uint64_t bits = _dirty[w].exchange(0, std::memory_order_acquire);
+            while (bits != 0)
+            {
+                const std::size_t slot = w * kBitsPerWord + static_cast<std::size_t>(std::countr_zero(bits));
+                if (!EmitDelta(slot, nowTicks, out, count))
+                {
+                    // Out of room: hand the untaken bits back for the next collection.
+                    _dirty[w].fetch_or(bits, std::memory_order_relaxed);
+                    Bump(_deltasEmitted, count);
+                    Bump(_collections, 1);
+                    return count;
+                }
+                bits &= bits - 1;
+            }
+        }
+
+        // Stale transitions (either way) of doors whose state did not change.
+        if (_config.staleAfterTicks > 0)
+        {
+            for (std::size_t slot = 0; slot < _slotCount && count < out.size(); ++slot)
+            {
+                if (_state[slot].load(std::memory_order_relaxed) == kUnknown)
+                {
+                    continue;
+                }
+
+                const bool stale = nowTicks - _lastSeen[slot].load(std::memory_order_relaxed) > _config.staleAfterTicks;
+                if (stale != (_reportedStale[slot] != 0))
+                {
+                    EmitDelta(slot, nowTicks, out, count);
+                }
+            }
+        }
+
+        Bump(_deltasEmitted, count);
+        Bump(_collections, 1);
+        return count;
+    }
+
+    std::size_t DoorTable::PollDeltas(std::int64_t nowTicks, std::span<DoorDelta> out)
+    {
+        if (nowTicks < _nextRefresh)
+        {
+            return 0;
+        }
+
+        // Schedule from the due time so the cadence does not drift. When behind (first poll,
+        // a stalled UI thread), restart the cadence from now instead of collecting again at once.
+        const std::int64_t due = _nextRefresh + _refreshIntervalTicks;
+        _nextRefresh = due > nowTicks ? due : nowTicks + _refreshIntervalTicks;
+        return CollectDeltas(nowTicks, out);
+    }
+
+    bool DoorTable::IsKnown(std::uint32_t bus, std::uint8_t doorId) const
+    {
+        return bus < _config.busCount && _state[Slot(bus, doorId)].load(std::memory_order_relaxed) != kUnknown;
+    }
+
+    DoorState DoorTable::State(std::uint32_t bus, std::uint8_t doorId) const
+    {
+        const std::uint8_t state = IsKnown(bus, doorId) ? _state[Slot(bus, doorId)].load(std::memory_order_relaxed) : 0;
+        return static_cast<DoorState>(state);
+    }
+
+    std::int64_t DoorTable::LastSeen(std::uint32_t bus, std::uint8_t doorId) const
+    {
+        return bus < _config.busCount ? _lastSeen[Slot(bus, doorId)].load(std::memory_order_relaxed) : 0;
+    }
+
+    std::int64_t DoorTable::LastChange(std::uint32_t bus, std::uint8_t doorId) const
+    {
+        return bus < _config.busCount ? _lastChange[Slot(bus, doorId)].load(std::memory_order_relaxed) : 0;
+    }
+
+    DoorTableStats DoorTable::Stats() const
+    {
+        DoorTableStats stats;
+        stats.framesApplied = _framesApplied.load(std::memory_order_relaxed);
+        stats.framesRejected = _framesRejected.load(std::memory_order_relaxed);
+        stats.stateChanges = _stateChanges.load(std::memory_order_relaxed);
+        stats.deltasEmitted = _deltasEmitted.load(std::memory_order_relaxed);
+        stats.collections = _collections.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "CanFrame.h"
+#include "DoorStateFrame.h"
+
+namespace HmiCore
+{
+    struct DoorTableConfig
+    {
+        /// Number of buses (cars) in the table; each bus holds DoorStateFrame::kMaxDoors doors.
+        std::uint32_t busCount = 1;
+
+        /// A door with no frame for this long is reported stale. 0 disables stale detection.
+        std::int64_t staleAfterTicks = 2 * DoorCore::kTicksPerSecond;
+
+        /// Maximum rate at which PollDeltas() hands deltas to the UI.
+        std::uint32_t refreshHz = 30;
+    };
+
+    /// <summary>
+    /// Latest view of one door, emitted when its state or stale flag changed since the last
+    /// collection.
+    /// </summary>
+    struct DoorDelta
+    {
+        std::uint16_t bus;
+        std::uint8_t doorId;
+        DoorCore::DoorState state;
+        bool stale;
+        /// Receive time (.NET UTC ticks) of the frame that last changed the state.
+        std::int64_t lastChange;
+        /// Receive time (.NET UTC ticks) of the latest frame for this door.
+        std::int64_t lastSeen;
+        /// State changes folded into this delta; >1 means intermediate states were coalesced.
+        std::uint32_t changes;
+    };
+
+    struct DoorTableStats
+    {
+        std::uint64_t framesApplied = 0;
+        /// Frames that are not door state frames or address a bus outside the table.
+        std::uint64_t framesRejected = 0;
+        std::uint64_t stateChanges = 0;
+        std::uint64_t deltasEmitted = 0;
+        std::uint64_t collections = 0;
+    };
+
+    /// <summary>
+    /// Dense, direct-indexed door state table with change-only notification.
+    /// </summary>
+    /// <remarks>
+    /// Replaces the per-frame linear search, timestamp formatting and Dispatcher.Invoke in
+    /// Hmi.Host.MainWindow. Door (bus, id) lives at slot bus * 256 + id. Applying a frame
+    /// stores the receive time and, only when the state changes, the new state plus one bit
+    /// in a dirty bitmap; frames repeating the current state touch nothing else. The UI side
+    /// collects at its refresh rate and gets one delta per changed door, however many frames
+    /// arrived in between.
+    ///
+    /// Apply*() is called from one receive thread and Collect/PollDeltas() from one UI thread;
+    /// each field has a single writer, so neither side takes a lock. A delta always carries
+    /// the latest state; fields of one delta may come from consecutive frames.
+    /// </remarks>
+    class DoorTable
+    {
+    public:
+        explicit DoorTable(DoorTableConfig config = {});
+
+        DoorTable(const DoorTable&) = delete;
+        DoorTable& operator=(const DoorTable&) = delete;
+
+        /// Applies one frame received on `bus` at `receivedTicks`. Returns true if it changed
+        /// the door state.
+        bool Apply(std::uint32_t bus, const DoorCore::CanFrame& frame, std::int64_t receivedTicks);
+
+        /// Applies a received batch with one receive timestamp; returns the number of frames
+        /// that were door state frames for a bus in the table.
+        std::size_t ApplyBatch(std::uint32_t bus, std::span<const DoorCore::CanFrame> frames, std::int64_t receivedTicks);
+
+        /// Moves pending deltas (state changes and stale transitions as of `nowTicks`) into
+        /// `out` and returns the count. Doors that do not fit stay pending for the next call.
+        std::size_t CollectDeltas(std::int64_t nowTicks, std::span<DoorDelta> out);
+
+        /// Rate-limited CollectDeltas: returns 0 without scanning until 1/refreshHz has passed
+        /// since the last collection.
+        std::size_t PollDeltas(std::int64_t nowTicks, std::span<DoorDelta> out);
+
+        /// True once the door has received at least one frame.
+        bool IsKnown(std::uint32_t bus, std::uint8_t doorId) const;
+        DoorCore::DoorState State(std::uint32_t bus, std::uint8_t doorId) const;
+        std::int64_t LastSeen(std::uint32_t bus, std::uint8_t doorId) const;
+        std::int64_t LastChange(std::uint32_t bus, std::uint8_t doorId) const;
+
+        std::uint32_t BusCount() const { return _config.busCount; }
+        std::size_t SlotCount() const { return _slotCount; }
+        const DoorTableConfig& Config() const { return _config; }
+
+        DoorTableStats Stats() const;
+
+    private:
+        /// Stored in _state for slots that never received a frame.
+        static constexpr std::uint8_t kUnknown = 0xFF;
+
+        static std::size_t Slot(std::uint32_t bus, std::uint8_t doorId)
+        {
+            return static_cast<std::size_t>(bus) * DoorCore::DoorStateFrame::kMaxDoors + doorId;
+        }
+
+        bool ApplyParsed(std::size_t slot, DoorCore::DoorState state, std::int64_t receivedTicks);
+        bool EmitDelta(std::size_t slot, std::int64_t nowTicks, std::span<DoorDelta> out, std::size_t& count);
+
+        DoorTableConfig _config;
+        std::size_t _slotCount;
+        std::size_t _wordCount;
+        std::int64_t _refreshIntervalTicks;
+
+        // Receive side (single writer).
+        std::unique_ptr<std::atomic<std::uint8_t>[]> _state;
+        std::unique_ptr<std::atomic<std::int64_t>[]> _lastSeen;
+        std::unique_ptr<std::atomic<std::int64_t>[]> _lastChange;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> _changes;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> _dirty;
+
+        // UI side (single writer).
+        std::vector<std::uint8_t> _reportedStale;
+        std::vector<std::uint32_t> _reportedChanges;
+        std::int64_t _nextRefresh = 0;
+
+        std::atomic<std::uint64_t> _framesApplied{ 0 };
+        std::atomic<std::uint64_t> _framesRejected{ 0 };
+        std::atomic<std::uint64_t> _stateChanges{ 0 };
+        std::atomic<std::uint64_t> _deltasEmitted{ 0 };
+        std::atomic<std::uint64_t> _collections{ 0 };
+    };
+}
@@ -1 +1,4 @@
 #pragma once
+
+// Public entry point for the Hmi.Core static library.
+#include "DoorTable.h"
@@ -0,0 +1,17 @@
+// Transport.Pcan.Bench: benchmarks for the Transport.Pcan static library.
+//
+// Usage: Transport.Pcan.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "loopback", "PCAN transport on the loopback driver: throughput, bus load, latency, faults, coalescing, in-band status", TransportPcanBench::RunLoopbackBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Transport.Pcan.Bench", kBenchmarks, argc, argv);
+}
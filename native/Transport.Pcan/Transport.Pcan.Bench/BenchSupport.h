@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TransportPcanBench
+{
+    int RunLoopbackBench(int argc, char** argv);
+}
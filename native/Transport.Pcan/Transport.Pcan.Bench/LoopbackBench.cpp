@@ -0,0 +1,508 @@
+// PcanCanBus on the PcanLoopback driver: no adapter needed, runs on Linux.
+//
+// Usage: Transport.Pcan.Bench loopback [frames]
+//
+// bits        on-wire length of random 8-byte frames (stuffing) against the CAN bounds
+// paced       `frames` 8-byte frames between two channels at 1 Mbit/s: frames/s, bus load
+// unpaced     10x `frames` with pacing off: transport overhead, wake-ups and burst size; the
+//             bus then outruns a starved receiver (e.g. one core), so frames may be lost to
+//             receive-queue overruns, which must account for every missing frame
+// latency     ping-pong round trips at 500 kbit/s with a 100 ppm device clock; one-way
+//             delay of the hardware timestamps and their monotonicity
+// errors      1% error frames: everything still arrives, at the cost of bus time
+// bus-off     forced bus-off on one channel: disconnect, re-initialize, traffic resumes
+// coalesce    a slow bus with same-ID coalescing: fewer frames, latest state per ID wins
+// status      bus light/heavy and queue overrun read in band: the drain goes on past them
+
+#include "BenchSupport.h"
+
+#include "PcanLoopback.h"
+#include "PcanTransport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace TransportPcan;
+using DoorCore::CanFrame;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::size_t kSendBatch = 64;
+    constexpr auto kDeliveryTimeout = std::chrono::seconds(30);
+
+    class Rng
+    {
+    public:
+        explicit Rng(std::uint64_t seed)
+            : _state(seed)
+        {
+        }
+
+        std::uint32_t Next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return static_cast<std::uint32_t>(_state >> 16);
+        }
+
+    private:
+        std::uint64_t _state;
+    };
+
+    CanFrame MakeFrame(std::uint32_t id, std::uint64_t payload)
+    {
+        CanFrame frame{};
+        frame.id = id;
+        frame.dlc = 8;
+        std::memcpy(frame.data, &payload, sizeof(payload));
+        return frame;
+    }
+
+    bool WaitFor(const std::function<bool()>& done, std::chrono::steady_clock::duration timeout = kDeliveryTimeout)
+    {
+        const auto until = std::chrono::steady_clock::now() + timeout;
+        while (!done())
+        {
+            if (std::chrono::steady_clock::now() >= until)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    /// Sends everything, backing off while the transport queue is full.
+    bool SendAll(PcanCanBus& bus, const std::vector<CanFrame>& frames)
+    {
+        std::size_t offset = 0;
+        const auto until = std::chrono::steady_clock::now() + kDeliveryTimeout;
+        while (offset < frames.size())
+        {
+            const std::size_t count = std::min(kSendBatch, frames.size() - offset);
+            const std::size_t sent = bus.SendBatch(std::span<const CanFrame>(frames.data() + offset, count));
+            offset += sent;
+            if (sent < count)
+            {
+                if (std::chrono::steady_clock::now() >= until)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        return true;
+    }
+
+    /// Two transports on one loopback net; B counts what it receives.
+    struct Pair
+    {
+        std::unique_ptr<PcanCanBus> a;
+        std::unique_ptr<PcanCanBus> b;
+        std::atomic<std::uint64_t> received{ 0 };
+
+        Pair(int net, TPCANHandle first, TPCANHandle second, TPCANBaudrate bitrate, const PcanLoopback::NetOptions& options,
+             PcanCanBusOptions busOptions = {}, DoorCore::CanBusHandlers handlersB = {})
+        {
+            PcanLoopback::ConfigureNet(net, options);
+            PcanLoopback::AssignChannel(first, net);
+            PcanLoopback::AssignChannel(second, net);
+
+            busOptions.bitrate = bitrate;
+            busOptions.channel = first;
+            a = std::make_unique<PcanCanBus>(busOptions, PcanLoopback::Api());
+            busOptions.channel = second;
+            b = std::make_unique<PcanCanBus>(busOptions, PcanLoopback::Api());
+
+            if (!handlersB.framesReceived)
+            {
+                handlersB.framesReceived = [this](std::span<const CanFrame> frames) {
+                    received.fetch_add(frames.size(), std::memory_order_relaxed);
+                };
+            }
+            a->Start({});
+            b->Start(std::move(handlersB));
+        }
+
+        bool Connected()
+        {
+            return WaitFor([this] { return a->IsConnected() && b->IsConnected(); }, std::chrono::seconds(5));
+        }
+    };
+
+    std::vector<CanFrame> RandomFrames(std::size_t count, std::uint64_t seed)
+    {
+        Rng rng(seed);
+        std::vector<CanFrame> frames(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Mix of 11- and 29-bit IDs, every 4th frame extended.
+            const std::uint32_t id = i % 4 == 3 ? 0x800 + rng.Next() % 0x1FFFF000 : rng.Next() % 0x800;
+            frames[i] = MakeFrame(id, (static_cast<std::uint64_t>(rng.Next()) << 32) | rng.Next());
+        }
+        return frames;
+    }
+
+    bool RunBits()
+    {
+        Rng rng(7);
+        std::uint32_t low = UINT32_MAX;
+        std::uint32_t high = 0;
+        std::uint64_t total = 0;
+        constexpr int kSamples = 100000;
+        for (int i = 0; i < kSamples; ++i)
+        {
+            const std::uint64_t payload = (static_cast<std::uint64_t>(rng.Next()) << 32) | rng.Next();
+            std::uint8_t data[8];
+            std::memcpy(data, &payload, sizeof(data));
+            const std::uint32_t bits = PcanLoopback::FrameBits(rng.Next() % 0x800, false, 8, data);
+            low = std::min(low, bits);
+            high = std::max(high, bits);
+            total += bits;
+        }
+
+        // 111 bits unstuffed; at most one stuff bit per 4 bits of the 98-bit stuffed region.
+        std::uint8_t zeros[8] = {};
+        const std::uint32_t worst = PcanLoopback::FrameBits(0, false, 8, zeros);
+        const bool pass = low >= 111 && high <= 135 && worst > 111 && worst <= 135;
+        std::printf("bits      8-byte standard frames: min %u  mean %.1f  max %u  all-zero %u  %s\n",
+            low, static_cast<double>(total) / kSamples, high, worst, pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunThroughput(const char* label, int net, TPCANHandle first, TPCANHandle second, bool paced, std::size_t frames)
+    {
+        PcanLoopback::NetOptions options;
+        options.paced = paced;
+        Pair pair(net, first, second, PCAN_BAUD_1M, options);
+        if (!pair.Connected())
+        {
+            std::printf("%-9s channels did not connect  FAIL\n", label);
+            return false;
+        }
+
+        const std::vector<CanFrame> traffic = RandomFrames(frames, 11);
+        const PcanLoopback::NetStats before = PcanLoopback::Stats(net);
+        Stopwatch watch;
+        const bool sent = SendAll(*pair.a, traffic);
+        const bool delivered = sent && WaitFor([&] {
+            return pair.received.load() + PcanLoopback::Stats(net).rxOverruns - before.rxOverruns >= frames;
+        });
+        const double seconds = watch.ElapsedSeconds();
+        const PcanLoopback::NetStats after = PcanLoopback::Stats(net);
+        const std::uint64_t overruns = after.rxOverruns - before.rxOverruns;
+
+        const double load = static_cast<double>(after.busyNs - before.busyNs) / static_cast<double>(after.elapsedNs - before.elapsedNs);
+        const double bitsPerFrame = static_cast<double>(after.bits - before.bits) / static_cast<double>(std::max<std::uint64_t>(after.frames - before.frames, 1));
+        const PcanCanBusStats rx = pair.b->Stats();
+        const PcanCanBusStats tx = pair.a->Stats();
+
+        // Paced: the bus must be the bottleneck, i.e. (nearly) saturated, and nothing is lost.
+        const bool pass = delivered && rx.framesReceived + overruns == frames && (!paced || (load >= 0.9 && overruns == 0));
+        std::printf("%-9s %12.0f frames/s  bus load %5.1f%%  %.1f bits/frame  %llu wake-ups  burst max %llu  write retries %llu  rx overruns %llu  %s\n",
+            label, pair.received.load() / seconds, 100.0 * load, bitsPerFrame,
+            static_cast<unsigned long long>(rx.wakeups), static_cast<unsigned long long>(rx.maxBurst),
+            static_cast<unsigned long long>(tx.writeRetries), static_cast<unsigned long long>(overruns), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    double Percentile(std::vector<double>& values, double fraction)
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+        const std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    bool RunLatency(std::size_t roundTrips)
+    {
+        PcanLoopback::NetOptions options;
+        options.clockSkewPpm = 100;
+
+        std::mutex lock;
+        std::vector<double> oneWay;
+        oneWay.reserve(roundTrips * 2);
+        bool monotonic = true;
+        std::int64_t lastA = 0;
+        std::int64_t lastB = 0;
+        std::atomic<std::uint64_t> echoed{ 0 };
+        PcanCanBus* echo = nullptr;
+
+        auto record = [&](const CanFrame& frame, std::int64_t& last) {
+            const std::int64_t now = DoorCore::UtcNowTicks();
+            std::lock_guard<std::mutex> guard(lock);
+            oneWay.push_back(static_cast<double>(now - frame.timestamp) / 10.0);
+            monotonic = monotonic && frame.timestamp >= last;
+            last = frame.timestamp;
+        };
+
+        DoorCore::CanBusHandlers handlersB;
+        handlersB.framesReceived = [&](std::span<const CanFrame> frames) {
+            for (const CanFrame& frame : frames)
+            {
+                record(frame, lastB);
+                CanFrame reply = frame;
+                reply.id = 0x101;
+                echo->Send(reply);
+            }
+        };
+        Pair pair(2, PCAN_USBBUS5, PCAN_USBBUS6, PCAN_BAUD_500K, options, {}, std::move(handlersB));
+        echo = pair.b.get();
+
+        // A's handler is fixed at Start, so restart it with the round-trip counter.
+        pair.a->Stop();
+        DoorCore::CanBusHandlers handlersA;
+        handlersA.framesReceived = [&](std::span<const CanFrame> frames) {
+            for (const CanFrame& frame : frames)
+            {
+                record(frame, lastA);
+            }
+            echoed.fetch_add(frames.size(), std::memory_order_release);
+        };
+        pair.a->Start(std::move(handlersA));
+        if (!pair.Connected())
+        {
+            std::printf("latency   channels did not connect  FAIL\n");
+            return false;
+        }
+
+        std::vector<double> roundTrip;
+        roundTrip.reserve(roundTrips);
+        for (std::size_t i = 0; i < roundTrips; ++i)
+        {
+            const std::uint64_t expected = echoed.load(std::memory_order_acquire) + 1;
+            const auto start = std::chrono::steady_clock::now();
+            pair.a->Send(MakeFrame(0x100, i));
+            if (!WaitFor([&] { return echoed.load(std::memory_order_acquire) >= expected; }, std::chrono::seconds(2)))
+            {
+                std::printf("latency   round trip %zu timed out  FAIL\n", i);
+                return false;
+            }
+            roundTrip.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        pair.a->Stop();
+        pair.b->Stop();
+        std::lock_guard<std::mutex> guard(lock);
+        const double p50 = Percentile(roundTrip, 0.50);
+        const double p99 = Percentile(roundTrip, 0.99);
+        const double wayP50 = Percentile(oneWay, 0.50);
+        const double wayP99 = Percentile(oneWay, 0.99);
+        const double wayMin = *std::min_element(oneWay.begin(), oneWay.end());
+
+        // A frame cannot be seen before it was on the bus, and with minimum-offset tracking the
+        // mapping should stay within a few milliseconds of the read time.
+        const bool pass = monotonic && wayMin >= -100.0 && wayP99 < 20'000.0;
+        std::printf("latency   round trip p50 %.0f us  p99 %.0f us  (%zu, two 8-byte frames at 500 kbit/s = %.0f us on the wire)\n",
+            p50, p99, roundTrips, 2.0 * 1e6 * 125 / 500'000);
+        std::printf("latency   one-way after timestamp p50 %.0f us  p99 %.0f us  min %.0f us  monotonic %s  %s\n",
+            wayP50, wayP99, wayMin, monotonic ? "yes" : "no", pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunErrors(std::size_t frames)
+    {
+        PcanLoopback::NetOptions options;
+        options.errorRate = 0.01;
+        options.seed = 99;
+        Pair pair(3, PCAN_USBBUS7, PCAN_USBBUS8, PCAN_BAUD_1M, options);
+        if (!pair.Connected())
+        {
+            std::printf("errors    channels did not connect  FAIL\n");
+            return false;
+        }
+
+        const bool delivered = SendAll(*pair.a, RandomFrames(frames, 13)) && WaitFor([&] { return pair.received.load() >= frames; });
+        const PcanLoopback::NetStats stats = PcanLoopback::Stats(3);
+        const double rate = static_cast<double>(stats.errorFrames) / static_cast<double>(stats.frames + stats.errorFrames);
+        const bool pass = delivered && pair.received.load() == frames && rate > 0.005 && rate < 0.02;
+        std::printf("errors    %llu error frames (%.2f%% of attempts), %llu of %zu frames delivered  %s\n",
+            static_cast<unsigned long long>(stats.errorFrames), 100.0 * rate,
+            static_cast<unsigned long long>(pair.received.load()), frames, pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunBusOff()
+    {
+        PcanCanBusOptions busOptions;
+        busOptions.retryIntervalMs = 50;
+        busOptions.statusPollMs = 10;
+
+        std::atomic<int> drops{ 0 };
+        std::atomic<int> reconnects{ 0 };
+        PcanLoopback::ConfigureNet(4, {});
+        PcanLoopback::AssignChannel(PCAN_USBBUS9, 4);
+        PcanLoopback::AssignChannel(PCAN_USBBUS10, 4);
+
+        busOptions.channel = PCAN_USBBUS9;
+        PcanCanBus a(busOptions, PcanLoopback::Api());
+        busOptions.channel = PCAN_USBBUS10;
+        PcanCanBus b(busOptions, PcanLoopback::Api());
+
+        std::atomic<std::uint64_t> received{ 0 };
+        DoorCore::CanBusHandlers handlersA;
+        handlersA.connectionStateChanged = [&](bool connected) { (connected ? reconnects : drops).fetch_add(1); };
+        DoorCore::CanBusHandlers handlersB;
+        handlersB.framesReceived = [&](std::span<const CanFrame> frames) { received.fetch_add(frames.size()); };
+        a.Start(std::move(handlersA));
+        b.Start(std::move(handlersB));
+
+        bool pass = WaitFor([&] { return a.IsConnected() && b.IsConnected(); }, std::chrono::seconds(5));
+        Stopwatch watch;
+        PcanLoopback::InjectBusOff(PCAN_USBBUS9);
+        pass = pass && WaitFor([&] { return drops.load() == 1; }, std::chrono::seconds(5));
+        pass = pass && WaitFor([&] { return reconnects.load() == 2; }, std::chrono::seconds(5));
+        const double recovery = watch.ElapsedSeconds();
+
+        pass = pass && a.Send(MakeFrame(0x200, 1)) && WaitFor([&] { return received.load() == 1; }, std::chrono::seconds(5));
+        pass = pass && a.Stats().busOffs == 1;
+        std::printf("bus-off   recovered in %.0f ms (retry interval %u ms), busOffs %llu, traffic resumed  %s\n",
+            recovery * 1e3, busOptions.retryIntervalMs, static_cast<unsigned long long>(a.Stats().busOffs), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunCoalesce()
+    {
+        constexpr std::uint32_t kIds = 100;
+        constexpr std::uint32_t kUpdates = 200;
+
+        PcanCanBusOptions busOptions;
+        busOptions.coalesceSameId = true;
+
+        std::mutex lock;
+        std::vector<std::uint64_t> latest(kIds, UINT64_MAX);
+        DoorCore::CanBusHandlers handlersB;
+        handlersB.framesReceived = [&](std::span<const CanFrame> frames) {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const CanFrame& frame : frames)
+            {
+                std::memcpy(&latest[frame.id - 0x300], frame.data, sizeof(std::uint64_t));
+            }
+        };
+
+        // 125 kbit/s moves ~1000 frames/s, so updates pile up in the transport once the
+        // (deliberately short) driver transmit queue is full.
+        PcanLoopback::NetOptions options;
+        options.txQueueFrames = 16;
+        Pair pair(5, PCAN_USBBUS11, PCAN_USBBUS12, PCAN_BAUD_125K, options, busOptions, std::move(handlersB));
+        if (!pair.Connected())
+        {
+            std::printf("coalesce  channels did not connect  FAIL\n");
+            return false;
+        }
+
+        Stopwatch watch;
+        for (std::uint32_t update = 0; update < kUpdates; ++update)
+        {
+            std::vector<CanFrame> round;
+            for (std::uint32_t id = 0; id < kIds; ++id)
+            {
+                round.push_back(MakeFrame(0x300 + id, update));
+            }
+            SendAll(*pair.a, round);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+
+        const auto settled = [&] {
+            std::lock_guard<std::mutex> guard(lock);
+            return std::all_of(latest.begin(), latest.end(), [](std::uint64_t value) { return value == kUpdates - 1; });
+        };
+        const bool converged = WaitFor(settled);
+        const double seconds = watch.ElapsedSeconds();
+
+        const PcanCanBusStats stats = pair.a->Stats();
+        const bool pass = converged && stats.framesCoalesced > 0 && stats.framesSent + stats.framesCoalesced == kIds * kUpdates;
+        std::printf("coalesce  %u updates -> %llu frames on the bus (%llu coalesced) in %.2f s, latest state per ID %s  %s\n",
+            kIds * kUpdates, static_cast<unsigned long long>(stats.framesSent), static_cast<unsigned long long>(stats.framesCoalesced),
+            seconds, converged ? "matches" : "STALE", pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunStatus()
+    {
+        constexpr std::size_t kQueued = 1000;
+
+        // B's handler holds the first delivery until kQueued frames wait in its receive queue
+        // behind three non-fatal statuses; they must all come out of the next wake-up.
+        std::atomic<bool> entered{ false };
+        std::atomic<bool> release{ false };
+        std::atomic<std::uint64_t> received{ 0 };
+        std::atomic<int> drops{ 0 };
+        DoorCore::CanBusHandlers handlersB;
+        handlersB.framesReceived = [&](std::span<const CanFrame> frames) {
+            entered.store(true);
+            while (!release.load())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            received.fetch_add(frames.size());
+        };
+        handlersB.connectionStateChanged = [&](bool connected) { drops.fetch_add(connected ? 0 : 1); };
+
+        PcanLoopback::NetOptions options;
+        options.paced = false;
+        Pair pair(6, PCAN_USBBUS13, PCAN_USBBUS14, PCAN_BAUD_1M, options, {}, std::move(handlersB));
+        if (!pair.Connected())
+        {
+            std::printf("status    channels did not connect  FAIL\n");
+            return false;
+        }
+
+        bool pass = pair.a->Send(MakeFrame(0x100, 0)) && WaitFor([&] { return entered.load(); });
+        pass = pass && SendAll(*pair.a, RandomFrames(kQueued, 13)) && WaitFor([&] { return PcanLoopback::Stats(6).frames == kQueued + 1; });
+        for (TPCANStatus status : { PCAN_ERROR_BUSLIGHT, PCAN_ERROR_BUSHEAVY, PCAN_ERROR_QOVERRUN })
+        {
+            PcanLoopback::InjectReadStatus(PCAN_USBBUS14, status);
+        }
+        const std::uint64_t wakeups = pair.b->Stats().wakeups;
+        release.store(true);
+        pass = pass && WaitFor([&] { return received.load() == kQueued + 1; });
+
+        const PcanCanBusStats stats = pair.b->Stats();
+        pass = pass && stats.wakeups - wakeups == 1 && stats.maxBurst == kQueued && stats.rxOverruns == 1 && drops.load() == 0 && pair.b->IsConnected();
+        std::printf("status    %zu frames behind BUSLIGHT, BUSHEAVY, QOVERRUN: drained in %llu wake-ups, %llu overrun counted, %d disconnects  %s\n",
+            kQueued, static_cast<unsigned long long>(stats.wakeups - wakeups), static_cast<unsigned long long>(stats.rxOverruns),
+            drops.load(), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+}
+
+namespace TransportPcanBench
+{
+    int RunLoopbackBench(int argc, char** argv)
+    {
+        const std::size_t frames = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 20000;
+        if (frames < 1000)
+        {
+            std::fprintf(stderr, "frames must be >= 1000\n");
+            return 1;
+        }
+
+        std::printf("loopback: %zu frames, PCAN-Basic loopback driver\n\n", frames);
+        bool pass = RunBits();
+        pass = RunThroughput("paced", 0, PCAN_USBBUS1, PCAN_USBBUS2, true, frames) && pass;
+        pass = RunThroughput("unpaced", 1, PCAN_USBBUS3, PCAN_USBBUS4, false, frames * 10) && pass;
+        pass = RunLatency(std::max<std::size_t>(frames / 20, 100)) && pass;
+        pass = RunErrors(frames / 2) && pass;
+        pass = RunBusOff() && pass;
+        pass = RunCoalesce() && pass;
+        pass = RunStatus() && pass;
+
+        PcanLoopback::Shutdown();
+        return pass ? 0 : 1;
+    }
+}
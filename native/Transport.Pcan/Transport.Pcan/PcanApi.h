@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+// PCANBasic.h is the Windows header; give it the Win32 vocabulary it is written in so the
+// same declarations (and the loopback) compile on Linux.
+using BYTE = std::uint8_t;
+using WORD = std::uint16_t;
+using DWORD = std::uint32_t;
+using UINT64 = std::uint64_t;
+using LPSTR = char*;
+#ifndef __stdcall
+#define __stdcall
+#endif
+#ifndef __T
+#define __T(text) text
+#endif
+#endif
+
+#include "PCANBasic.h"
+
+/// 1 when the real PCAN-Basic library is linked: always on Windows (vendored
+/// PCANBasic.lib), on Linux only if the build defines TRANSPORT_PCAN_LIBPCANBASIC.
+#if defined(_WIN32) || defined(TRANSPORT_PCAN_LIBPCANBASIC)
+#define TRANSPORT_PCAN_NATIVE 1
+#else
+#define TRANSPORT_PCAN_NATIVE 0
+#endif
+
+namespace TransportPcan
+{
+    /// <summary>
+    /// The PCAN-Basic entry points the transport uses, as a table of function pointers.
+    /// </summary>
+    /// <remarks>
+    /// The transport never calls CAN_* directly, so the same code runs on the vendor DLL or on
+    /// PcanLoopback's virtual channels without link-time tricks.
+    /// </remarks>
+    struct PcanApi
+    {
+        TPCANStatus(__stdcall* initialize)(TPCANHandle channel, TPCANBaudrate btr0btr1, BYTE hwType, DWORD ioPort, WORD interrupt) = nullptr;
+        TPCANStatus(__stdcall* uninitialize)(TPCANHandle channel) = nullptr;
+        TPCANStatus(__stdcall* reset)(TPCANHandle channel) = nullptr;
+        TPCANStatus(__stdcall* getStatus)(TPCANHandle channel) = nullptr;
+        TPCANStatus(__stdcall* read)(TPCANHandle channel, TPCANMsg* message, TPCANTimestamp* timestamp) = nullptr;
+        TPCANStatus(__stdcall* write)(TPCANHandle channel, TPCANMsg* message) = nullptr;
+        TPCANStatus(__stdcall* filterMessages)(TPCANHandle channel, DWORD fromId, DWORD toId, TPCANMode mode) = nullptr;
+        TPCANStatus(__stdcall* getValue)(TPCANHandle channel, TPCANParameter parameter, void* buffer, DWORD bufferLength) = nullptr;
+        TPCANStatus(__stdcall* setValue)(TPCANHandle channel, TPCANParameter parameter, void* buffer, DWORD bufferLength) = nullptr;
+        TPCANStatus(__stdcall* getErrorText)(TPCANStatus error, WORD language, LPSTR buffer) = nullptr;
+
+#if TRANSPORT_PCAN_NATIVE
+        /// The entry points of the linked PCAN-Basic library.
+        static PcanApi Native()
+        {
+            PcanApi api;
+            api.initialize = &CAN_Initialize;
+            api.uninitialize = &CAN_Uninitialize;
+            api.reset = &CAN_Reset;
+            api.getStatus = &CAN_GetStatus;
+            api.read = &CAN_Read;
+            api.write = &CAN_Write;
+            api.filterMessages = &CAN_FilterMessages;
+            api.getValue = &CAN_GetValue;
+            api.setValue = &CAN_SetValue;
+            api.getErrorText = &CAN_GetErrorText;
+            return api;
+        }
+#endif
+    };
+
+    /// Nominal bit rate of a BTR0/BTR1 code from PCANBasic.h, or 0 if unknown.
+    constexpr std::uint32_t BitrateFromBtr(TPCANBaudrate btr0btr1)
+    {
+        switch (btr0btr1)
+        {
+        case PCAN_BAUD_1M: return 1'000'000;
+        case PCAN_BAUD_800K: return 800'000;
+        case PCAN_BAUD_500K: return 500'000;
+        case PCAN_BAUD_250K: return 250'000;
+        case PCAN_BAUD_125K: return 125'000;
+        case PCAN_BAUD_100K: return 100'000;
+        case PCAN_BAUD_95K: return 95'238;
+        case PCAN_BAUD_83K: return 83'333;
+        case PCAN_BAUD_50K: return 50'000;
+        case PCAN_BAUD_47K: return 47'619;
+        case PCAN_BAUD_33K: return 33'333;
+        case PCAN_BAUD_20K: return 20'000;
+        case PCAN_BAUD_10K: return 10'000;
+        case PCAN_BAUD_5K: return 5'000;
+        default: return 0;
+        }
+    }
+
+    /// Microseconds since the device clock started, from a PCAN receive timestamp.
+    constexpr std::uint64_t TimestampMicros(const TPCANTimestamp& timestamp)
+    {
+        return timestamp.micros
+            + 1000ULL * timestamp.millis
+            + 0x100000000ULL * 1000ULL * timestamp.millis_overflow;
+    }
+}
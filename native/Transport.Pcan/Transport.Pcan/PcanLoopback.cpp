@@ -0,0 +1,983 @@
+#include "pch.h"
+
+#include "PcanLoopback.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using DoorCore::SteadyNowNs;
+
+namespace TransportPcan::PcanLoopback
+{
+    namespace
+    {
+        /// Error flag (6) + superposed flags (up to 6) + delimiter (8) + intermission (3).
+        constexpr std::uint32_t kErrorFrameBits = 23;
+
+        /// Fixed-capacity FIFO; storage is allocated when the channel is initialized.
+        template <typename T>
+        class Queue
+        {
+        public:
+            void Reset(std::size_t capacity)
+            {
+                _items.assign(std::max<std::size_t>(capacity, 1), T{});
+                _head = 0;
+                _count = 0;
+            }
+
+            void Clear()
+            {
+                _head = 0;
+                _count = 0;
+            }
+
+            bool Empty() const { return _count == 0; }
+            bool Full() const { return _count == _items.size(); }
+            const T& Front() const { return _items[_head]; }
+
+            void Push(const T& item)
+            {
+                _items[(_head + _count) % _items.size()] = item;
+                ++_count;
+            }
+
+            T Pop()
+            {
+                T item = _items[_head];
+                _head = (_head + 1) % _items.size();
+                --_count;
+                return item;
+            }
+
+        private:
+            std::vector<T> _items;
+            std::size_t _head = 0;
+            std::size_t _count = 0;
+        };
+
+        struct RxEntry
+        {
+            TPCANMsg message;
+            TPCANTimestamp timestamp;
+        };
+
+        enum class FilterMode
+        {
+            Open,
+            Closed,
+            Custom
+        };
+
+        struct FilterRange
+        {
+            bool extended;
+            std::uint32_t first;
+            std::uint32_t last;
+        };
+
+        struct Channel
+        {
+            TPCANHandle handle = PCAN_NONEBUS;
+            bool initialized = false;
+            int net = 0;
+            std::uint32_t bitrate = 0;
+            double clockRate = 1.0;
+            std::int64_t epochNs = 0;
+
+            Queue<RxEntry> rx;
+            Queue<TPCANMsg> tx;
+
+            FilterMode filter = FilterMode::Open;
+            std::vector<FilterRange> ranges;
+            bool echo = false;
+            bool errorFrames = false;
+            bool statusFrames = true;
+            bool autoReset = false;
+            bool listenOnly = false;
+            bool busOff = false;
+            bool overrunPending = false;
+            /// Returned by Read instead of the next frame (InjectReadStatus).
+            std::deque<TPCANStatus> readStatuses;
+
+#if defined(_WIN32)
+            HANDLE receiveEvent = nullptr;
+#else
+            int receiveFd = -1;
+#endif
+        };
+
+        struct Net
+        {
+            NetOptions options;
+            std::uint32_t bitrate = 0;
+            std::vector<Channel*> members;
+            std::condition_variable wake;
+            std::thread worker;
+            /// Bumped when the last channel leaves; a bus thread exits once it no longer matches.
+            std::uint64_t generation = 0;
+            std::uint64_t rng = 1;
+
+            std::int64_t startNs = 0;
+            std::int64_t busTimeNs = 0;
+            NetStats stats;
+        };
+
+        struct State
+        {
+            std::mutex lock;
+            // Channels and nets are never destroyed, so the bus threads can keep pointers
+            // across the unlocked pacing sleep.
+            std::map<TPCANHandle, std::unique_ptr<Channel>> channels;
+            std::map<int, std::unique_ptr<Net>> nets;
+            std::map<int, NetOptions> netOptions;
+            std::map<TPCANHandle, int> assignments;
+        };
+
+        State& Global()
+        {
+            static State state;
+            return state;
+        }
+
+        double NextUnit(std::uint64_t& state)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return static_cast<double>(state >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        std::int64_t BitsToNs(std::uint64_t bits, std::uint32_t bitrate)
+        {
+            return static_cast<std::int64_t>(bits / bitrate * 1'000'000'000ULL + bits % bitrate * 1'000'000'000ULL / bitrate);
+        }
+
+        void Signal(Channel& channel)
+        {
+#if defined(_WIN32)
+            if (channel.receiveEvent != nullptr)
+            {
+                SetEvent(channel.receiveEvent);
+            }
+#else
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const ssize_t written = ::write(channel.receiveFd, &one, sizeof(one));
+#endif
+        }
+
+        void Unsignal([[maybe_unused]] Channel& channel)
+        {
+#if !defined(_WIN32)
+            // The descriptor mirrors the driver's: readable exactly while frames are queued.
+            std::uint64_t value = 0;
+            [[maybe_unused]] const ssize_t read = ::read(channel.receiveFd, &value, sizeof(value));
+#endif
+        }
+
+        bool Accepts(const Channel& channel, const TPCANMsg& message)
+        {
+            if ((message.MSGTYPE & (PCAN_MESSAGE_STATUS | PCAN_MESSAGE_ERRFRAME)) != 0 || channel.filter == FilterMode::Open)
+            {
+                return true;
+            }
+            const bool extended = (message.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0;
+            for (const FilterRange& range : channel.ranges)
+            {
+                if (range.extended == extended && message.ID >= range.first && message.ID <= range.last)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        TPCANTimestamp DeviceTimestamp(const Channel& channel, std::int64_t hostNs)
+        {
+            const double micros = static_cast<double>(std::max<std::int64_t>(hostNs - channel.epochNs, 0)) * channel.clockRate / 1000.0;
+            const auto total = static_cast<std::uint64_t>(micros);
+            const std::uint64_t millis = total / 1000;
+
+            TPCANTimestamp timestamp{};
+            timestamp.micros = static_cast<WORD>(total % 1000);
+            timestamp.millis = static_cast<DWORD>(millis & 0xFFFFFFFFu);
+            timestamp.millis_overflow = static_cast<WORD>(millis >> 32);
+            return timestamp;
+        }
+
+        /// Queues a frame on a receiver; the caller holds the lock.
+        void Deliver(Net& net, Channel& channel, const TPCANMsg& message, std::int64_t hostNs)
+        {
+            if (!channel.initialized || !Accepts(channel, message))
+            {
+                return;
+            }
+            if (channel.rx.Full())
+            {
+                channel.overrunPending = true;
+                ++net.stats.rxOverruns;
+                return;
+            }
+
+            const bool wasEmpty = channel.rx.Empty();
+            channel.rx.Push({ message, DeviceTimestamp(channel, hostNs) });
+            if (wasEmpty)
+            {
+                Signal(channel);
+            }
+        }
+
+        std::uint64_t ArbitrationKey(const TPCANMsg& message)
+        {
+            // Lower wins. A standard frame beats an extended one with the same base ID
+            // (dominant IDE bit), which the bit at position 18 encodes.
+            if ((message.MSGTYPE & PCAN_MESSAGE_EXTENDED) == 0)
+            {
+                return static_cast<std::uint64_t>(message.ID & 0x7FF) << 19;
+            }
+            return (static_cast<std::uint64_t>(message.ID >> 18 & 0x7FF) << 19) | (1ULL << 18) | (message.ID & 0x3FFFF);
+        }
+
+        void RunBus(Net& net, std::uint64_t generation)
+        {
+            State& state = Global();
+            std::unique_lock<std::mutex> lock(state.lock);
+
+            bool idle = true;
+            while (net.generation == generation)
+            {
+                Channel* sender = nullptr;
+                for (Channel* member : net.members)
+                {
+                    if (!member->tx.Empty() && (sender == nullptr || ArbitrationKey(member->tx.Front()) < ArbitrationKey(sender->tx.Front())))
+                    {
+                        sender = member;
+                    }
+                }
+                if (sender == nullptr)
+                {
+                    net.wake.wait(lock);
+                    idle = true;
+                    continue;
+                }
+
+                // An idle bus picks up at the current time; queued frames follow back to back
+                // even if the pacing sleep overshot.
+                const std::int64_t now = SteadyNowNs();
+                if (idle)
+                {
+                    net.busTimeNs = std::max(net.busTimeNs, now - net.startNs);
+                    idle = false;
+                }
+
+                const TPCANMsg message = sender->tx.Front();
+                const std::uint32_t frameBits = FrameBits(message.ID, (message.MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0, message.LEN, message.DATA);
+                const bool failed = net.options.errorRate > 0 && NextUnit(net.rng) < net.options.errorRate;
+
+                std::uint32_t bits = frameBits;
+                if (failed)
+                {
+                    // The error is detected somewhere in the frame; it is then retransmitted.
+                    bits = 1 + static_cast<std::uint32_t>(NextUnit(net.rng) * (frameBits - 10)) + kErrorFrameBits;
+                    ++net.stats.errorFrames;
+                }
+                else
+                {
+                    sender->tx.Pop();
+                    ++net.stats.frames;
+                }
+                net.stats.bits += bits;
+                net.busTimeNs += BitsToNs(bits, net.bitrate);
+
+                std::int64_t endNs = now;
+                if (net.options.paced)
+                {
+                    endNs = net.startNs + net.busTimeNs;
+                    if (endNs > now)
+                    {
+                        lock.unlock();
+                        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(endNs)));
+                        lock.lock();
+                        if (net.generation != generation)
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                if (failed)
+                {
+                    TPCANMsg error{};
+                    error.MSGTYPE = PCAN_MESSAGE_ERRFRAME;
+                    for (Channel* member : net.members)
+                    {
+                        if (member->errorFrames)
+                        {
+                            Deliver(net, *member, error, endNs);
+                        }
+                    }
+                    continue;
+                }
+
+                for (Channel* member : net.members)
+                {
+                    if (member != sender)
+                    {
+                        Deliver(net, *member, message, endNs);
+                    }
+                    else if (member->echo)
+                    {
+                        TPCANMsg echo = message;
+                        echo.MSGTYPE |= PCAN_MESSAGE_ECHO;
+                        Deliver(net, *member, echo, endNs);
+                    }
+                }
+            }
+        }
+
+        Channel* FindInitialized(State& state, TPCANHandle handle)
+        {
+            const auto it = state.channels.find(handle);
+            return it != state.channels.end() && it->second->initialized ? it->second.get() : nullptr;
+        }
+
+        /// Removes the channel from its bus; returns the bus thread to join (outside the lock)
+        /// if it was the last member.
+        std::thread Detach(State& state, Channel& channel)
+        {
+            channel.initialized = false;
+            channel.rx.Clear();
+            channel.tx.Clear();
+#if defined(_WIN32)
+            channel.receiveEvent = nullptr;
+#else
+            if (channel.receiveFd >= 0)
+            {
+                ::close(channel.receiveFd);
+                channel.receiveFd = -1;
+            }
+#endif
+
+            Net& net = *state.nets[channel.net];
+            net.members.erase(std::remove(net.members.begin(), net.members.end(), &channel), net.members.end());
+            if (!net.members.empty())
+            {
+                return {};
+            }
+
+            ++net.generation;
+            net.wake.notify_all();
+            return std::move(net.worker);
+        }
+
+        void PushStatus(Channel& channel, std::uint32_t status)
+        {
+            if (!channel.statusFrames || channel.rx.Full())
+            {
+                return;
+            }
+
+            TPCANMsg message{};
+            message.MSGTYPE = PCAN_MESSAGE_STATUS;
+            message.LEN = 4;
+            message.DATA[0] = static_cast<BYTE>(status >> 24);
+            message.DATA[1] = static_cast<BYTE>(status >> 16);
+            message.DATA[2] = static_cast<BYTE>(status >> 8);
+            message.DATA[3] = static_cast<BYTE>(status);
+
+            const bool wasEmpty = channel.rx.Empty();
+            channel.rx.Push({ message, DeviceTimestamp(channel, SteadyNowNs()) });
+            if (wasEmpty)
+            {
+                Signal(channel);
+            }
+        }
+
+        TPCANStatus __stdcall Initialize(TPCANHandle handle, TPCANBaudrate btr0btr1, BYTE, DWORD, WORD)
+        {
+            const std::uint32_t bitrate = BitrateFromBtr(btr0btr1);
+            if (handle == PCAN_NONEBUS || bitrate == 0)
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+
+            std::unique_ptr<Channel>& slot = state.channels[handle];
+            if (!slot)
+            {
+                slot = std::make_unique<Channel>();
+                slot->handle = handle;
+            }
+            Channel& channel = *slot;
+            if (channel.initialized)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+
+            const auto assigned = state.assignments.find(handle);
+            const int netId = assigned != state.assignments.end() ? assigned->second : 0;
+            std::unique_ptr<Net>& netSlot = state.nets[netId];
+            if (!netSlot)
+            {
+                netSlot = std::make_unique<Net>();
+            }
+            Net& net = *netSlot;
+
+            if (net.members.empty())
+            {
+                const auto options = state.netOptions.find(netId);
+                net.options = options != state.netOptions.end() ? options->second : NetOptions{};
+                net.bitrate = bitrate;
+                net.rng = net.options.seed != 0 ? net.options.seed : 1;
+                net.startNs = SteadyNowNs();
+                net.busTimeNs = 0;
+                net.stats = NetStats{};
+                net.stats.bitrate = bitrate;
+                net.worker = std::thread([&net, generation = net.generation] { RunBus(net, generation); });
+            }
+            else if (net.bitrate != bitrate)
+            {
+                // A node at the wrong bit rate would only produce error frames.
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+
+#if !defined(_WIN32)
+            channel.receiveFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (channel.receiveFd < 0)
+            {
+                return PCAN_ERROR_RESOURCE;
+            }
+#endif
+            channel.net = netId;
+            channel.bitrate = bitrate;
+            channel.clockRate = 1.0 + net.options.clockSkewPpm * 1e-6;
+            channel.epochNs = SteadyNowNs();
+            channel.rx.Reset(net.options.rxQueueFrames);
+            channel.tx.Reset(net.options.txQueueFrames);
+            channel.filter = FilterMode::Open;
+            channel.ranges.clear();
+            channel.echo = false;
+            channel.errorFrames = false;
+            channel.statusFrames = true;
+            channel.autoReset = false;
+            channel.listenOnly = false;
+            channel.busOff = false;
+            channel.overrunPending = false;
+            channel.readStatuses.clear();
+            channel.initialized = true;
+            net.members.push_back(&channel);
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall Uninitialize(TPCANHandle handle)
+        {
+            State& state = Global();
+            std::vector<std::thread> finished;
+            {
+                std::lock_guard<std::mutex> lock(state.lock);
+                if (handle == PCAN_NONEBUS)
+                {
+                    for (auto& [key, channel] : state.channels)
+                    {
+                        if (channel->initialized)
+                        {
+                            finished.push_back(Detach(state, *channel));
+                        }
+                    }
+                }
+                else
+                {
+                    Channel* channel = FindInitialized(state, handle);
+                    if (channel == nullptr)
+                    {
+                        return PCAN_ERROR_INITIALIZE;
+                    }
+                    finished.push_back(Detach(state, *channel));
+                }
+            }
+
+            for (std::thread& worker : finished)
+            {
+                if (worker.joinable())
+                {
+                    worker.join();
+                }
+            }
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall Reset(TPCANHandle handle)
+        {
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+
+            channel->rx.Clear();
+            channel->tx.Clear();
+            Unsignal(*channel);
+            channel->overrunPending = false;
+            channel->readStatuses.clear();
+            if (channel->autoReset)
+            {
+                channel->busOff = false;
+            }
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall GetStatus(TPCANHandle handle)
+        {
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+            if (channel->busOff)
+            {
+                return PCAN_ERROR_BUSOFF;
+            }
+            if (channel->overrunPending)
+            {
+                channel->overrunPending = false;
+                return PCAN_ERROR_QOVERRUN;
+            }
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall Read(TPCANHandle handle, TPCANMsg* message, TPCANTimestamp* timestamp)
+        {
+            if (message == nullptr)
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+            if (channel->rx.Empty())
+            {
+                return PCAN_ERROR_QRCVEMPTY;
+            }
+            if (!channel->readStatuses.empty())
+            {
+                const TPCANStatus status = channel->readStatuses.front();
+                channel->readStatuses.pop_front();
+                return status;
+            }
+
+            const RxEntry entry = channel->rx.Pop();
+            *message = entry.message;
+            if (timestamp != nullptr)
+            {
+                *timestamp = entry.timestamp;
+            }
+            if (channel->rx.Empty())
+            {
+                Unsignal(*channel);
+            }
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall Write(TPCANHandle handle, TPCANMsg* message)
+        {
+            if (message == nullptr || message->LEN > 8 || (message->MSGTYPE & ~(PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_RTR)) != 0)
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+            const bool extended = (message->MSGTYPE & PCAN_MESSAGE_EXTENDED) != 0;
+            if (message->ID > (extended ? MAX_VALUE_EXTENDED_ID : MAX_VALUE_STANDARD_ID))
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+            if (channel->listenOnly)
+            {
+                return PCAN_ERROR_ILLOPERATION;
+            }
+            if (channel->busOff)
+            {
+                return PCAN_ERROR_BUSOFF;
+            }
+            if (channel->tx.Full())
+            {
+                return PCAN_ERROR_QXMTFULL;
+            }
+
+            const bool wasIdle = channel->tx.Empty();
+            channel->tx.Push(*message);
+            if (wasIdle)
+            {
+                state.nets[channel->net]->wake.notify_one();
+            }
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall FilterMessages(TPCANHandle handle, DWORD fromId, DWORD toId, TPCANMode mode)
+        {
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+            if (fromId > toId)
+            {
+                std::swap(fromId, toId);
+            }
+
+            // Like the driver, the first range on an open filter replaces "everything".
+            if (channel->filter != FilterMode::Custom)
+            {
+                channel->ranges.clear();
+                channel->filter = FilterMode::Custom;
+            }
+            channel->ranges.push_back({ mode == PCAN_MODE_EXTENDED, fromId, toId });
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus ReadFlag(void* buffer, DWORD length, bool& flag)
+        {
+            if (buffer == nullptr || length < 1)
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+            BYTE value = 0;
+            std::memcpy(&value, buffer, 1);
+            flag = value == PCAN_PARAMETER_ON;
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus WriteDword(void* buffer, DWORD length, DWORD value)
+        {
+            if (buffer == nullptr || length < sizeof(DWORD))
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+            std::memcpy(buffer, &value, sizeof(value));
+            return PCAN_ERROR_OK;
+        }
+
+        TPCANStatus __stdcall GetValue(TPCANHandle handle, TPCANParameter parameter, void* buffer, DWORD length)
+        {
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+
+            if (parameter == PCAN_CHANNEL_CONDITION)
+            {
+                return WriteDword(buffer, length, FindInitialized(state, handle) != nullptr ? PCAN_CHANNEL_OCCUPIED : PCAN_CHANNEL_AVAILABLE);
+            }
+            if (parameter == PCAN_API_VERSION)
+            {
+                static constexpr char kVersion[] = "loopback";
+                if (buffer == nullptr || length < sizeof(kVersion))
+                {
+                    return PCAN_ERROR_ILLPARAMVAL;
+                }
+                std::memcpy(buffer, kVersion, sizeof(kVersion));
+                return PCAN_ERROR_OK;
+            }
+
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+
+            switch (parameter)
+            {
+#if !defined(_WIN32)
+            case PCAN_RECEIVE_EVENT:
+                if (buffer == nullptr || length < sizeof(int))
+                {
+                    return PCAN_ERROR_ILLPARAMVAL;
+                }
+                std::memcpy(buffer, &channel->receiveFd, sizeof(int));
+                return PCAN_ERROR_OK;
+#endif
+            case PCAN_BUSSPEED_NOMINAL:
+                return WriteDword(buffer, length, channel->bitrate);
+            case PCAN_MESSAGE_FILTER:
+                return WriteDword(buffer, length, channel->filter == FilterMode::Open ? PCAN_FILTER_OPEN : channel->filter == FilterMode::Closed ? PCAN_FILTER_CLOSE : PCAN_FILTER_CUSTOM);
+            default:
+                return PCAN_ERROR_ILLPARAMTYPE;
+            }
+        }
+
+        TPCANStatus __stdcall SetValue(TPCANHandle handle, TPCANParameter parameter, void* buffer, DWORD length)
+        {
+            State& state = Global();
+            std::lock_guard<std::mutex> lock(state.lock);
+            Channel* channel = FindInitialized(state, handle);
+            if (channel == nullptr)
+            {
+                return PCAN_ERROR_INITIALIZE;
+            }
+
+            switch (parameter)
+            {
+#if defined(_WIN32)
+            case PCAN_RECEIVE_EVENT:
+                if (buffer == nullptr || length < sizeof(HANDLE))
+                {
+                    return PCAN_ERROR_ILLPARAMVAL;
+                }
+                std::memcpy(&channel->receiveEvent, buffer, sizeof(HANDLE));
+                if (channel->receiveEvent != nullptr && !channel->rx.Empty())
+                {
+                    SetEvent(channel->receiveEvent);
+                }
+                return PCAN_ERROR_OK;
+#endif
+            case PCAN_MESSAGE_FILTER:
+            {
+                if (buffer == nullptr || length < 1)
+                {
+                    return PCAN_ERROR_ILLPARAMVAL;
+                }
+                BYTE value = 0;
+                std::memcpy(&value, buffer, 1);
+                if (value != PCAN_FILTER_OPEN && value != PCAN_FILTER_CLOSE)
+                {
+                    return PCAN_ERROR_ILLPARAMVAL;
+                }
+                channel->filter = value == PCAN_FILTER_OPEN ? FilterMode::Open : FilterMode::Closed;
+                channel->ranges.clear();
+                return PCAN_ERROR_OK;
+            }
+            case PCAN_ALLOW_ECHO_FRAMES:
+                return ReadFlag(buffer, length, channel->echo);
+            case PCAN_ALLOW_ERROR_FRAMES:
+                return ReadFlag(buffer, length, channel->errorFrames);
+            case PCAN_ALLOW_STATUS_FRAMES:
+                return ReadFlag(buffer, length, channel->statusFrames);
+            case PCAN_BUSOFF_AUTORESET:
+                return ReadFlag(buffer, length, channel->autoReset);
+            case PCAN_LISTEN_ONLY:
+                return ReadFlag(buffer, length, channel->listenOnly);
+            default:
+                return PCAN_ERROR_ILLPARAMTYPE;
+            }
+        }
+
+        TPCANStatus __stdcall GetErrorText(TPCANStatus error, WORD, LPSTR buffer)
+        {
+            if (buffer == nullptr)
+            {
+                return PCAN_ERROR_ILLPARAMVAL;
+            }
+
+            const char* text = "Undefined error";
+            switch (error)
+            {
+            case PCAN_ERROR_OK: text = "No error"; break;
+            case PCAN_ERROR_XMTFULL: text = "Transmit buffer in CAN controller is full"; break;
+            case PCAN_ERROR_OVERRUN: text = "CAN controller was read too late"; break;
+            case PCAN_ERROR_BUSOFF: text = "Bus error: the CAN controller is in bus-off state"; break;
+            case PCAN_ERROR_QRCVEMPTY: text = "Receive queue is empty"; break;
+            case PCAN_ERROR_QOVERRUN: text = "Receive queue was read too late"; break;
+            case PCAN_ERROR_QXMTFULL: text = "Transmit queue is full"; break;
+            case PCAN_ERROR_RESOURCE: text = "Resource (FIFO, Client, timeout) cannot be created"; break;
+            case PCAN_ERROR_ILLPARAMTYPE: text = "Invalid parameter"; break;
+            case PCAN_ERROR_ILLPARAMVAL: text = "Invalid parameter value"; break;
+            case PCAN_ERROR_INITIALIZE: text = "Channel is not initialized"; break;
+            case PCAN_ERROR_ILLOPERATION: text = "Invalid operation"; break;
+            default: break;
+            }
+            std::strcpy(buffer, text);
+            return PCAN_ERROR_OK;
+        }
+    }
+
+    PcanApi Api()
+    {
+        PcanApi api;
+        api.initialize = &Initialize;
+        api.uninitialize = &Uninitialize;
+        api.reset = &Reset;
+        api.getStatus = &GetStatus;
+        api.read = &Read;
+        api.write = &Write;
+        api.filterMessages = &FilterMessages;
+        api.getValue = &GetValue;
+        api.setValue = &SetValue;
+        api.getErrorText = &GetErrorText;
+        return api;
+    }
+
+    void ConfigureNet(int net, const NetOptions& options)
+    {
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        state.netOptions[net] = options;
+    }
+
+    void AssignChannel(TPCANHandle channel, int net)
+    {
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        state.assignments[channel] = net;
+    }
+
+    void InjectBusOff(TPCANHandle handle)
+    {
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        Channel* channel = FindInitialized(state, handle);
+        if (channel == nullptr || channel->busOff)
+        {
+            return;
+        }
+
+        channel->busOff = true;
+        channel->tx.Clear();
+        PushStatus(*channel, PCAN_ERROR_BUSOFF);
+    }
+
+    void InjectReadStatus(TPCANHandle handle, TPCANStatus status)
+    {
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        Channel* channel = FindInitialized(state, handle);
+        if (channel != nullptr)
+        {
+            channel->readStatuses.push_back(status);
+        }
+    }
+
+    NetStats Stats(int netId)
+    {
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        const auto it = state.nets.find(netId);
+        if (it == state.nets.end())
+        {
+            return {};
+        }
+
+        const Net& net = *it->second;
+        NetStats stats = net.stats;
+        stats.busyNs = net.bitrate != 0 ? BitsToNs(stats.bits, net.bitrate) : 0;
+        stats.elapsedNs = SteadyNowNs() - net.startNs;
+        return stats;
+    }
+
+    void Shutdown()
+    {
+        Uninitialize(PCAN_NONEBUS);
+
+        State& state = Global();
+        std::lock_guard<std::mutex> lock(state.lock);
+        state.netOptions.clear();
+        state.assignments.clear();
+    }
+
+    std::uint32_t FrameBits(std::uint32_t id, bool extended, std::uint8_t dlc, const std::uint8_t* data)
+    {
+        // The stuffed part runs from SOF to the end of the CRC; it is built MSB first.
+        std::uint8_t bits[160];
+        std::size_t count = 0;
+        auto put = [&](std::uint32_t value, int width) {
+            for (int bit = width - 1; bit >= 0; --bit)
+            {
+                bits[count++] = static_cast<std::uint8_t>((value >> bit) & 1);
+            }
+        };
+
+        const std::uint8_t length = std::min<std::uint8_t>(dlc, 8);
+        put(0, 1); // SOF
+        if (extended)
+        {
+            put(id >> 18 & 0x7FF, 11);
+            put(1, 1); // SRR
+            put(1, 1); // IDE
+            put(id & 0x3FFFF, 18);
+            put(0, 1); // RTR
+            put(0, 2); // r1, r0
+        }
+        else
+        {
+            put(id & 0x7FF, 11);
+            put(0, 1); // RTR
+            put(0, 1); // IDE
+            put(0, 1); // r0
+        }
+        put(length, 4);
+        for (std::uint8_t i = 0; i < length; ++i)
+        {
+            put(data[i], 8);
+        }
+
+        std::uint32_t crc = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::uint32_t next = bits[i] ^ ((crc >> 14) & 1);
+            crc = (crc << 1) & 0x7FFF;
+            if (next != 0)
+            {
+                crc ^= 0x4599;
+            }
+        }
+        put(crc, 15);
+
+        std::uint32_t stuffed = 0;
+        std::uint8_t last = bits[0];
+        int run = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (bits[i] == last)
+            {
+                ++run;
+            }
+            else
+            {
+                last = bits[i];
+                run = 1;
+            }
+            if (run == 5)
+            {
+                // The complement bit starts a new run of its own.
+                ++stuffed;
+                last = static_cast<std::uint8_t>(last ^ 1);
+                run = 1;
+            }
+        }
+
+        // CRC delimiter, ACK slot, ACK delimiter, EOF (7), intermission (3).
+        constexpr std::uint32_t kTrailerBits = 13;
+        return static_cast<std::uint32_t>(count) + stuffed + kTrailerBits;
+    }
+}
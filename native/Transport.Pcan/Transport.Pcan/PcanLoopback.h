@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "PcanApi.h"
+
+namespace TransportPcan
+{
+    /// <summary>
+    /// In-process stand-in for the PCAN-Basic driver: virtual channels on simulated CAN buses.
+    /// </summary>
+    /// <remarks>
+    /// Every initialized channel joins a virtual bus (net 0 unless assigned otherwise). A bus
+    /// thread per net arbitrates between the channels' transmit queues by CAN ID, charges each
+    /// frame its exact on-wire length (stuff bits included) at the bit rate given to
+    /// CAN_Initialize, and paces delivery to real time, so throughput and bus load behave like
+    /// a physical bus. Received frames carry a per-channel device timestamp (optionally skewed)
+    /// and raise the channel's receive event the way the driver does: an auto-reset event set
+    /// with CAN_SetValue on Windows, a readable descriptor from CAN_GetValue on Linux.
+    ///
+    /// Fault injection: a per-net probability that a transmission is destroyed by an error
+    /// frame (it is retried, costing bus time), forced bus-off and in-band read statuses per
+    /// channel. Receive queue overruns happen naturally when a reader falls behind and are
+    /// reported through CAN_GetStatus as PCAN_ERROR_QOVERRUN.
+    ///
+    /// Channels on the same bus must be initialized with the same bit rate. State is
+    /// process-wide, like the driver's.
+    /// </remarks>
+    namespace PcanLoopback
+    {
+        struct NetOptions
+        {
+            /// Deliver at the pace of the bit rate. Off, frames move as fast as the host can
+            /// copy them while bus time is still accounted.
+            bool paced = true;
+
+            /// Probability that a transmission attempt ends in an error frame and is retried.
+            double errorRate = 0;
+
+            /// Device clock rate error of the channels on this net, in parts per million.
+            double clockSkewPpm = 0;
+
+            std::size_t rxQueueFrames = 32768;
+            std::size_t txQueueFrames = 32768;
+
+            std::uint64_t seed = 1;
+        };
+
+        struct NetStats
+        {
+            std::uint32_t bitrate = 0;
+            std::uint64_t frames = 0;
+            /// Bits on the wire including stuffing, inter-frame space and error frames.
+            std::uint64_t bits = 0;
+            std::uint64_t errorFrames = 0;
+            /// Frames lost because a receiver's queue was full.
+            std::uint64_t rxOverruns = 0;
+            /// Time the bus spent carrying those bits; busyNs / elapsedNs is the bus load.
+            std::int64_t busyNs = 0;
+            /// Wall-clock time since the bus started.
+            std::int64_t elapsedNs = 0;
+        };
+
+        /// The loopback entry points in PcanApi form.
+        PcanApi Api();
+
+        /// Applies to buses started after the call (a net starts with its first channel).
+        void ConfigureNet(int net, const NetOptions& options);
+
+        /// Puts `channel` on `net` at its next CAN_Initialize.
+        void AssignChannel(TPCANHandle channel, int net);
+
+        /// Forces the channel into bus-off until it is re-initialized (or CAN_Reset with
+        /// PCAN_BUSOFF_AUTORESET on).
+        void InjectBusOff(TPCANHandle channel);
+
+        /// Makes the next CAN_Read on the channel that finds frames queued return `status`
+        /// without a frame, the way the driver reports PCAN_ERROR_BUSLIGHT, _BUSHEAVY or
+        /// _QOVERRUN in band. Repeated calls queue up.
+        void InjectReadStatus(TPCANHandle channel, TPCANStatus status);
+
+        NetStats Stats(int net);
+
+        /// Uninitializes every channel and forgets all net options and assignments.
+        void Shutdown();
+
+        /// On-wire bits of a classic data frame: SOF to end of intermission, including stuff
+        /// bits computed from the actual ID, payload and CRC.
+        std::uint32_t FrameBits(std::uint32_t id, bool extended, std::uint8_t dlc, const std::uint8_t* data);
+    }
+}
@@ -1 +1,632 @@
-#include "pch.h"
\ No newline at end of file
+#include "pch.h"
+
+#include "PcanTransport.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using DoorCore::Bump;
+using DoorCore::CanFrame;
+using DoorCore::HashId;
+using DoorCore::MsToNs;
+using DoorCore::SteadyNowNs;
+
+namespace TransportPcan
+{
+    namespace
+    {
+        /// Language argument of CAN_GetErrorText (0x09 = English).
+        constexpr WORD kErrorTextLanguage = 0x09;
+
+        /// Wait while frames are left over from a full driver transmit queue.
+        constexpr std::uint32_t kWriteRetryMs = 1;
+
+        /// Non-fatal statuses (bus light/heavy, overrun) read in one drain before yielding,
+        /// so a driver that keeps reporting one cannot starve the send path.
+        constexpr std::uint32_t kMaxStatusReadsPerDrain = 64;
+    }
+
+    // --------------------------
+    // HardwareClock
+    // --------------------------
+    void HardwareClock::Reset()
+    {
+        _epochStartNs = 0;
+        _currentMin = kNoSample;
+        _previousMin = kNoSample;
+        _last = INT64_MIN;
+    }
+
+    std::int64_t HardwareClock::ToHost(std::uint64_t deviceMicros, std::int64_t hostNowNs)
+    {
+        const std::int64_t deviceNs = static_cast<std::int64_t>(deviceMicros) * 1000;
+        const std::int64_t sample = hostNowNs - deviceNs;
+
+        if (_currentMin == kNoSample && _previousMin == kNoSample)
+        {
+            _epochStartNs = hostNowNs;
+        }
+        else if (hostNowNs - _epochStartNs >= kEpochNs)
+        {
+            _previousMin = _currentMin;
+            _currentMin = kNoSample;
+            _epochStartNs = hostNowNs;
+        }
+        _currentMin = std::min(_currentMin, sample);
+
+        const std::int64_t offset = std::min(_currentMin, _previousMin);
+        const std::int64_t host = std::max(std::min(deviceNs + offset, hostNowNs), _last);
+        _last = host;
+        return host;
+    }
+
+    // --------------------------
+    // PcanCanBus
+    // --------------------------
+    PcanCanBus::PcanCanBus(PcanCanBusOptions options, const PcanApi& api, DoorCore::CanBusLogHandler log)
+        : _options(options)
+        , _api(api)
+        , _log(std::move(log))
+    {
+    }
+
+#if TRANSPORT_PCAN_NATIVE
+    PcanCanBus::PcanCanBus(PcanCanBusOptions options, DoorCore::CanBusLogHandler log)
+        : PcanCanBus(options, PcanApi::Native(), std::move(log))
+    {
+    }
+#endif
+
+    PcanCanBus::~PcanCanBus()
+    {
+        Stop();
+    }
+
+    void PcanCanBus::Start(DoorCore::CanBusHandlers handlers)
+    {
+        if (_worker.joinable())
+        {
+            return;
+        }
+
+        _handlers = std::move(handlers);
+        _batch.assign(std::max<std::uint32_t>(_options.receiveBatch, 1), CanFrame{});
+
+        const std::size_t queue = std::max<std::uint32_t>(_options.sendQueue, 1);
+        _pending.assign(queue, CanFrame{});
+        _sending.assign(queue, CanFrame{});
+        if (_options.coalesceSameId)
+        {
+            // At most half full, so probing always ends at a stale slot.
+            const std::size_t slots = std::bit_ceil(queue * 2);
+            _pendingIndex.assign(slots, PendingSlot{ 0, 0, 0 });
+            _indexShift = 32 - static_cast<std::uint32_t>(std::countr_zero(slots));
+        }
+
+#if defined(_WIN32)
+        _wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+#else
+        _wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+
+        // Frame timestamps are UTC ticks advanced by the steady clock, so they stay monotonic
+        // for the run even if the wall clock is adjusted.
+        _anchorNs = SteadyNowNs();
+        _anchorTicks = DoorCore::UtcNowTicks();
+
+        _stopping.store(false, std::memory_order_relaxed);
+        _worker = std::thread([this] { WorkerLoop(); });
+    }
+
+    void PcanCanBus::Stop()
+    {
+        if (!_worker.joinable())
+        {
+            return;
+        }
+
+        _stopping.store(true, std::memory_order_release);
+        Wake();
+        _worker.join();
+        UpdateConnectionState(false);
+
+#if defined(_WIN32)
+        CloseHandle(_wakeEvent);
+        _wakeEvent = nullptr;
+#else
+        ::close(_wakeFd);
+        _wakeFd = -1;
+#endif
+    }
+
+    bool PcanCanBus::IsConnected() const
+    {
+        return _connected.load(std::memory_order_acquire);
+    }
+
+    bool PcanCanBus::Send(const CanFrame& frame)
+    {
+        return SendBatch(std::span<const CanFrame>(&frame, 1)) == 1;
+    }
+
+    std::size_t PcanCanBus::SendBatch(std::span<const CanFrame> frames)
+    {
+        if (frames.empty())
+        {
+            return 0;
+        }
+
+        std::size_t accepted = 0;
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(_sendLock);
+            if (_ready.load(std::memory_order_acquire))
+            {
+                wake = _pendingCount == 0;
+                accepted = Enqueue(frames);
+            }
+        }
+
+        // One wake per batch the worker has not picked up yet, however many frames it holds.
+        if (wake && accepted > 0)
+        {
+            Wake();
+        }
+        _framesDropped.fetch_add(frames.size() - accepted, std::memory_order_relaxed);
+        return accepted;
+    }
+
+    PcanCanBusStats PcanCanBus::Stats() const
+    {
+        PcanCanBusStats stats;
+        stats.framesSent = _framesSent.load(std::memory_order_relaxed);
+        stats.framesReceived = _framesReceived.load(std::memory_order_relaxed);
+        stats.framesDropped = _framesDropped.load(std::memory_order_relaxed);
+        stats.framesCoalesced = _framesCoalesced.load(std::memory_order_relaxed);
+        stats.framesSkipped = _framesSkipped.load(std::memory_order_relaxed);
+        stats.rxOverruns = _rxOverruns.load(std::memory_order_relaxed);
+        stats.busOffs = _busOffs.load(std::memory_order_relaxed);
+        stats.writeRetries = _writeRetries.load(std::memory_order_relaxed);
+        stats.wakeups = _wakeups.load(std::memory_order_relaxed);
+        stats.maxBurst = _maxBurst.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void PcanCanBus::WorkerLoop()
+    {
+        std::int64_t lastStatusPoll = 0;
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            if (!_ready.load(std::memory_order_acquire))
+            {
+                std::string error;
+                if (!Connect(error))
+                {
+                    LogFailure("Connect", error);
+                    SleepUnlessStopping(_options.retryIntervalMs);
+                    continue;
+                }
+
+                lastStatusPoll = SteadyNowNs();
+                UpdateConnectionState(true);
+            }
+
+            Wait(_sendingOffset < _sendingCount ? kWriteRetryMs : _options.statusPollMs);
+            Bump(_wakeups, 1);
+
+            bool healthy = DrainReceive() && FlushSends();
+
+            const std::int64_t now = SteadyNowNs();
+            if (healthy && now - lastStatusPoll >= MsToNs(_options.statusPollMs))
+            {
+                lastStatusPoll = now;
+                healthy = CheckStatus(_api.getStatus(_options.channel));
+            }
+
+            if (!healthy)
+            {
+                Disconnect();
+                UpdateConnectionState(false);
+                SleepUnlessStopping(_options.retryIntervalMs);
+            }
+        }
+
+        if (_ready.load(std::memory_order_acquire))
+        {
+            Disconnect();
+        }
+    }
+
+    bool PcanCanBus::Connect(std::string& error)
+    {
+        const TPCANStatus status = _api.initialize(_options.channel, _options.bitrate, 0, 0, 0);
+        if (status != PCAN_ERROR_OK)
+        {
+            error = "CAN_Initialize: " + ErrorText(status);
+            return false;
+        }
+
+#if defined(_WIN32)
+        HANDLE receiveEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        const TPCANStatus eventStatus = receiveEvent != nullptr
+            ? _api.setValue(_options.channel, PCAN_RECEIVE_EVENT, &receiveEvent, sizeof(receiveEvent))
+            : PCAN_ERROR_RESOURCE;
+        _receiveEvent = receiveEvent;
+#else
+        const TPCANStatus eventStatus = _api.getValue(_options.channel, PCAN_RECEIVE_EVENT, &_receiveFd, sizeof(_receiveFd));
+#endif
+        if (eventStatus != PCAN_ERROR_OK)
+        {
+            error = "PCAN_RECEIVE_EVENT: " + ErrorText(eventStatus);
+            Disconnect();
+            return false;
+        }
+
+        // A re-initialized device restarts its clock.
+        _clock.Reset();
+
+        std::lock_guard<std::mutex> lock(_sendLock);
+        _pendingCount = 0;
+        _sendingCount = 0;
+        _sendingOffset = 0;
+        _ready.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void PcanCanBus::Disconnect()
+    {
+        std::size_t abandoned = 0;
+        {
+            std::lock_guard<std::mutex> lock(_sendLock);
+            _ready.store(false, std::memory_order_release);
+            abandoned = _pendingCount + (_sendingCount - _sendingOffset);
+            _pendingCount = 0;
+            _sendingCount = 0;
+            _sendingOffset = 0;
+            ++_pendingGeneration;
+        }
+        _framesDropped.fetch_add(abandoned, std::memory_order_relaxed);
+
+        _api.uninitialize(_options.channel);
+
+#if defined(_WIN32)
+        if (_receiveEvent != nullptr)
+        {
+            CloseHandle(_receiveEvent);
+            _receiveEvent = nullptr;
+        }
+#else
+        // The descriptor belongs to the driver and is closed by CAN_Uninitialize.
+        _receiveFd = -1;
+#endif
+    }
+
+    void PcanCanBus::Wait(std::uint32_t milliseconds)
+    {
+#if defined(_WIN32)
+        HANDLE handles[] = { _receiveEvent, _wakeEvent };
+        WaitForMultipleObjects(2, handles, FALSE, milliseconds);
+#else
+        pollfd fds[] = { { _receiveFd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+        if (::poll(fds, 2, static_cast<int>(milliseconds)) > 0 && (fds[1].revents & POLLIN) != 0)
+        {
+            std::uint64_t value = 0;
+            [[maybe_unused]] const ssize_t read = ::read(_wakeFd, &value, sizeof(value));
+        }
+#endif
+    }
+
+    void PcanCanBus::Wake()
+    {
+#if defined(_WIN32)
+        SetEvent(_wakeEvent);
+#else
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = ::write(_wakeFd, &one, sizeof(one));
+#endif
+    }
+
+    bool PcanCanBus::DrainReceive()
+    {
+        std::size_t count = 0;
+        std::uint64_t burst = 0;
+        std::uint64_t skipped = 0;
+        std::uint32_t statusReads = 0;
+        bool healthy = true;
+
+        const auto deliver = [&] {
+            if (count == 0)
+            {
+                return;
+            }
+            burst += count;
+            Bump(_framesReceived, count);
+            if (_handlers.framesReceived)
+            {
+                _handlers.framesReceived(std::span<const CanFrame>(_batch.data(), count));
+            }
+            count = 0;
+        };
+
+        TPCANMsg message;
+        TPCANTimestamp timestamp;
+        for (;;)
+        {
+            const TPCANStatus status = _api.read(_options.channel, &message, &timestamp);
+            if ((status & PCAN_ERROR_QRCVEMPTY) != 0)
+            {
+                break;
+            }
+            if (status != PCAN_ERROR_OK)
+            {
+                // A warning or overrun comes in band without a frame; the frames behind it
+                // are still queued.
+                if (!CheckStatus(status))
+                {
+                    healthy = false;
+                    break;
+                }
+                if (++statusReads == kMaxStatusReadsPerDrain)
+                {
+                    break;
+                }
+                continue;
+            }
+
+            if ((message.MSGTYPE & PCAN_MESSAGE_STATUS) != 0)
+            {
+                ++skipped;
+                const std::uint32_t reported = static_cast<std::uint32_t>(message.DATA[0]) << 24
+                    | static_cast<std::uint32_t>(message.DATA[1]) << 16
+                    | static_cast<std::uint32_t>(message.DATA[2]) << 8
+                    | message.DATA[3];
+                if (!CheckStatus(reported))
+                {
+                    healthy = false;
+                    break;
+                }
+                continue;
+            }
+            if ((message.MSGTYPE & ~(PCAN_MESSAGE_EXTENDED | PCAN_MESSAGE_ECHO)) != 0)
+            {
+                // RTR, error frames and CAN FD messages have no CanFrame representation.
+                ++skipped;
+                continue;
+            }
+
+            CanFrame& frame = _batch[count++];
+            frame.id = message.ID;
+            frame.dlc = DoorCore::ClampDlc(message.LEN);
+            std::memset(frame.reserved, 0, sizeof(frame.reserved));
+            std::memcpy(frame.data, message.DATA, sizeof(frame.data));
+            frame.timestamp = ToTicks(timestamp);
+
+            if (count == _batch.size())
+            {
+                deliver();
+            }
+        }
+
+        deliver();
+        Bump(_framesSkipped, skipped);
+        if (burst > _maxBurst.load(std::memory_order_relaxed))
+        {
+            _maxBurst.store(burst, std::memory_order_relaxed);
+        }
+        return healthy;
+    }
+
+    bool PcanCanBus::FlushSends()
+    {
+        if (_options.coalesceSameId && _sendingOffset < _sendingCount)
+        {
+            // Frames left over from a full driver queue: drop those a newer queued frame
+            // supersedes, so a slow bus still only carries the latest state per ID.
+            std::lock_guard<std::mutex> lock(_sendLock);
+            std::size_t kept = _sendingOffset;
+            for (std::size_t i = _sendingOffset; i < _sendingCount; ++i)
+            {
+                if (FindPending(_sending[i].id).generation != _pendingGeneration)
+                {
+                    _sending[kept++] = _sending[i];
+                }
+            }
+            _framesCoalesced.fetch_add(_sendingCount - kept, std::memory_order_relaxed);
+            _sendingCount = kept;
+        }
+
+        TPCANMsg message{};
+        for (;;)
+        {
+            if (_sendingOffset == _sendingCount)
+            {
+                std::lock_guard<std::mutex> lock(_sendLock);
+                if (_pendingCount == 0)
+                {
+                    return true;
+                }
+
+                std::swap(_pending, _sending);
+                _sendingCount = _pendingCount;
+                _sendingOffset = 0;
+                _pendingCount = 0;
+                if (++_pendingGeneration == 0)
+                {
+                    std::fill(_pendingIndex.begin(), _pendingIndex.end(), PendingSlot{ 0, 0, 0 });
+                    _pendingGeneration = 1;
+                }
+            }
+
+            std::uint64_t sent = 0;
+            while (_sendingOffset < _sendingCount)
+            {
+                const CanFrame& frame = _sending[_sendingOffset];
+                message.ID = frame.id;
+                message.MSGTYPE = frame.id > DoorCore::kStandardIdMask ? PCAN_MESSAGE_EXTENDED : PCAN_MESSAGE_STANDARD;
+                message.LEN = DoorCore::ClampDlc(frame.dlc);
+                std::memcpy(message.DATA, frame.data, sizeof(frame.data));
+
+                const TPCANStatus status = _api.write(_options.channel, &message);
+                if (status == PCAN_ERROR_OK)
+                {
+                    ++_sendingOffset;
+                    ++sent;
+                    continue;
+                }
+
+                Bump(_framesSent, sent);
+                if (status == PCAN_ERROR_QXMTFULL || status == PCAN_ERROR_XMTFULL)
+                {
+                    // Keep the rest; the worker retries after kWriteRetryMs.
+                    Bump(_writeRetries, 1);
+                    return true;
+                }
+                if (!CheckStatus(status))
+                {
+                    return false;
+                }
+
+                // Rejected for this frame only (e.g. an ID out of range).
+                ++_sendingOffset;
+                _framesDropped.fetch_add(1, std::memory_order_relaxed);
+                LogFailure("CAN_Write", ErrorText(status));
+                sent = 0;
+            }
+            Bump(_framesSent, sent);
+        }
+    }
+
+    bool PcanCanBus::CheckStatus(TPCANStatus status)
+    {
+        if ((status & PCAN_ERROR_QOVERRUN) != 0 || (status & PCAN_ERROR_OVERRUN) != 0)
+        {
+            Bump(_rxOverruns, 1);
+        }
+        if ((status & PCAN_ERROR_BUSOFF) != 0)
+        {
+            Bump(_busOffs, 1);
+            LogFailure("Bus", ErrorText(PCAN_ERROR_BUSOFF));
+            return false;
+        }
+        if ((status & (PCAN_ERROR_INITIALIZE | PCAN_ERROR_ILLHANDLE | PCAN_ERROR_NODRIVER | PCAN_ERROR_ILLMODE)) != 0)
+        {
+            LogFailure("Channel", ErrorText(status));
+            return false;
+        }
+        return true;
+    }
+
+    std::size_t PcanCanBus::Enqueue(std::span<const CanFrame> frames)
+    {
+        const std::size_t capacity = _pending.size();
+        std::size_t accepted = 0;
+        std::uint64_t coalesced = 0;
+
+        for (const CanFrame& frame : frames)
+        {
+            if (_options.coalesceSameId)
+            {
+                PendingSlot& slot = FindPending(frame.id);
+                if (slot.generation == _pendingGeneration)
+                {
+                    _pending[slot.position] = frame;
+                    ++coalesced;
+                    ++accepted;
+                    continue;
+                }
+                if (_pendingCount == capacity)
+                {
+                    break;
+                }
+                slot = { frame.id, _pendingGeneration, static_cast<std::uint32_t>(_pendingCount) };
+            }
+            else if (_pendingCount == capacity)
+            {
+                break;
+            }
+
+            _pending[_pendingCount++] = frame;
+            ++accepted;
+        }
+
+        _framesCoalesced.fetch_add(coalesced, std::memory_order_relaxed);
+        return accepted;
+    }
+
+    PcanCanBus::PendingSlot& PcanCanBus::FindPending(std::uint32_t id)
+    {
+        const std::size_t mask = _pendingIndex.size() - 1;
+        std::size_t index = HashId(id, _indexShift);
+        while (_pendingIndex[index].generation == _pendingGeneration && _pendingIndex[index].id != id)
+        {
+            index = (index + 1) & mask;
+        }
+        return _pendingIndex[index];
+    }
+
+    std::int64_t PcanCanBus::ToTicks(const TPCANTimestamp& timestamp)
+    {
+        const std::int64_t hostNs = _clock.ToHost(TimestampMicros(timestamp), SteadyNowNs());
+        return _anchorTicks + (hostNs - _anchorNs) / 100;
+    }
+
+    std::string PcanCanBus::ErrorText(TPCANStatus status) const
+    {
+        char text[256] = {};
+        if (_api.getErrorText(status, kErrorTextLanguage, text) != PCAN_ERROR_OK)
+        {
+            std::snprintf(text, sizeof(text), "PCAN status 0x%X", static_cast<unsigned>(status));
+        }
+        return text;
+    }
+
+    bool PcanCanBus::SleepUnlessStopping(std::uint32_t milliseconds)
+    {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+        while (std::chrono::steady_clock::now() < until)
+        {
+            if (_stopping.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return !_stopping.load(std::memory_order_acquire);
+    }
+
+    void PcanCanBus::UpdateConnectionState(bool isConnected)
+    {
+        if (_connected.exchange(isConnected, std::memory_order_acq_rel) == isConnected)
+        {
+            return;
+        }
+
+        if (_handlers.connectionStateChanged)
+        {
+            _handlers.connectionStateChanged(isConnected);
+        }
+    }
+
+    void PcanCanBus::LogFailure(const std::string& operation, const std::string& detail) const
+    {
+        if (!_log)
+        {
+            return;
+        }
+
+        char channel[16];
+        std::snprintf(channel, sizeof(channel), "0x%02X", static_cast<unsigned>(_options.channel));
+        _log("PcanCanBus channel " + std::string(channel) + " " + operation + " failed.", detail);
+    }
+}
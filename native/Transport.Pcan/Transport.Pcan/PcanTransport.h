@@ -1 +1,199 @@
 #pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CanBus.h"
+#include "PcanApi.h"
+
+namespace TransportPcan
+{
+    /// <summary>
+    /// Maps a channel's device timestamps onto the host steady clock.
+    /// </summary>
+    /// <remarks>
+    /// Every reception gives a sample of (host time at read - device time). Transport delay
+    /// only ever adds to it, so the smallest sample is the best offset estimate. The minimum
+    /// is kept over two rolling epochs so device clock drift is followed within an epoch or
+    /// two. Results never exceed the read time and never go backwards.
+    /// </remarks>
+    class HardwareClock
+    {
+    public:
+        static constexpr std::int64_t kEpochNs = 1'000'000'000;
+
+        /// Forgets all samples; call whenever the device clock may have restarted.
+        void Reset();
+
+        /// Host steady-clock nanoseconds at which a frame stamped `deviceMicros` was on the
+        /// bus, given that it was read at `hostNowNs`.
+        std::int64_t ToHost(std::uint64_t deviceMicros, std::int64_t hostNowNs);
+
+    private:
+        static constexpr std::int64_t kNoSample = INT64_MAX;
+
+        std::int64_t _epochStartNs = 0;
+        std::int64_t _currentMin = kNoSample;
+        std::int64_t _previousMin = kNoSample;
+        std::int64_t _last = INT64_MIN;
+    };
+
+    struct PcanCanBusOptions
+    {
+        TPCANHandle channel = PCAN_USBBUS1;
+        TPCANBaudrate bitrate = PCAN_BAUD_500K;
+
+        /// Maximum frames handed to framesReceived per call; also the read buffer size.
+        std::uint32_t receiveBatch = 256;
+
+        /// Frames Send/SendBatch can queue ahead of the worker; more are dropped.
+        std::uint32_t sendQueue = 4096;
+
+        /// Delay between attempts while the channel cannot be initialized, and after bus-off.
+        std::uint32_t retryIntervalMs = 500;
+
+        /// Longest the worker waits for the receive event before polling the bus status.
+        std::uint32_t statusPollMs = 100;
+
+        /// A queued frame is replaced by a later one with the same ID instead of sending both,
+        /// so a backed-up queue carries only the latest state per ID. Applies to frames still
+        /// held by the transport; the driver's own transmit queue is FIFO.
+        bool coalesceSameId = false;
+    };
+
+    struct PcanCanBusStats
+    {
+        std::uint64_t framesSent = 0;
+        std::uint64_t framesReceived = 0;
+        /// Frames rejected by Send (not connected or send queue full).
+        std::uint64_t framesDropped = 0;
+        /// Queued frames replaced by a newer frame with the same ID.
+        std::uint64_t framesCoalesced = 0;
+        /// Received RTR, error and status messages, which are not forwarded.
+        std::uint64_t framesSkipped = 0;
+        /// Receive queue overruns reported by the driver (occurrences, not frames).
+        std::uint64_t rxOverruns = 0;
+        /// Bus-off events.
+        std::uint64_t busOffs = 0;
+        /// Writes retried because the driver's transmit queue was full.
+        std::uint64_t writeRetries = 0;
+        /// Worker wake-ups (receive event, queued sends or status poll).
+        std::uint64_t wakeups = 0;
+        /// Largest number of frames drained in one wake-up.
+        std::uint64_t maxBurst = 0;
+    };
+
+    /// <summary>
+    /// CAN transport on a PEAK adapter through the PCAN-Basic API.
+    /// </summary>
+    /// <remarks>
+    /// One worker thread owns the channel. It sleeps on the driver's receive event (never
+    /// polling CAN_Read), drains the receive queue in bursts into a preallocated batch, and
+    /// stamps frames with the hardware timestamp mapped through HardwareClock onto UTC ticks
+    /// that are monotonic for the run.
+    ///
+    /// Send/SendBatch only copy into a preallocated queue and wake the worker, which writes
+    /// everything queued in one pass; optionally frames with the same ID coalesce while they
+    /// wait. Bus-off drops the connection and the channel is re-initialized after the retry
+    /// interval. The API is reached through PcanApi, so the same code runs on the vendor
+    /// library or on PcanLoopback.
+    /// </remarks>
+    class PcanCanBus final : public DoorCore::ICanBus
+    {
+    public:
+        PcanCanBus(PcanCanBusOptions options, const PcanApi& api, DoorCore::CanBusLogHandler log = nullptr);
+#if TRANSPORT_PCAN_NATIVE
+        explicit PcanCanBus(PcanCanBusOptions options = {}, DoorCore::CanBusLogHandler log = nullptr);
+#endif
+        ~PcanCanBus() override;
+
+        PcanCanBus(const PcanCanBus&) = delete;
+        PcanCanBus& operator=(const PcanCanBus&) = delete;
+
+        void Start(DoorCore::CanBusHandlers handlers) override;
+        void Stop() override;
+        bool IsConnected() const override;
+        bool Send(const DoorCore::CanFrame& frame) override;
+        std::size_t SendBatch(std::span<const DoorCore::CanFrame> frames) override;
+
+        PcanCanBusStats Stats() const;
+
+    private:
+        struct PendingSlot
+        {
+            std::uint32_t id;
+            std::uint32_t generation;
+            std::uint32_t position;
+        };
+
+        void WorkerLoop();
+        bool Connect(std::string& error);
+        void Disconnect();
+        void Wait(std::uint32_t milliseconds);
+        void Wake();
+
+        /// Returns false if the channel has to be re-initialized.
+        bool DrainReceive();
+        bool FlushSends();
+        bool CheckStatus(TPCANStatus status);
+
+        std::size_t Enqueue(std::span<const DoorCore::CanFrame> frames);
+        /// The index slot of `id` in _pending: a live slot if queued, else where it would go.
+        PendingSlot& FindPending(std::uint32_t id);
+        std::int64_t ToTicks(const TPCANTimestamp& timestamp);
+        std::string ErrorText(TPCANStatus status) const;
+        bool SleepUnlessStopping(std::uint32_t milliseconds);
+        void UpdateConnectionState(bool isConnected);
+        void LogFailure(const std::string& operation, const std::string& detail) const;
+
+        const PcanCanBusOptions _options;
+        const PcanApi _api;
+        const DoorCore::CanBusLogHandler _log;
+
+        DoorCore::CanBusHandlers _handlers;
+        std::vector<DoorCore::CanFrame> _batch;
+        HardwareClock _clock;
+        std::int64_t _anchorTicks = 0;
+        std::int64_t _anchorNs = 0;
+
+        std::atomic<bool> _ready{ false };
+        std::atomic<bool> _connected{ false };
+        std::atomic<bool> _stopping{ false };
+        std::thread _worker;
+
+        // Producers append to _pending under _sendLock; the worker swaps it with _sending and
+        // writes without holding the lock.
+        std::mutex _sendLock;
+        std::vector<DoorCore::CanFrame> _pending;
+        std::size_t _pendingCount = 0;
+        std::vector<PendingSlot> _pendingIndex;
+        std::uint32_t _pendingGeneration = 1;
+        std::uint32_t _indexShift = 32;
+        std::vector<DoorCore::CanFrame> _sending;
+        std::size_t _sendingCount = 0;
+        std::size_t _sendingOffset = 0;
+
+#if defined(_WIN32)
+        void* _receiveEvent = nullptr;
+        void* _wakeEvent = nullptr;
+#else
+        int _receiveFd = -1;
+        int _wakeFd = -1;
+#endif
+
+        std::atomic<std::uint64_t> _framesSent{ 0 };
+        std::atomic<std::uint64_t> _framesReceived{ 0 };
+        std::atomic<std::uint64_t> _framesDropped{ 0 };
+        std::atomic<std::uint64_t> _framesCoalesced{ 0 };
+        std::atomic<std::uint64_t> _framesSkipped{ 0 };
+        std::atomic<std::uint64_t> _rxOverruns{ 0 };
+        std::atomic<std::uint64_t> _busOffs{ 0 };
+        std::atomic<std::uint64_t> _writeRetries{ 0 };
+        std::atomic<std::uint64_t> _wakeups{ 0 };
+        std::atomic<std::uint64_t> _maxBurst{ 0 };
+    };
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Public entry point for the Transport.Pcan static library.
+#include "PcanApi.h"
+#include "PcanLoopback.h"
+#include "PcanTransport.h"
@@ -0,0 +1,17 @@
+// Transport.Shm.Bench: benchmarks for the Transport.Shm static library.
+//
+// Usage: Transport.Shm.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "bus", "Shared-memory bus throughput/latency vs. a per-frame socket baseline, backpressure, slow and stalled clients", TransportShmBench::RunBusBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Transport.Shm.Bench", kBenchmarks, argc, argv);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TransportShmBench
+{
+    int RunBusBench(int argc, char** argv);
+}
@@ -0,0 +1,580 @@
+// Throughput and latency of ShmCanBus against a socket baseline that mimics IpcCanBus.
+//
+// Usage: Transport.Shm.Bench bus [clients] [frames] [roundTrips]
+//
+// broadcast  server sends `frames`; every client must see them (shm: or count them lost).
+//            Rates are frames delivered per client, so lost frames do not count as throughput;
+//            shm-bp runs the shm bus with broadcastBackpressure, which must lose nothing
+// upstream   every client sends frames/clients; the server must receive them all
+// latency    one client pings, the server echoes; reports round-trip percentiles
+// slow       shm only: a slow client on a small ring must see every frame it does not count
+//            as lost intact and in order, while the server overwrites what it is copying
+// stall      shm only: a client's handler blocks past the peer timeout while another thread
+//            keeps sending; a second client takes over the slot and the lane must only ever
+//            carry one producer's frames
+
+#include "BenchSupport.h"
+
+#include "ShmCanBus.h"
+#include "SocketBaseline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using DoorCore::CanFrame;
+using DoorCore::ICanBus;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::size_t kSendBatch = 64;
+    constexpr auto kDeliveryTimeout = std::chrono::seconds(20);
+
+    struct Topology
+    {
+        std::unique_ptr<ICanBus> server;
+        std::vector<std::unique_ptr<ICanBus>> clients;
+    };
+
+    using TopologyFactory = std::function<Topology(std::size_t clients)>;
+
+    struct Counters
+    {
+        std::atomic<std::uint64_t> received{ 0 };
+    };
+
+    CanFrame MakeFrame(std::uint64_t sequence)
+    {
+        CanFrame frame{};
+        frame.id = 0x200u + static_cast<std::uint32_t>(sequence & 0xFF);
+        frame.dlc = 8;
+        for (int b = 0; b < 8; ++b)
+        {
+            frame.data[b] = static_cast<std::uint8_t>(sequence >> (8 * b));
+        }
+        return frame;
+    }
+
+    bool WaitUntil(const std::function<bool()>& condition)
+    {
+        const auto deadline = Clock::now() + kDeliveryTimeout;
+        while (!condition())
+        {
+            if (Clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    }
+
+    bool WaitConnected(Topology& topology)
+    {
+        return WaitUntil([&]
+        {
+            if (!topology.server->IsConnected())
+            {
+                return false;
+            }
+            return std::all_of(topology.clients.begin(), topology.clients.end(), [](const auto& c) { return c->IsConnected(); });
+        });
+    }
+
+    void StartAll(Topology& topology, Counters& serverCounter, std::vector<Counters>& clientCounters, bool echo)
+    {
+        ICanBus* server = topology.server.get();
+        DoorCore::CanBusHandlers serverHandlers;
+        serverHandlers.framesReceived = [&serverCounter, server, echo](std::span<const CanFrame> frames)
+        {
+            serverCounter.received.fetch_add(frames.size(), std::memory_order_relaxed);
+            if (echo)
+            {
+                server->SendBatch(frames);
+            }
+        };
+        topology.server->Start(serverHandlers);
+
+        for (std::size_t i = 0; i < topology.clients.size(); ++i)
+        {
+            Counters& counter = clientCounters[i];
+            DoorCore::CanBusHandlers handlers;
+            handlers.framesReceived = [&counter](std::span<const CanFrame> frames)
+            {
+                counter.received.fetch_add(frames.size(), std::memory_order_relaxed);
+            };
+            topology.clients[i]->Start(handlers);
+        }
+    }
+
+    void StopAll(Topology& topology)
+    {
+        for (auto& client : topology.clients)
+        {
+            client->Stop();
+        }
+        topology.server->Stop();
+    }
+
+    std::uint64_t LostFrames(const ICanBus& bus)
+    {
+        if (const auto* shm = dynamic_cast<const TransportShm::ShmCanBus*>(&bus))
+        {
+            return shm->Stats().framesLost;
+        }
+        return 0;
+    }
+
+    /// Returns false when a lossless bus lost or failed to deliver frames.
+    bool RunBroadcast(const char* name, const TopologyFactory& factory, bool lossless, std::size_t clientCount, std::uint64_t frames)
+    {
+        Topology topology = factory(clientCount);
+        Counters serverCounter;
+        std::vector<Counters> clientCounters(clientCount);
+        StartAll(topology, serverCounter, clientCounters, false);
+        if (!WaitConnected(topology))
+        {
+            std::printf("%-8s broadcast  connect timeout\n", name);
+            StopAll(topology);
+            return !lossless;
+        }
+
+        std::vector<CanFrame> batch(kSendBatch);
+        const Clock::time_point start = Clock::now();
+        for (std::uint64_t s = 0; s < frames; s += kSendBatch)
+        {
+            const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kSendBatch, frames - s));
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                batch[i] = MakeFrame(s + i);
+            }
+            // A bus with backpressure accepts part of a batch; resend the rest like a writer
+            // blocked on a full pipe.
+            std::size_t offset = 0;
+            while (offset < n && Clock::now() - start < kDeliveryTimeout)
+            {
+                const std::size_t sent = topology.server->SendBatch(std::span<const CanFrame>(batch.data() + offset, n - offset));
+                offset += sent;
+                if (sent == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        const bool complete = WaitUntil([&]
+        {
+            for (std::size_t i = 0; i < clientCount; ++i)
+            {
+                if (clientCounters[i].received.load() + LostFrames(*topology.clients[i]) < frames)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::uint64_t delivered = 0;
+        std::uint64_t lost = 0;
+        for (std::size_t i = 0; i < clientCount; ++i)
+        {
+            delivered += clientCounters[i].received.load();
+            lost += LostFrames(*topology.clients[i]);
+        }
+        StopAll(topology);
+
+        const bool pass = !lossless || (complete && lost == 0 && delivered == frames * clientCount);
+        std::printf(
+            "%-8s broadcast  %12.0f frames/s delivered per client  %12.0f deliveries/s  lost %llu%s%s\n",
+            name,
+            delivered / static_cast<double>(clientCount) / seconds,
+            delivered / seconds,
+            static_cast<unsigned long long>(lost),
+            complete ? "" : "  (timeout)",
+            lossless ? (pass ? "  PASS" : "  FAIL") : "");
+        return pass;
+    }
+
+    void RunUpstream(const char* name, const TopologyFactory& factory, std::size_t clientCount, std::uint64_t frames)
+    {
+        Topology topology = factory(clientCount);
+        Counters serverCounter;
+        std::vector<Counters> clientCounters(clientCount);
+        StartAll(topology, serverCounter, clientCounters, false);
+        if (!WaitConnected(topology))
+        {
+            std::printf("%-8s upstream   connect timeout\n", name);
+            StopAll(topology);
+            return;
+        }
+
+        const std::uint64_t perClient = frames / clientCount;
+        const Clock::time_point start = Clock::now();
+        std::vector<std::thread> senders;
+        for (std::size_t c = 0; c < clientCount; ++c)
+        {
+            senders.emplace_back([&, c]
+            {
+                std::vector<CanFrame> batch(kSendBatch);
+                for (std::uint64_t s = 0; s < perClient; )
+                {
+                    const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kSendBatch, perClient - s));
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        batch[i] = MakeFrame(s + i);
+                    }
+
+                    // Retry on a full lane so the run measures throughput, not drops.
+                    std::size_t sent = 0;
+                    while (sent < n)
+                    {
+                        const std::size_t accepted = topology.clients[c]->SendBatch(std::span<const CanFrame>(batch.data() + sent, n - sent));
+                        if (accepted == 0)
+                        {
+                            std::this_thread::yield();
+                        }
+                        sent += accepted;
+                    }
+                    s += n;
+                }
+            });
+        }
+        for (std::thread& sender : senders)
+        {
+            sender.join();
+        }
+
+        const std::uint64_t expected = perClient * clientCount;
+        const bool complete = WaitUntil([&] { return serverCounter.received.load() >= expected; });
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        StopAll(topology);
+
+        std::printf(
+            "%-8s upstream   %12.0f frames/s received%s\n",
+            name,
+            serverCounter.received.load() / seconds,
+            complete ? "" : "  (timeout)");
+    }
+
+    void RunLatency(const char* name, const TopologyFactory& factory, std::uint64_t roundTrips)
+    {
+        Topology topology = factory(1);
+        Counters serverCounter;
+        std::vector<Counters> clientCounters(1);
+        StartAll(topology, serverCounter, clientCounters, true);
+        if (!WaitConnected(topology))
+        {
+            std::printf("%-8s latency    connect timeout\n", name);
+            StopAll(topology);
+            return;
+        }
+
+        std::vector<double> samples;
+        samples.reserve(static_cast<std::size_t>(roundTrips));
+        for (std::uint64_t i = 0; i < roundTrips; ++i)
+        {
+            const std::uint64_t before = clientCounters[0].received.load(std::memory_order_acquire);
+            const Clock::time_point sent = Clock::now();
+            topology.clients[0]->Send(MakeFrame(i));
+            const auto deadline = sent + std::chrono::seconds(1);
+            while (clientCounters[0].received.load(std::memory_order_acquire) == before && Clock::now() < deadline)
+            {
+            }
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+        }
+        StopAll(topology);
+
+        std::sort(samples.begin(), samples.end());
+        const auto percentile = [&](double p) { return samples[static_cast<std::size_t>(p * (samples.size() - 1))]; };
+        std::printf(
+            "%-8s latency    round trip p50 %8.2f us  p99 %8.2f us  p99.9 %8.2f us  max %8.2f us\n",
+            name,
+            percentile(0.50),
+            percentile(0.99),
+            percentile(0.999),
+            samples.back());
+    }
+
+    bool RunSlowClient(std::uint64_t frames)
+    {
+        constexpr std::uint32_t kRing = 4096;
+        constexpr std::size_t kBurst = 4096;
+
+        // The client copies up to a whole ring per pass, so the server's next half-ring
+        // chunk lands on slots it is still copying.
+        TransportShm::ShmCanBusOptions options;
+        options.geometry.ringCapacity = kRing;
+        options.geometry.maxClients = 1;
+        options.retryIntervalMs = 5;
+        options.receiveBatch = kRing;
+        TransportShm::ShmCanBus server("rail-shm-bench-slow", TransportShm::ShmCanBusRole::Server, options);
+        TransportShm::ShmCanBus client("rail-shm-bench-slow", TransportShm::ShmCanBusRole::Client, options);
+
+        // Checked on the client's receive thread: sequence numbers must rise, every frame must
+        // be self-consistent, and the gaps must add up to what the client reports lost.
+        std::atomic<std::uint64_t> received{ 0 };
+        std::uint64_t next = 0;
+        std::uint64_t gaps = 0;
+        std::uint64_t torn = 0;
+        std::uint64_t reordered = 0;
+        DoorCore::CanBusHandlers handlers;
+        handlers.framesReceived = [&](std::span<const CanFrame> batch)
+        {
+            for (const CanFrame& frame : batch)
+            {
+                std::uint64_t sequence = 0;
+                for (int b = 0; b < 8; ++b)
+                {
+                    sequence |= static_cast<std::uint64_t>(frame.data[b]) << (8 * b);
+                }
+                if (frame.id != 0x200u + static_cast<std::uint32_t>(sequence & 0xFF) || frame.dlc != 8)
+                {
+                    ++torn;
+                    continue;
+                }
+                if (sequence < next)
+                {
+                    ++reordered;
+                    continue;
+                }
+                gaps += sequence - next;
+                next = sequence + 1;
+            }
+
+            // Fall behind on purpose.
+            const Clock::time_point until = Clock::now() + std::chrono::microseconds(20);
+            while (Clock::now() < until)
+            {
+            }
+            received.fetch_add(batch.size(), std::memory_order_release);
+        };
+
+        server.Start({});
+        client.Start(handlers);
+        if (!WaitUntil([&] { return server.IsConnected() && client.IsConnected(); }))
+        {
+            std::printf("shm      slow       connect timeout  FAIL\n");
+            client.Stop();
+            server.Stop();
+            return false;
+        }
+
+        std::vector<CanFrame> burst(kBurst);
+        for (std::uint64_t s = 0; s < frames; s += kBurst)
+        {
+            const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kBurst, frames - s));
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                burst[i] = MakeFrame(s + i);
+            }
+            server.SendBatch(std::span<const CanFrame>(burst.data(), n));
+        }
+
+        const bool complete = WaitUntil([&] { return received.load(std::memory_order_acquire) + client.Stats().framesLost >= frames; });
+        client.Stop();
+        server.Stop();
+
+        const std::uint64_t lost = client.Stats().framesLost;
+        const bool pass = complete && torn == 0 && reordered == 0 && gaps == lost && next == frames;
+        std::printf("shm      slow       %llu delivered  %llu lost  gaps %llu  torn %llu  out of order %llu  %s\n",
+            static_cast<unsigned long long>(received.load()),
+            static_cast<unsigned long long>(lost),
+            static_cast<unsigned long long>(gaps),
+            static_cast<unsigned long long>(torn),
+            static_cast<unsigned long long>(reordered),
+            pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    bool RunStalledClient()
+    {
+        constexpr std::uint32_t kTagA = 0x300;
+        constexpr std::uint32_t kTagB = 0x400;
+
+        TransportShm::ShmCanBusOptions options;
+        options.geometry.maxClients = 1;
+        options.heartbeatIntervalMs = 10;
+        options.peerTimeoutMs = 100;
+        options.retryIntervalMs = 5;
+
+        // Server side, on its receive thread: per-client sequences must rise, and once B's
+        // frames arrive nothing from A may follow.
+        std::uint64_t nextA = 0;
+        std::uint64_t nextB = 0;
+        std::uint64_t fromB = 0;
+        std::uint64_t aAfterB = 0;
+        std::uint64_t reordered = 0;
+        DoorCore::CanBusHandlers serverHandlers;
+        serverHandlers.framesReceived = [&](std::span<const CanFrame> batch)
+        {
+            for (const CanFrame& frame : batch)
+            {
+                std::uint64_t sequence = 0;
+                std::memcpy(&sequence, frame.data, sizeof(sequence));
+                std::uint64_t& next = frame.id == kTagA ? nextA : nextB;
+                reordered += sequence < next ? 1 : 0;
+                next = sequence + 1;
+                fromB += frame.id == kTagB ? 1 : 0;
+                aAfterB += frame.id == kTagA && fromB > 0 ? 1 : 0;
+            }
+        };
+
+        std::atomic<bool> stalled{ false };
+        std::atomic<int> dropsA{ 0 };
+        DoorCore::CanBusHandlers handlersA;
+        handlersA.framesReceived = [&](std::span<const CanFrame>)
+        {
+            if (!stalled.exchange(true))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(600));
+            }
+        };
+        handlersA.connectionStateChanged = [&](bool connected) { dropsA.fetch_add(connected ? 0 : 1); };
+
+        TransportShm::ShmCanBus server("rail-shm-bench-stall", TransportShm::ShmCanBusRole::Server, options);
+        TransportShm::ShmCanBus clientA("rail-shm-bench-stall", TransportShm::ShmCanBusRole::Client, options);
+        TransportShm::ShmCanBus clientB("rail-shm-bench-stall", TransportShm::ShmCanBusRole::Client, options);
+        server.Start(serverHandlers);
+        clientA.Start(handlersA);
+        if (!WaitUntil([&] { return server.IsConnected() && clientA.IsConnected(); }))
+        {
+            std::printf("shm      stall      connect timeout  FAIL\n");
+            clientA.Stop();
+            server.Stop();
+            return false;
+        }
+        clientB.Start({});
+
+        const auto sender = [](TransportShm::ShmCanBus& bus, std::uint32_t tag, const std::atomic<bool>& done)
+        {
+            std::uint64_t sequence = 0;
+            while (!done.load())
+            {
+                CanFrame frame{};
+                frame.id = tag;
+                frame.dlc = 8;
+                std::memcpy(frame.data, &sequence, sizeof(sequence));
+                sequence += bus.Send(frame) ? 1 : 0;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        };
+        std::atomic<bool> done{ false };
+        std::thread sendA([&] { sender(clientA, kTagA, done); });
+        std::thread sendB([&] { sender(clientB, kTagB, done); });
+
+        server.Send(MakeFrame(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        done.store(true);
+        sendA.join();
+        sendB.join();
+        const bool tookOver = clientB.IsConnected() && !clientA.IsConnected();
+        clientB.Stop();
+        clientA.Stop();
+        server.Stop();
+
+        const bool pass = stalled.load() && tookOver && dropsA.load() == 1 && fromB > 0 && aAfterB == 0 && reordered == 0;
+        std::printf("shm      stall      A stalled 600 ms, B took the slot: %llu frames from B, %llu from A after B, out of order %llu  %s\n",
+            static_cast<unsigned long long>(fromB),
+            static_cast<unsigned long long>(aAfterB),
+            static_cast<unsigned long long>(reordered),
+            pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    TopologyFactory ShmFactory(bool backpressure)
+    {
+        return [backpressure](std::size_t clients)
+        {
+            static int run = 0;
+            const std::string name = "rail-shm-bench-" + std::to_string(++run);
+
+            TransportShm::ShmCanBusOptions options;
+            options.geometry.maxClients = static_cast<std::uint32_t>(clients);
+            options.broadcastBackpressure = backpressure;
+
+            Topology topology;
+            topology.server = std::make_unique<TransportShm::ShmCanBus>(name, TransportShm::ShmCanBusRole::Server, options);
+            for (std::size_t i = 0; i < clients; ++i)
+            {
+                TransportShm::ShmCanBusOptions clientOptions = options;
+                clientOptions.retryIntervalMs = 5;
+                topology.clients.push_back(std::make_unique<TransportShm::ShmCanBus>(name, TransportShm::ShmCanBusRole::Client, clientOptions));
+            }
+            return topology;
+        };
+    }
+
+#if !defined(_WIN32)
+    TopologyFactory SocketFactory()
+    {
+        return [](std::size_t clients)
+        {
+            std::unique_ptr<TransportShmBench::SocketBus> server;
+            std::vector<std::unique_ptr<TransportShmBench::SocketBus>> sockets;
+            TransportShmBench::SocketBus::CreateTopology(clients, server, sockets);
+
+            Topology topology;
+            topology.server = std::move(server);
+            for (auto& socket : sockets)
+            {
+                topology.clients.push_back(std::move(socket));
+            }
+            return topology;
+        };
+    }
+#endif
+}
+
+int TransportShmBench::RunBusBench(int argc, char** argv)
+{
+    const std::size_t clients = argc > 0 ? std::strtoull(argv[0], nullptr, 10) : 4;
+    const std::uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    const std::uint64_t roundTrips = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20'000;
+    if (clients == 0 || frames < clients || roundTrips == 0)
+    {
+        std::fprintf(stderr, "clients, frames and roundTrips must be > 0 (frames >= clients)\n");
+        return 1;
+    }
+
+    std::printf("bus: %zu clients, %llu frames, %llu round trips\n\n",
+        clients,
+        static_cast<unsigned long long>(frames),
+        static_cast<unsigned long long>(roundTrips));
+
+    struct Candidate
+    {
+        const char* name;
+        TopologyFactory factory;
+        bool lossless;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.push_back({ "shm", ShmFactory(false), false });
+    candidates.push_back({ "shm-bp", ShmFactory(true), true });
+#if !defined(_WIN32)
+    candidates.push_back({ "socket", SocketFactory(), true });
+#endif
+
+    bool pass = true;
+    for (const Candidate& candidate : candidates)
+    {
+        pass = RunBroadcast(candidate.name, candidate.factory, candidate.lossless, clients, frames) && pass;
+        RunUpstream(candidate.name, candidate.factory, clients, frames);
+        RunLatency(candidate.name, candidate.factory, roundTrips);
+        std::printf("\n");
+    }
+    pass = RunSlowClient(frames) && pass;
+    pass = RunStalledClient() && pass;
+    return pass ? 0 : 1;
+}
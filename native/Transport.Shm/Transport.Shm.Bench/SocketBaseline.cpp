@@ -0,0 +1,156 @@
+#include "SocketBaseline.h"
+
+#if !defined(_WIN32)
+
+#include "FrameCodec.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+using DoorCore::CanFrame;
+namespace FrameCodec = DoorCore::FrameCodec;
+
+namespace TransportShmBench
+{
+    SocketBus::SocketBus(std::vector<int> fds)
+        : _fds(std::move(fds))
+    {
+    }
+
+    SocketBus::~SocketBus()
+    {
+        Stop();
+        for (int fd : _fds)
+        {
+            close(fd);
+        }
+    }
+
+    void SocketBus::CreateTopology(
+        std::size_t clientCount,
+        std::unique_ptr<SocketBus>& server,
+        std::vector<std::unique_ptr<SocketBus>>& clients)
+    {
+        std::vector<int> serverFds;
+        clients.clear();
+        for (std::size_t i = 0; i < clientCount; ++i)
+        {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            {
+                break;
+            }
+            serverFds.push_back(pair[0]);
+            clients.emplace_back(new SocketBus({ pair[1] }));
+        }
+        server.reset(new SocketBus(std::move(serverFds)));
+    }
+
+    void SocketBus::Start(DoorCore::CanBusHandlers handlers)
+    {
+        _handlers = std::move(handlers);
+        _running.store(true);
+        for (int fd : _fds)
+        {
+            _readers.emplace_back([this, fd] { ReadLoop(fd); });
+        }
+        if (_handlers.connectionStateChanged)
+        {
+            _handlers.connectionStateChanged(true);
+        }
+    }
+
+    void SocketBus::Stop()
+    {
+        if (!_running.exchange(false))
+        {
+            return;
+        }
+
+        for (int fd : _fds)
+        {
+            shutdown(fd, SHUT_RDWR);
+        }
+        for (std::thread& reader : _readers)
+        {
+            reader.join();
+        }
+        _readers.clear();
+    }
+
+    bool SocketBus::IsConnected() const
+    {
+        return _running.load();
+    }
+
+    bool SocketBus::Send(const CanFrame& frame)
+    {
+        std::uint8_t record[FrameCodec::kMaxRecordSize];
+        const std::size_t size = FrameCodec::Encode(frame, record);
+
+        // Like IpcCanBus: every frame is written (and flushed) to every connection in turn.
+        std::lock_guard<std::mutex> lock(_writeLock);
+        bool ok = true;
+        for (int fd : _fds)
+        {
+            std::size_t written = 0;
+            while (written < size)
+            {
+                const ssize_t n = write(fd, record + written, size - written);
+                if (n <= 0)
+                {
+                    if (n < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    ok = false;
+                    break;
+                }
+                written += static_cast<std::size_t>(n);
+            }
+        }
+        return ok;
+    }
+
+    void SocketBus::ReadLoop(int fd)
+    {
+        std::vector<std::uint8_t> buffer(64 * 1024);
+        std::vector<CanFrame> frames(buffer.size() / (FrameCodec::kLengthPrefixSize + FrameCodec::kHeaderSize));
+        std::size_t filled = 0;
+
+        while (_running.load(std::memory_order_relaxed))
+        {
+            const ssize_t n = read(fd, buffer.data() + filled, buffer.size() - filled);
+            if (n <= 0)
+            {
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            filled += static_cast<std::size_t>(n);
+
+            const FrameCodec::BatchDecodeResult result =
+                FrameCodec::DecodeBatch(std::span<const std::uint8_t>(buffer.data(), filled), frames);
+            if (result.status == FrameCodec::DecodeStatus::Invalid)
+            {
+                return;
+            }
+
+            if (result.frames != 0 && _handlers.framesReceived)
+            {
+                std::lock_guard<std::mutex> lock(_deliverLock);
+                _handlers.framesReceived(std::span<const CanFrame>(frames.data(), result.frames));
+            }
+
+            std::memmove(buffer.data(), buffer.data() + result.consumed, filled - result.consumed);
+            filled -= result.consumed;
+        }
+    }
+}
+
+#endif
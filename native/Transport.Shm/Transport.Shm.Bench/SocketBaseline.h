@@ -0,0 +1,49 @@
+#pragma once
+
+#if !defined(_WIN32)
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CanBus.h"
+
+namespace TransportShmBench
+{
+    /// <summary>
+    /// Baseline bus that behaves like IpcCanBus on a stream socket: one reader thread per
+    /// connection, one length-prefixed record and one write() per frame per client.
+    /// </summary>
+    class SocketBus final : public DoorCore::ICanBus
+    {
+    public:
+        ~SocketBus() override;
+
+        /// Creates a connected server endpoint and clientCount client endpoints.
+        static void CreateTopology(
+            std::size_t clientCount,
+            std::unique_ptr<SocketBus>& server,
+            std::vector<std::unique_ptr<SocketBus>>& clients);
+
+        void Start(DoorCore::CanBusHandlers handlers) override;
+        void Stop() override;
+        bool IsConnected() const override;
+        bool Send(const DoorCore::CanFrame& frame) override;
+
+    private:
+        explicit SocketBus(std::vector<int> fds);
+
+        void ReadLoop(int fd);
+
+        std::vector<int> _fds;
+        DoorCore::CanBusHandlers _handlers;
+        std::vector<std::thread> _readers;
+        std::mutex _writeLock;
+        std::mutex _deliverLock;
+        std::atomic<bool> _running{ false };
+    };
+}
+
+#endif
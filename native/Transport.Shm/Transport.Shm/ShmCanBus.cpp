@@ -0,0 +1,593 @@
+#include "pch.h"
+
+#include "ShmCanBus.h"
+#include "Primitives.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+using DoorCore::CanFrame;
+using DoorCore::MsToNs;
+using DoorCore::SteadyNowNs;
+
+namespace TransportShm
+{
+    ShmCanBus::ShmCanBus(std::string name, ShmCanBusRole role, ShmCanBusOptions options, DoorCore::CanBusLogHandler log)
+        : _name(std::move(name))
+        , _role(role)
+        , _options(options)
+        , _log(std::move(log))
+    {
+    }
+
+    ShmCanBus::~ShmCanBus()
+    {
+        Stop();
+    }
+
+    void ShmCanBus::Start(DoorCore::CanBusHandlers handlers)
+    {
+        if (_worker.joinable())
+        {
+            return;
+        }
+
+        _handlers = std::move(handlers);
+        _batch.assign(std::max<std::uint32_t>(_options.receiveBatch, 1), CanFrame{});
+        _stopping.store(false, std::memory_order_relaxed);
+
+        if (_role == ShmCanBusRole::Server)
+        {
+            _worker = std::thread([this] { ServerLoop(); });
+        }
+        else
+        {
+            _worker = std::thread([this] { ClientLoop(); });
+        }
+    }
+
+    void ShmCanBus::Stop()
+    {
+        if (!_worker.joinable())
+        {
+            return;
+        }
+
+        _stopping.store(true, std::memory_order_release);
+        {
+            // The worker maps/unmaps under _sendLock, so the region is stable here.
+            std::lock_guard<std::mutex> lock(_sendLock);
+            if (_region.IsMapped())
+            {
+                // Wake our own receive loop if it is parked on a doorbell.
+                _region.RingDoorbell(_role == ShmCanBusRole::Server ? _region.Header().upBell : _region.Header().downBell);
+            }
+        }
+        _worker.join();
+        UpdateConnectionState(false);
+    }
+
+    bool ShmCanBus::IsConnected() const
+    {
+        return _connected.load(std::memory_order_acquire);
+    }
+
+    bool ShmCanBus::Send(const CanFrame& frame)
+    {
+        return SendBatch(std::span<const CanFrame>(&frame, 1)) == 1;
+    }
+
+    std::size_t ShmCanBus::SendBatch(std::span<const CanFrame> frames)
+    {
+        if (frames.empty())
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(_sendLock);
+        if (!_ready.load(std::memory_order_acquire))
+        {
+            _framesDropped.fetch_add(frames.size(), std::memory_order_relaxed);
+            return 0;
+        }
+
+        const std::size_t sent = _role == ShmCanBusRole::Server ? Broadcast(frames) : SendUpstream(frames);
+        _framesSent.fetch_add(sent, std::memory_order_relaxed);
+        _framesDropped.fetch_add(frames.size() - sent, std::memory_order_relaxed);
+        return sent;
+    }
+
+    ShmCanBusStats ShmCanBus::Stats() const
+    {
+        ShmCanBusStats stats;
+        stats.framesSent = _framesSent.load(std::memory_order_relaxed);
+        stats.framesReceived = _framesReceived.load(std::memory_order_relaxed);
+        stats.framesLost = _framesLost.load(std::memory_order_relaxed);
+        stats.framesDropped = _framesDropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // --------------------------
+    // Server implementation
+    // --------------------------
+    void ShmCanBus::ServerLoop()
+    {
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            std::string error;
+            {
+                std::lock_guard<std::mutex> lock(_sendLock);
+                if (_region.Create(_name, _options.geometry, error))
+                {
+                    _region.Header().serverHeartbeat.store(SteadyNowNs(), std::memory_order_release);
+                    _ready.store(true, std::memory_order_release);
+                    break;
+                }
+            }
+
+            LogFailure("ServerLoop", error);
+            SleepUnlessStopping(_options.retryIntervalMs);
+        }
+
+        if (!_ready.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        RegionHeader& header = _region.Header();
+        std::uint32_t spins = 0;
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            const std::int64_t now = SteadyNowNs();
+            if (now - _lastHeartbeat >= MsToNs(_options.heartbeatIntervalMs))
+            {
+                ServerHousekeeping(now);
+            }
+
+            // Sample the bell before scanning so a frame published after the scan wakes us.
+            const std::uint32_t observed = header.upBell.sequence.load(std::memory_order_acquire);
+            if (ServerDrainLanes())
+            {
+                spins = 0;
+                continue;
+            }
+
+            if (++spins < _options.spinBeforeWait)
+            {
+                continue;
+            }
+
+            spins = 0;
+            _region.WaitDoorbell(header.upBell, observed, _options.heartbeatIntervalMs);
+        }
+
+        std::lock_guard<std::mutex> lock(_sendLock);
+        _ready.store(false, std::memory_order_release);
+        header.serverHeartbeat.store(0, std::memory_order_release);
+        _region.RingDoorbell(header.downBell);
+        _region.Close();
+    }
+
+    bool ShmCanBus::ServerDrainLanes()
+    {
+        const RegionHeader& header = _region.Header();
+        const std::uint64_t laneMask = header.laneCapacity - 1;
+        bool any = false;
+
+        for (std::uint32_t i = 0; i < header.maxClients; ++i)
+        {
+            // Rotate the starting lane so a chatty client cannot starve the others.
+            const std::uint32_t index = (_nextLane + i) % header.maxClients;
+            ClientSlot& slot = _region.Slot(index);
+            if (slot.state.load(std::memory_order_acquire) != static_cast<std::uint32_t>(ClientSlotState::Attached))
+            {
+                continue;
+            }
+
+            const CanFrame* lane = _region.UpLane(index);
+            std::uint64_t read = slot.upRead.load(std::memory_order_relaxed);
+            const std::uint64_t write = slot.upWrite.load(std::memory_order_acquire);
+            while (read != write)
+            {
+                const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(write - read, _batch.size()));
+                for (std::size_t n = 0; n < count; ++n)
+                {
+                    _batch[n] = lane[(read + n) & laneMask];
+                }
+
+                // A client may detach and a new one attach (resetting upRead to upWrite) while
+                // this copy runs. Its reset cursor is always past `read`, so the exchange fails,
+                // the copy - possibly overwritten by the new owner - is dropped and the new
+                // owner's cursor is left alone.
+                std::uint64_t expected = read;
+                if (!slot.upRead.compare_exchange_strong(expected, read + count, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    break;
+                }
+                read += count;
+                Deliver(count);
+                any = true;
+            }
+        }
+
+        _nextLane = (_nextLane + 1) % header.maxClients;
+        return any;
+    }
+
+    void ShmCanBus::ServerHousekeeping(std::int64_t now)
+    {
+        _lastHeartbeat = now;
+        RegionHeader& header = _region.Header();
+        header.serverHeartbeat.store(now, std::memory_order_release);
+
+        bool anyConnected = false;
+        for (std::uint32_t i = 0; i < header.maxClients; ++i)
+        {
+            ClientSlot& slot = _region.Slot(i);
+            const std::uint32_t state = slot.state.load(std::memory_order_acquire);
+            const std::int64_t silence = now - slot.heartbeat.load(std::memory_order_acquire);
+            if (state == static_cast<std::uint32_t>(ClientSlotState::Reclaimed))
+            {
+                // The old owner had a full timeout to notice; now the slot may be reused.
+                if (silence > 2 * MsToNs(_options.peerTimeoutMs))
+                {
+                    std::uint32_t expected = state;
+                    slot.state.compare_exchange_strong(expected, static_cast<std::uint32_t>(ClientSlotState::Free));
+                }
+                continue;
+            }
+            if (state != static_cast<std::uint32_t>(ClientSlotState::Attached))
+            {
+                continue;
+            }
+
+            if (silence > MsToNs(_options.peerTimeoutMs))
+            {
+                // Client died (or stalled) without detaching; stop draining its lane.
+                std::uint32_t expected = state;
+                slot.state.compare_exchange_strong(expected, static_cast<std::uint32_t>(ClientSlotState::Reclaimed));
+                continue;
+            }
+
+            anyConnected = true;
+        }
+
+        UpdateConnectionState(anyConnected);
+    }
+
+    std::size_t ShmCanBus::Broadcast(std::span<const CanFrame> frames)
+    {
+        RegionHeader& header = _region.Header();
+        CanFrame* ring = _region.DownRing();
+        const std::uint64_t capacity = header.ringCapacity;
+        const std::uint64_t mask = capacity - 1;
+
+        std::uint64_t write = header.downWrite.load(std::memory_order_relaxed);
+        if (_options.broadcastBackpressure)
+        {
+            // Clients publish downRead once a batch is copied out, so the ring slots behind
+            // the slowest cursor are free. A client attaching meanwhile starts at downWrite,
+            // which is never behind that cursor.
+            std::uint64_t slowest = write;
+            for (std::uint32_t i = 0; i < header.maxClients; ++i)
+            {
+                const ClientSlot& slot = _region.Slot(i);
+                if (slot.state.load(std::memory_order_acquire) == static_cast<std::uint32_t>(ClientSlotState::Attached))
+                {
+                    slowest = std::min(slowest, slot.downRead.load(std::memory_order_acquire));
+                }
+            }
+            const std::uint64_t room = capacity - std::min<std::uint64_t>(write - slowest, capacity);
+            frames = frames.first(static_cast<std::size_t>(std::min<std::uint64_t>(frames.size(), room)));
+            if (frames.empty())
+            {
+                return 0;
+            }
+        }
+
+        std::size_t offset = 0;
+        while (offset < frames.size())
+        {
+            // Publish at most half a ring at a time so a long batch never overwrites its own
+            // unpublished frames and readers get a chance to consume each chunk.
+            const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(frames.size() - offset, capacity / 2));
+
+            // Reserve the chunk before touching its slots: a reader that copies any of them
+            // then sees the reservation when it validates.
+            header.downReserve.store(write + chunk, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t n = 0; n < chunk; ++n)
+            {
+                ring[(write + n) & mask] = frames[offset + n];
+            }
+
+            write += chunk;
+            header.downWrite.store(write, std::memory_order_release);
+            offset += chunk;
+        }
+
+        _region.RingDoorbell(header.downBell);
+        return frames.size();
+    }
+
+    // --------------------------
+    // Client implementation
+    // --------------------------
+    void ShmCanBus::ClientLoop()
+    {
+        std::uint32_t spins = 0;
+        while (!_stopping.load(std::memory_order_acquire))
+        {
+            if (!_ready.load(std::memory_order_acquire))
+            {
+                std::string error;
+                if (!ClientAttach(error))
+                {
+                    LogFailure("ClientConnectLoop", error);
+                    SleepUnlessStopping(_options.retryIntervalMs);
+                    continue;
+                }
+
+                UpdateConnectionState(true);
+            }
+
+            const std::int64_t now = SteadyNowNs();
+            if (now - _lastHeartbeat >= MsToNs(_options.heartbeatIntervalMs))
+            {
+                // Check ownership first: a client that lost its slot must not keep the new
+                // owner's heartbeat fresh.
+                _lastHeartbeat = now;
+                if (!ClientPeerAlive(now))
+                {
+                    ClientDetach();
+                    UpdateConnectionState(false);
+                    continue;
+                }
+                _region.Slot(_slot).heartbeat.store(now, std::memory_order_release);
+            }
+
+            Doorbell& bell = _region.Header().downBell;
+            const std::uint32_t observed = bell.sequence.load(std::memory_order_acquire);
+            if (ClientDrainBroadcast())
+            {
+                spins = 0;
+                continue;
+            }
+
+            if (++spins < _options.spinBeforeWait)
+            {
+                continue;
+            }
+
+            spins = 0;
+            _region.WaitDoorbell(bell, observed, _options.heartbeatIntervalMs);
+        }
+
+        if (_ready.load(std::memory_order_acquire))
+        {
+            ClientDetach();
+        }
+    }
+
+    bool ShmCanBus::ClientAttach(std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(_sendLock);
+
+        if (!_region.Open(_name, error))
+        {
+            return false;
+        }
+
+        const std::int64_t now = SteadyNowNs();
+        if (!ClientPeerAlive(now))
+        {
+            error = "server for region '" + _name + "' is not running";
+            _region.Close();
+            return false;
+        }
+
+        RegionHeader& header = _region.Header();
+        for (std::uint32_t i = 0; i < header.maxClients; ++i)
+        {
+            ClientSlot& slot = _region.Slot(i);
+            std::uint32_t expected = static_cast<std::uint32_t>(ClientSlotState::Free);
+            if (!slot.state.compare_exchange_strong(expected, static_cast<std::uint32_t>(ClientSlotState::Claiming)))
+            {
+                continue;
+            }
+
+            // New clients see only frames broadcast after they attach, like a fresh pipe.
+            _downRead = header.downWrite.load(std::memory_order_acquire);
+            slot.downRead.store(_downRead, std::memory_order_relaxed);
+            slot.upRead.store(slot.upWrite.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            slot.downLost.store(0, std::memory_order_relaxed);
+            slot.upDropped.store(0, std::memory_order_relaxed);
+            slot.heartbeat.store(now, std::memory_order_relaxed);
+            _slotOwner = slot.owner.load(std::memory_order_relaxed) + 1;
+            slot.owner.store(_slotOwner, std::memory_order_relaxed);
+            slot.state.store(static_cast<std::uint32_t>(ClientSlotState::Attached), std::memory_order_release);
+
+            _slot = i;
+            _lastHeartbeat = now;
+            _ready.store(true, std::memory_order_release);
+            return true;
+        }
+
+        error = "region '" + _name + "' has no free client slot";
+        _region.Close();
+        return false;
+    }
+
+    void ShmCanBus::ClientDetach()
+    {
+        std::lock_guard<std::mutex> lock(_sendLock);
+        _ready.store(false, std::memory_order_release);
+
+        if (_slot != kNoSlot && _region.IsMapped() && ClientOwnsSlot())
+        {
+            std::uint32_t expected = static_cast<std::uint32_t>(ClientSlotState::Attached);
+            _region.Slot(_slot).state.compare_exchange_strong(expected, static_cast<std::uint32_t>(ClientSlotState::Free));
+        }
+
+        _slot = kNoSlot;
+        _region.Close();
+    }
+
+    bool ShmCanBus::ClientPeerAlive(std::int64_t now) const
+    {
+        const RegionHeader& header = _region.Header();
+        const std::int64_t heartbeat = header.serverHeartbeat.load(std::memory_order_acquire);
+        if (heartbeat == 0 || now - heartbeat > MsToNs(_options.peerTimeoutMs))
+        {
+            return false;
+        }
+
+        // The server reclaims slots of clients it considers dead.
+        return _slot == kNoSlot || ClientOwnsSlot();
+    }
+
+    bool ShmCanBus::ClientOwnsSlot() const
+    {
+        const ClientSlot& slot = _region.Slot(_slot);
+        return slot.state.load(std::memory_order_acquire) == static_cast<std::uint32_t>(ClientSlotState::Attached)
+            && slot.owner.load(std::memory_order_acquire) == _slotOwner;
+    }
+
+    bool ShmCanBus::ClientDrainBroadcast()
+    {
+        const RegionHeader& header = _region.Header();
+        const CanFrame* ring = _region.DownRing();
+        const std::uint64_t capacity = header.ringCapacity;
+        const std::uint64_t mask = capacity - 1;
+
+        const std::uint64_t write = header.downWrite.load(std::memory_order_acquire);
+        if (write == _downRead)
+        {
+            return false;
+        }
+
+        if (write - _downRead > capacity)
+        {
+            _framesLost.fetch_add(write - _downRead - capacity, std::memory_order_relaxed);
+            _downRead = write - capacity;
+        }
+
+        const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(write - _downRead, _batch.size()));
+        for (std::size_t n = 0; n < count; ++n)
+        {
+            _batch[n] = ring[(_downRead + n) & mask];
+        }
+
+        // Validate the copy: the slot at _downRead is reused once the writer has reserved
+        // past _downRead + capacity, which happens before it publishes the chunk.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t reserved = header.downReserve.load(std::memory_order_relaxed);
+        if (reserved - _downRead > capacity)
+        {
+            const std::uint64_t oldestValid = reserved - capacity;
+            _framesLost.fetch_add(oldestValid - _downRead, std::memory_order_relaxed);
+            _downRead = oldestValid;
+            return true;
+        }
+
+        _downRead += count;
+        if (ClientOwnsSlot())
+        {
+            ClientSlot& slot = _region.Slot(_slot);
+            slot.downRead.store(_downRead, std::memory_order_release);
+            slot.downLost.store(_framesLost.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        Deliver(count);
+        return true;
+    }
+
+    std::size_t ShmCanBus::SendUpstream(std::span<const CanFrame> frames)
+    {
+        RegionHeader& header = _region.Header();
+        ClientSlot& slot = _region.Slot(_slot);
+        CanFrame* lane = _region.UpLane(_slot);
+        const std::uint64_t capacity = header.laneCapacity;
+        const std::uint64_t mask = capacity - 1;
+
+        // A handler stalled past the peer timeout lets the server reclaim the slot while Send
+        // is still called from other threads; only the current owner may produce.
+        if (!ClientOwnsSlot())
+        {
+            return 0;
+        }
+
+        const std::uint64_t write = slot.upWrite.load(std::memory_order_relaxed);
+        const std::uint64_t read = slot.upRead.load(std::memory_order_acquire);
+        const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(capacity - (write - read), frames.size()));
+        if (count == 0)
+        {
+            slot.upDropped.fetch_add(frames.size(), std::memory_order_relaxed);
+            return 0;
+        }
+
+        for (std::size_t n = 0; n < count; ++n)
+        {
+            lane[(write + n) & mask] = frames[n];
+        }
+        if (!ClientOwnsSlot())
+        {
+            return 0;
+        }
+        slot.upWrite.store(write + count, std::memory_order_release);
+        slot.upDropped.fetch_add(frames.size() - count, std::memory_order_relaxed);
+
+        _region.RingDoorbell(header.upBell);
+        return count;
+    }
+
+    // --------------------------
+    // Shared helpers
+    // --------------------------
+    void ShmCanBus::Deliver(std::size_t count)
+    {
+        _framesReceived.fetch_add(count, std::memory_order_relaxed);
+        if (_handlers.framesReceived)
+        {
+            _handlers.framesReceived(std::span<const CanFrame>(_batch.data(), count));
+        }
+    }
+
+    bool ShmCanBus::SleepUnlessStopping(std::uint32_t milliseconds)
+    {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+        while (std::chrono::steady_clock::now() < until)
+        {
+            if (_stopping.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return !_stopping.load(std::memory_order_acquire);
+    }
+
+    void ShmCanBus::UpdateConnectionState(bool isConnected)
+    {
+        if (_connected.exchange(isConnected, std::memory_order_acq_rel) == isConnected)
+        {
+            return;
+        }
+
+        if (_handlers.connectionStateChanged)
+        {
+            _handlers.connectionStateChanged(isConnected);
+        }
+    }
+
+    void ShmCanBus::LogFailure(const std::string& operation, const std::string& detail) const
+    {
+        if (!_log)
+        {
+            return;
+        }
+
+        const char* role = _role == ShmCanBusRole::Server ? "Server" : "Client";
+        _log("ShmCanBus " + std::string(role) + " region '" + _name + "' " + operation + " failed.", detail);
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CanBus.h"
+#include "ShmRegion.h"
+
+namespace TransportShm
+{
+    /// <summary>
+    /// Role of a ShmCanBus endpoint, mirroring IpcCanBusRole.
+    /// </summary>
+    enum class ShmCanBusRole
+    {
+        /// Creates the region, broadcasts to every client and receives from all of them.
+        Server,
+        /// Attaches to a server's region, receives broadcasts and sends upstream.
+        Client
+    };
+
+    struct ShmCanBusOptions
+    {
+        /// Used by the server when creating the region; clients adopt the server's layout.
+        RegionGeometry geometry;
+
+        std::uint32_t heartbeatIntervalMs = 100;
+
+        /// A peer whose heartbeat is older than this is treated as disconnected.
+        std::uint32_t peerTimeoutMs = 1000;
+
+        /// Delay between attempts while the region cannot be created/opened.
+        std::uint32_t retryIntervalMs = 500;
+
+        /// Maximum frames handed to framesReceived per call.
+        std::uint32_t receiveBatch = 256;
+
+        /// Polls before a receive loop sleeps on the doorbell; trades CPU for latency.
+        std::uint32_t spinBeforeWait = 256;
+
+        /// Server: accept only as many frames as the slowest attached client has room for,
+        /// like a full pipe, instead of overwriting frames it has not read yet. Send then
+        /// returns fewer frames than offered and the caller retries; a stalled client holds
+        /// the server back until the peer timeout reclaims its slot.
+        bool broadcastBackpressure = false;
+    };
+
+    struct ShmCanBusStats
+    {
+        std::uint64_t framesSent = 0;
+        std::uint64_t framesReceived = 0;
+        /// Client: broadcast frames overwritten before they were read.
+        std::uint64_t framesLost = 0;
+        /// Frames rejected by Send (not connected or upstream lane full).
+        std::uint64_t framesDropped = 0;
+    };
+
+    /// <summary>
+    /// Shared-memory CAN bus: a high-throughput alternative to the named-pipe IpcCanBus for
+    /// endpoints on the same machine.
+    /// </summary>
+    /// <remarks>
+    /// The server writes each frame once into a broadcast ring that every client reads through
+    /// its own cursor, so fan-out costs no copies or syscalls per client. Clients send through
+    /// a private SPSC lane that the server drains round-robin. Receive loops spin briefly and
+    /// then sleep on a futex doorbell, and writers only issue a wake when someone sleeps.
+    ///
+    /// By default a slow client never blocks the server: if it falls more than a ring behind
+    /// it skips to the oldest retained frame and counts the overwritten ones as lost, so the
+    /// frames Send accepts are not all delivered. With broadcastBackpressure the server
+    /// instead accepts only what the slowest client has room for and nothing is lost. Liveness is tracked
+    /// with heartbeats in the region, which drive the connection state like the pipe loops do.
+    /// Heartbeats come from the receive thread, so a handler blocked past the peer timeout
+    /// loses the slot: the server stops draining it and frees it a timeout later, and the
+    /// client checks the slot's owner token before every send so two producers never share
+    /// a lane. The client then reconnects like after a server restart.
+    /// </remarks>
+    class ShmCanBus final : public DoorCore::ICanBus
+    {
+    public:
+        ShmCanBus(std::string name, ShmCanBusRole role, ShmCanBusOptions options = {}, DoorCore::CanBusLogHandler log = nullptr);
+        ~ShmCanBus() override;
+
+        ShmCanBus(const ShmCanBus&) = delete;
+        ShmCanBus& operator=(const ShmCanBus&) = delete;
+
+        void Start(DoorCore::CanBusHandlers handlers) override;
+        void Stop() override;
+        bool IsConnected() const override;
+        bool Send(const DoorCore::CanFrame& frame) override;
+        std::size_t SendBatch(std::span<const DoorCore::CanFrame> frames) override;
+
+        ShmCanBusStats Stats() const;
+
+    private:
+        static constexpr std::uint32_t kNoSlot = UINT32_MAX;
+
+        void ServerLoop();
+        void ClientLoop();
+
+        bool ServerDrainLanes();
+        bool ClientDrainBroadcast();
+        void ServerHousekeeping(std::int64_t now);
+        bool ClientAttach(std::string& error);
+        void ClientDetach();
+        bool ClientPeerAlive(std::int64_t now) const;
+        bool ClientOwnsSlot() const;
+
+        std::size_t Broadcast(std::span<const DoorCore::CanFrame> frames);
+        std::size_t SendUpstream(std::span<const DoorCore::CanFrame> frames);
+
+        void Deliver(std::size_t count);
+        bool SleepUnlessStopping(std::uint32_t milliseconds);
+        void UpdateConnectionState(bool isConnected);
+        void LogFailure(const std::string& operation, const std::string& detail) const;
+
+        const std::string _name;
+        const ShmCanBusRole _role;
+        const ShmCanBusOptions _options;
+        const DoorCore::CanBusLogHandler _log;
+
+        DoorCore::CanBusHandlers _handlers;
+        ShmRegion _region;
+        std::vector<DoorCore::CanFrame> _batch;
+
+        // Published by the worker once the region is usable; Send checks it without locking.
+        std::atomic<bool> _ready{ false };
+        std::atomic<bool> _connected{ false };
+        std::atomic<bool> _stopping{ false };
+        std::thread _worker;
+
+        // Send may be called from any thread; the region has one writer per ring/lane.
+        std::mutex _sendLock;
+
+        std::uint32_t _slot = kNoSlot;
+        std::uint32_t _slotOwner = 0;
+        std::uint64_t _downRead = 0;
+        std::uint32_t _nextLane = 0;
+        std::int64_t _lastHeartbeat = 0;
+
+        std::atomic<std::uint64_t> _framesSent{ 0 };
+        std::atomic<std::uint64_t> _framesReceived{ 0 };
+        std::atomic<std::uint64_t> _framesLost{ 0 };
+        std::atomic<std::uint64_t> _framesDropped{ 0 };
+    };
+}
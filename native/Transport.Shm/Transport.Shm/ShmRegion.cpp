@@ -0,0 +1,394 @@
+#include "pch.h"
+
+#include "ShmRegion.h"
+
+#include <climits>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace TransportShm
+{
+    namespace
+    {
+        constexpr std::size_t AlignUp(std::size_t value, std::size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        std::uint32_t RoundUpPow2(std::uint32_t value)
+        {
+            std::uint32_t result = 2;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        struct Layout
+        {
+            std::size_t slots;
+            std::size_t down;
+            std::size_t up;
+            std::size_t total;
+        };
+
+        Layout ComputeLayout(std::uint32_t ringCapacity, std::uint32_t laneCapacity, std::uint32_t maxClients)
+        {
+            Layout layout{};
+            layout.slots = AlignUp(sizeof(RegionHeader), kCacheLine);
+            layout.down = AlignUp(layout.slots + sizeof(ClientSlot) * maxClients, kCacheLine);
+            layout.up = AlignUp(layout.down + sizeof(DoorCore::CanFrame) * ringCapacity, kCacheLine);
+            layout.total = AlignUp(layout.up + sizeof(DoorCore::CanFrame) * laneCapacity * maxClients, kCacheLine);
+            return layout;
+        }
+
+#if !defined(_WIN32)
+        std::string PosixName(const std::string& name)
+        {
+            std::string result = "/";
+            for (char c : name)
+            {
+                result.push_back(c == '/' ? '_' : c);
+            }
+            return result;
+        }
+#endif
+    }
+
+    ShmRegion::~ShmRegion()
+    {
+        Close();
+    }
+
+    std::size_t ShmRegion::RequiredSize(RegionGeometry geometry)
+    {
+        return ComputeLayout(
+            RoundUpPow2(geometry.ringCapacity),
+            RoundUpPow2(geometry.laneCapacity),
+            geometry.maxClients).total;
+    }
+
+    bool ShmRegion::Create(const std::string& name, RegionGeometry geometry, std::string& error)
+    {
+        Close();
+
+        if (geometry.maxClients == 0)
+        {
+            error = "maxClients must be > 0";
+            return false;
+        }
+
+        const std::uint32_t ringCapacity = RoundUpPow2(geometry.ringCapacity);
+        const std::uint32_t laneCapacity = RoundUpPow2(geometry.laneCapacity);
+        const Layout layout = ComputeLayout(ringCapacity, laneCapacity, geometry.maxClients);
+
+        if (!Map(name, layout.total, true, error))
+        {
+            return false;
+        }
+
+        // Fresh mapping: construct the atomics in place, then publish the magic last so
+        // clients never observe a half-initialized header.
+        std::memset(_base, 0, layout.total);
+        auto* header = new (_base) RegionHeader();
+        header->version = kRegionVersion;
+        header->ringCapacity = ringCapacity;
+        header->laneCapacity = laneCapacity;
+        header->maxClients = geometry.maxClients;
+        for (std::uint32_t i = 0; i < geometry.maxClients; ++i)
+        {
+            new (static_cast<std::uint8_t*>(_base) + layout.slots + sizeof(ClientSlot) * i) ClientSlot();
+        }
+
+        BindLayout();
+        header->magic.store(kRegionMagic, std::memory_order_release);
+        return true;
+    }
+
+    bool ShmRegion::Open(const std::string& name, std::string& error)
+    {
+        Close();
+
+        if (!Map(name, 0, false, error))
+        {
+            return false;
+        }
+
+        const RegionHeader& header = Header();
+        if (_size < sizeof(RegionHeader)
+            || header.magic.load(std::memory_order_acquire) != kRegionMagic
+            || header.version != kRegionVersion)
+        {
+            error = "region '" + name + "' is not initialized or has an incompatible version";
+            Close();
+            return false;
+        }
+
+        if (ComputeLayout(header.ringCapacity, header.laneCapacity, header.maxClients).total > _size)
+        {
+            error = "region '" + name + "' is smaller than its header describes";
+            Close();
+            return false;
+        }
+
+        BindLayout();
+        return true;
+    }
+
+    void ShmRegion::BindLayout()
+    {
+        const RegionHeader& header = Header();
+        const Layout layout = ComputeLayout(header.ringCapacity, header.laneCapacity, header.maxClients);
+        auto* bytes = static_cast<std::uint8_t*>(_base);
+        _slots = reinterpret_cast<ClientSlot*>(bytes + layout.slots);
+        _down = reinterpret_cast<DoorCore::CanFrame*>(bytes + layout.down);
+        _up = reinterpret_cast<DoorCore::CanFrame*>(bytes + layout.up);
+    }
+
+#if defined(_WIN32)
+
+    bool ShmRegion::Map(const std::string& name, std::size_t size, bool create, std::string& error)
+    {
+        const std::wstring wideName = L"Local\\" + std::wstring(name.begin(), name.end());
+
+        HANDLE mapping = create
+            ? CreateFileMappingW(
+                INVALID_HANDLE_VALUE,
+                nullptr,
+                PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32),
+                static_cast<DWORD>(size),
+                wideName.c_str())
+            : OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wideName.c_str());
+        if (mapping == nullptr)
+        {
+            error = "file mapping '" + name + "' unavailable (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (view == nullptr)
+        {
+            error = "MapViewOfFile failed (error " + std::to_string(GetLastError()) + ")";
+            CloseHandle(mapping);
+            return false;
+        }
+
+        // Created by whichever side comes first and opened by the other. A count left over
+        // from an earlier run only causes one early return per waiter.
+        HANDLE down = CreateSemaphoreW(nullptr, 0, LONG_MAX, (wideName + L".down").c_str());
+        HANDLE up = CreateSemaphoreW(nullptr, 0, LONG_MAX, (wideName + L".up").c_str());
+        if (down == nullptr || up == nullptr)
+        {
+            error = "doorbell semaphores for '" + name + "' unavailable (error " + std::to_string(GetLastError()) + ")";
+            if (down != nullptr)
+            {
+                CloseHandle(down);
+            }
+            if (up != nullptr)
+            {
+                CloseHandle(up);
+            }
+            UnmapViewOfFile(view);
+            CloseHandle(mapping);
+            return false;
+        }
+
+        if (size == 0)
+        {
+            MEMORY_BASIC_INFORMATION info{};
+            VirtualQuery(view, &info, sizeof(info));
+            size = info.RegionSize;
+        }
+
+        _mapping = mapping;
+        _downSemaphore = down;
+        _upSemaphore = up;
+        _base = view;
+        _size = size;
+        _name = name;
+        _owner = create;
+        return true;
+    }
+
+    void ShmRegion::Close()
+    {
+        if (_base != nullptr)
+        {
+            UnmapViewOfFile(_base);
+        }
+        for (void* handle : { _mapping, _downSemaphore, _upSemaphore })
+        {
+            if (handle != nullptr)
+            {
+                CloseHandle(handle);
+            }
+        }
+
+        _mapping = nullptr;
+        _downSemaphore = nullptr;
+        _upSemaphore = nullptr;
+        _base = nullptr;
+        _size = 0;
+        _slots = nullptr;
+        _down = nullptr;
+        _up = nullptr;
+        _owner = false;
+    }
+
+    void* ShmRegion::BellSemaphore(const Doorbell& bell) const
+    {
+        return &bell == &Header().downBell ? _downSemaphore : _upSemaphore;
+    }
+
+    void ShmRegion::WaitDoorbell(Doorbell& bell, std::uint32_t observed, std::uint32_t timeoutMs) const
+    {
+        // Announce the sleeper before the final check, so a ring after the check sees it
+        // and releases the semaphore.
+        bell.waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (bell.sequence.load(std::memory_order_seq_cst) == observed)
+        {
+            WaitForSingleObject(BellSemaphore(bell), timeoutMs);
+        }
+        bell.waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void ShmRegion::RingDoorbell(Doorbell& bell) const
+    {
+        bell.sequence.fetch_add(1, std::memory_order_seq_cst);
+        const std::uint32_t waiters = bell.waiters.load(std::memory_order_seq_cst);
+        if (waiters != 0)
+        {
+            ReleaseSemaphore(BellSemaphore(bell), static_cast<LONG>(waiters), nullptr);
+        }
+    }
+
+#else
+
+    bool ShmRegion::Map(const std::string& name, std::size_t size, bool create, std::string& error)
+    {
+        const std::string posixName = PosixName(name);
+
+        int fd = -1;
+        if (create)
+        {
+            // Replace a region left behind by a crashed server; clients still mapping it see
+            // its heartbeat go stale and re-open.
+            shm_unlink(posixName.c_str());
+            fd = shm_open(posixName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                error = "ftruncate failed: " + std::string(std::strerror(errno));
+                close(fd);
+                shm_unlink(posixName.c_str());
+                return false;
+            }
+        }
+        else
+        {
+            fd = shm_open(posixName.c_str(), O_RDWR, 0);
+        }
+
+        if (fd < 0)
+        {
+            error = "shm_open('" + posixName + "') failed: " + std::strerror(errno);
+            return false;
+        }
+
+        if (!create)
+        {
+            struct stat info{};
+            if (fstat(fd, &info) != 0 || info.st_size <= 0)
+            {
+                error = "region '" + name + "' has no size yet";
+                close(fd);
+                return false;
+            }
+            size = static_cast<std::size_t>(info.st_size);
+        }
+
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+        {
+            error = "mmap failed: " + std::string(std::strerror(errno));
+            if (create)
+            {
+                shm_unlink(posixName.c_str());
+            }
+            return false;
+        }
+
+        _base = base;
+        _size = size;
+        _name = posixName;
+        _owner = create;
+        return true;
+    }
+
+    void ShmRegion::Close()
+    {
+        if (_base != nullptr)
+        {
+            munmap(_base, _size);
+            if (_owner)
+            {
+                shm_unlink(_name.c_str());
+            }
+        }
+
+        _base = nullptr;
+        _size = 0;
+        _slots = nullptr;
+        _down = nullptr;
+        _up = nullptr;
+        _owner = false;
+    }
+
+    void ShmRegion::WaitDoorbell(Doorbell& bell, std::uint32_t observed, std::uint32_t timeoutMs) const
+    {
+        bell.waiters.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+        timespec timeout{};
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1'000'000;
+        // Shared (non-private) futex: the word lives in memory mapped by several processes.
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&bell.sequence), FUTEX_WAIT, observed, &timeout, nullptr, 0);
+#else
+        for (std::uint32_t waited = 0; waited < timeoutMs && bell.sequence.load(std::memory_order_acquire) == observed; ++waited)
+        {
+            usleep(1000);
+        }
+#endif
+        bell.waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void ShmRegion::RingDoorbell(Doorbell& bell) const
+    {
+        bell.sequence.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+        if (bell.waiters.load(std::memory_order_seq_cst) != 0)
+        {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&bell.sequence), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+#endif
+    }
+
+#endif
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "CanFrame.h"
+
+namespace TransportShm
+{
+    constexpr std::uint32_t kRegionMagic = 0x53484D42u; // "SHMB"
+    constexpr std::uint32_t kRegionVersion = 3;
+    constexpr std::size_t kCacheLine = 64;
+
+    enum class ClientSlotState : std::uint32_t
+    {
+        Free = 0,
+        /// A client is resetting the slot's cursors; the server ignores it until Attached.
+        Claiming = 1,
+        Attached = 2,
+        /// Taken from a client that stopped heartbeating. Freed only after another timeout,
+        /// so a client that was merely stalled sees it lost the slot before anyone reuses it.
+        Reclaimed = 3
+    };
+
+    /// <summary>
+    /// Futex-style doorbell: a sequence word plus a waiter count so writers only make a
+    /// wake syscall when somebody is actually sleeping.
+    /// </summary>
+    /// <remarks>
+    /// Linux sleeps on the sequence word itself (shared futex). Windows has no cross-process
+    /// wait on an address, so each bell of a region has a named semaphore next to the mapping
+    /// that a ring releases once per sleeper.
+    /// </remarks>
+    struct Doorbell
+    {
+        std::atomic<std::uint32_t> sequence;
+        std::atomic<std::uint32_t> waiters;
+    };
+
+    /// <summary>
+    /// Fixed header at offset 0 of the shared region.
+    /// </summary>
+    /// <remarks>
+    /// The server owns the broadcast ring (downWrite) and every client owns one upstream
+    /// SPSC lane in its ClientSlot. All fields are lock-free atomics or values fixed at
+    /// creation, so the layout is valid in every process that maps it.
+    /// </remarks>
+    struct RegionHeader
+    {
+        std::atomic<std::uint32_t> magic;
+        std::uint32_t version;
+        std::uint32_t ringCapacity;
+        std::uint32_t laneCapacity;
+        std::uint32_t maxClients;
+
+        /// Server liveness as steady-clock nanoseconds; 0 when the server has stopped.
+        std::atomic<std::int64_t> serverHeartbeat;
+
+        alignas(kCacheLine) std::atomic<std::uint64_t> downWrite;
+        /// End of the frames the server is writing (>= downWrite). Set before the slots are
+        /// touched, so readers validate their copies against it, seqlock style.
+        std::atomic<std::uint64_t> downReserve;
+        alignas(kCacheLine) Doorbell downBell;
+        alignas(kCacheLine) Doorbell upBell;
+    };
+
+    /// <summary>
+    /// Per-client cursors and counters.
+    /// </summary>
+    struct ClientSlot
+    {
+        alignas(kCacheLine) std::atomic<std::uint32_t> state;
+        /// Bumped by every client that claims the slot. A client touches the slot and its
+        /// lane only while the token still matches the one it drew.
+        std::atomic<std::uint32_t> owner;
+        /// Client liveness as steady-clock nanoseconds.
+        std::atomic<std::int64_t> heartbeat;
+        /// Broadcast frames overwritten before this client read them.
+        std::atomic<std::uint64_t> downLost;
+        /// Upstream frames rejected because the lane was full.
+        std::atomic<std::uint64_t> upDropped;
+
+        /// Reader cursor into the broadcast ring.
+        alignas(kCacheLine) std::atomic<std::uint64_t> downRead;
+
+        alignas(kCacheLine) std::atomic<std::uint64_t> upWrite;
+        /// Advanced by the server with compare-exchange only, so the reset of a client that
+        /// attaches mid-drain is never overwritten with the previous owner's cursor.
+        alignas(kCacheLine) std::atomic<std::uint64_t> upRead;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared-memory cursors must be address-free");
+    static_assert(std::atomic<std::int64_t>::is_always_lock_free, "shared-memory cursors must be address-free");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared-memory cursors must be address-free");
+
+    struct RegionGeometry
+    {
+        std::uint32_t ringCapacity = 4096;
+        std::uint32_t laneCapacity = 1024;
+        std::uint32_t maxClients = 32;
+    };
+
+    /// <summary>
+    /// A named shared-memory mapping laid out as header | client slots | broadcast ring | lanes.
+    /// </summary>
+    class ShmRegion
+    {
+    public:
+        ShmRegion() = default;
+        ~ShmRegion();
+
+        ShmRegion(const ShmRegion&) = delete;
+        ShmRegion& operator=(const ShmRegion&) = delete;
+
+        /// Creates and initializes the region, replacing any stale region of the same name.
+        /// Capacities are rounded up to powers of two. Returns false and fills error on failure.
+        bool Create(const std::string& name, RegionGeometry geometry, std::string& error);
+
+        /// Maps an existing region created by a server. Returns false if it does not exist
+        /// yet or has an incompatible layout.
+        bool Open(const std::string& name, std::string& error);
+
+        void Close();
+
+        bool IsMapped() const { return _base != nullptr; }
+
+        RegionHeader& Header() const { return *static_cast<RegionHeader*>(_base); }
+        ClientSlot& Slot(std::uint32_t index) const { return _slots[index]; }
+        DoorCore::CanFrame* DownRing() const { return _down; }
+        DoorCore::CanFrame* UpLane(std::uint32_t index) const { return _up + static_cast<std::size_t>(index) * Header().laneCapacity; }
+
+        static std::size_t RequiredSize(RegionGeometry geometry);
+
+        /// Blocks until bell.sequence differs from observed or the timeout elapses. `bell` is
+        /// Header().downBell or Header().upBell.
+        void WaitDoorbell(Doorbell& bell, std::uint32_t observed, std::uint32_t timeoutMs) const;
+
+        /// Rings the bell and wakes all sleepers, skipping the syscall when nobody waits.
+        void RingDoorbell(Doorbell& bell) const;
+
+    private:
+        bool Map(const std::string& name, std::size_t size, bool create, std::string& error);
+        void BindLayout();
+
+        void* _base = nullptr;
+        std::size_t _size = 0;
+        ClientSlot* _slots = nullptr;
+        DoorCore::CanFrame* _down = nullptr;
+        DoorCore::CanFrame* _up = nullptr;
+        std::string _name;
+        bool _owner = false;
+#if defined(_WIN32)
+        void* BellSemaphore(const Doorbell& bell) const;
+
+        void* _mapping = nullptr;
+        void* _downSemaphore = nullptr;
+        void* _upSemaphore = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Public entry point for the Transport.Shm static library.
+#include "ShmCanBus.h"
+#include "ShmRegion.h"
@@ -0,0 +1,18 @@
+// Tui.Curses.Bench: benchmarks for the Tui.Curses static library.
+//
+// Usage: Tui.Curses.Bench <benchmark> [options]
+
+#include "BenchSupport.h"
+
+namespace
+{
+    const BenchCommon::Benchmark kBenchmarks[] = {
+        { "dashboard", "Headless dashboard refresh: bytes and time per refresh vs. full repaint and console lines", TuiCursesBench::RunDashboardBench },
+        { "live", "The same simulated bus on the curses terminal in real time (q quits)", TuiCursesBench::RunLiveBench },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return BenchCommon::RunBenchmarks("Tui.Curses.Bench", kBenchmarks, argc, argv);
+}
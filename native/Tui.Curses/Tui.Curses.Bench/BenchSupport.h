@@ -0,0 +1,12 @@
+#pragma once
+
+#include "BenchCommon.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TuiCursesBench
+{
+    int RunDashboardBench(int argc, char** argv);
+    int RunLiveBench(int argc, char** argv);
+}
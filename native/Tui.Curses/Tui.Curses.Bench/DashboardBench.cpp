@@ -0,0 +1,425 @@
+// Dashboard refresh cost on a simulated high-rate door bus, headless and live.
+//
+// Usage: Tui.Curses.Bench dashboard [doors] [frameRateHz] [seconds] [changePermille]
+//        Tui.Curses.Bench live [doors] [frameRateHz] [seconds]
+//
+// The bus is simulated on a reproducible clock: every door reports round-robin at
+// frameRateHz in total and changes state with the given probability per frame. Each
+// refresh gets the door states, per-ID rates since the last refresh and a wandering
+// latency. `dashboard` renders on a 240x60 ANSI terminal that only counts bytes:
+//
+// console     bytes/s of the current console mode: one formatted line per frame
+// full        repainting the whole screen every refresh: bytes and time per refresh
+// diff        damage-tracked refreshes: bytes, cells and time per refresh; must beat full
+//             and stay under 10% of one core
+// cap         refreshes against the configured rate, however fast the bus runs
+// verify      the ANSI byte stream decoded back into a screen matches the dashboard
+//
+// `live` runs the same bus in real time on the curses terminal (ncurses/PDCurses); q quits.
+
+#include "BenchSupport.h"
+
+#include "AnsiTerminal.h"
+#include "CursesTerminal.h"
+#include "Dashboard.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TuiCurses;
+using DoorCore::DoorState;
+using DoorCore::DoorStateFrame;
+using BenchCommon::Stopwatch;
+
+namespace
+{
+    constexpr std::uint32_t kRows = 60;
+    constexpr std::uint32_t kCols = 240;
+    constexpr std::uint32_t kRefreshHz = 30;
+    constexpr std::uint32_t kMaxBuses = 64;
+
+    class Rng
+    {
+    public:
+        explicit Rng(std::uint64_t seed)
+            : _state(seed)
+        {
+        }
+
+        std::uint32_t Next()
+        {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return static_cast<std::uint32_t>(_state >> 16);
+        }
+
+    private:
+        std::uint64_t _state;
+    };
+
+    struct Options
+    {
+        std::uint32_t doors = 10000;
+        std::uint32_t frameRateHz = 100000;
+        std::uint32_t seconds = 5;
+        std::uint32_t changePermille = 20;
+    };
+
+    /// Door bus producing DashboardState; time only moves when Advance is called.
+    class BusSimulator
+    {
+    public:
+        explicit BusSimulator(const Options& options)
+            : _options(options)
+            , _rng(7)
+            , _idFrames(DoorStateFrame::kMaxDoors, 0)
+        {
+            _state.title = "Rail HMI door bus (simulated)";
+            _state.doors.resize(options.doors);
+            _state.ids.resize(DoorStateFrame::kMaxDoors);
+            for (std::uint32_t door = 0; door < DoorStateFrame::kMaxDoors; ++door)
+            {
+                _state.ids[door].canId = DoorStateFrame::kBaseId + door;
+            }
+        }
+
+        std::int64_t NowTicks() const { return _nowTicks; }
+        const DashboardState& State() const { return _state; }
+
+        /// Delivers the frames due in the next `ticks` and moves the clock.
+        void Advance(std::int64_t ticks)
+        {
+            _nowTicks += ticks;
+            const std::uint64_t due = static_cast<std::uint64_t>(_nowTicks) * _options.frameRateHz / DoorCore::kTicksPerSecond;
+            for (; _frames < due; ++_frames)
+            {
+                const std::uint32_t slot = static_cast<std::uint32_t>(_frames % _options.doors);
+                DashboardDoor& door = _state.doors[slot];
+                if (!door.known || _rng.Next() % 1000 < _options.changePermille)
+                {
+                    door.state = static_cast<DoorState>((static_cast<std::uint32_t>(door.state) + 1 + _rng.Next() % 2) % 3);
+                    door.known = true;
+                }
+                ++_idFrames[slot % DoorStateFrame::kMaxDoors];
+            }
+            _state.totalFrames = _frames;
+        }
+
+        /// Per-ID and total rates since the previous call, plus a new latency sample.
+        void UpdateRates()
+        {
+            const double seconds = static_cast<double>(_nowTicks - _ratesTicks) / DoorCore::kTicksPerSecond;
+            if (seconds <= 0)
+            {
+                return;
+            }
+            for (std::size_t id = 0; id < _idFrames.size(); ++id)
+            {
+                _state.ids[id].framesPerSecond = static_cast<double>(_idFrames[id]) / seconds;
+                _idFrames[id] = 0;
+            }
+            _state.framesPerSecond = static_cast<double>(_frames - _ratesFrames) / seconds;
+            _ratesFrames = _frames;
+            _ratesTicks = _nowTicks;
+
+            // A slow random walk around 2 ms with the occasional spike.
+            _latencyNs = std::clamp<std::int64_t>(_latencyNs + static_cast<std::int64_t>(_rng.Next() % 200001) - 100000, 200000, 20000000);
+            _state.latencyP50Ns = _latencyNs / 2;
+            _state.latencyP99Ns = _rng.Next() % 100 == 0 ? _latencyNs * 4 : _latencyNs;
+        }
+
+    private:
+        Options _options;
+        Rng _rng;
+        DashboardState _state;
+        std::vector<std::uint64_t> _idFrames;
+        std::int64_t _nowTicks = 0;
+        std::uint64_t _frames = 0;
+        std::int64_t _ratesTicks = 0;
+        std::uint64_t _ratesFrames = 0;
+        std::int64_t _latencyNs = 2000000;
+    };
+
+    struct RunResult
+    {
+        std::uint64_t refreshes = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t cells = 0;
+        double refreshSeconds = 0;
+        bool matches = true;
+    };
+
+    /// Minimal VT decoder for the sequences AnsiTerminal emits: CUP, SGR, ED and text.
+    class AnsiDecoder
+    {
+    public:
+        AnsiDecoder(std::uint32_t rows, std::uint32_t cols)
+            : _rows(rows)
+            , _cols(cols)
+            , _cells(static_cast<std::size_t>(rows) * cols)
+        {
+        }
+
+        /// Takes whole flushes; AnsiTerminal never splits a sequence across two.
+        void Feed(std::string_view bytes)
+        {
+            std::size_t at = 0;
+            while (at < bytes.size())
+            {
+                if (bytes[at] != '\x1b')
+                {
+                    if (_row < _rows && _col < _cols)
+                    {
+                        _cells[static_cast<std::size_t>(_row) * _cols + _col] = Cell{ bytes[at], _style };
+                    }
+                    ++_col;
+                    ++at;
+                    continue;
+                }
+
+                const std::size_t end = bytes.find_first_of("HmJhl", at + 2);
+                if (end == std::string_view::npos)
+                {
+                    return;
+                }
+                const std::string_view sequence = bytes.substr(at, end - at + 1);
+                switch (bytes[end])
+                {
+                case 'H':
+                {
+                    const char* last = sequence.data() + sequence.size();
+                    const auto row = std::from_chars(sequence.data() + 2, last, _row);
+                    std::from_chars(row.ptr + 1, last, _col);
+                    --_row;
+                    --_col;
+                    break;
+                }
+                case 'm':
+                    _style = StyleOf(sequence);
+                    break;
+                case 'J':
+                    std::fill(_cells.begin(), _cells.end(), Cell{});
+                    break;
+                default:
+                    break;
+                }
+                at = end + 1;
+            }
+        }
+
+        bool Matches(const ScreenBuffer& screen) const
+        {
+            for (std::uint32_t row = 0; row < _rows; ++row)
+            {
+                for (std::uint32_t col = 0; col < _cols; ++col)
+                {
+                    if (_cells[static_cast<std::size_t>(row) * _cols + col] != screen.Front(row, col))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+        static CellStyle StyleOf(std::string_view sequence)
+        {
+            // Same table as AnsiTerminal, matched by the parameters only.
+            static constexpr std::string_view kParameters[kCellStyleCount] = { "0", "0;2", "0;1;36", "0;32", "0;1;33", "0;1;31", "0;90", "0;1;35" };
+            const std::string_view parameters = sequence.substr(2, sequence.size() - 3);
+            for (std::size_t i = 0; i < kCellStyleCount; ++i)
+            {
+                if (parameters == kParameters[i])
+                {
+                    return static_cast<CellStyle>(i);
+                }
+            }
+            return CellStyle::Normal;
+        }
+
+        std::uint32_t _rows;
+        std::uint32_t _cols;
+        std::vector<Cell> _cells;
+        std::uint32_t _row = 0;
+        std::uint32_t _col = 0;
+        CellStyle _style = CellStyle::Normal;
+    };
+
+    /// Runs the bus for `seconds` of simulated time with one Poll per 10 us of bus time.
+    RunResult RunHeadless(const Options& options, std::uint32_t seconds, bool repaintAll, bool verify)
+    {
+        BusSimulator bus(options);
+        Dashboard dashboard(DashboardConfig{ kRefreshHz });
+        ScreenBuffer screen(kRows, kCols);
+        AnsiDecoder decoder(kRows, kCols);
+        AnsiTerminal terminal(verify ? AnsiTerminal::Sink([&](std::string_view bytes) { decoder.Feed(bytes); }) : AnsiTerminal::Sink{});
+
+        constexpr std::int64_t kStepTicks = 100;
+        RunResult result;
+        const std::int64_t end = static_cast<std::int64_t>(seconds) * DoorCore::kTicksPerSecond;
+        // Polls over [0, seconds): one refresh at the start of every 1/kRefreshHz.
+        for (bus.Advance(kStepTicks); bus.NowTicks() < end; bus.Advance(kStepTicks))
+        {
+            Stopwatch watch;
+            if (!dashboard.Poll(bus.State(), bus.NowTicks(), screen, terminal))
+            {
+                continue;
+            }
+            result.refreshSeconds += watch.ElapsedSeconds();
+            result.cells += dashboard.LastPresent().cellsWritten;
+            if (verify)
+            {
+                result.matches = decoder.Matches(screen) && result.matches;
+            }
+
+            // Rates for the next refresh cover the interval since this one.
+            bus.UpdateRates();
+            if (repaintAll)
+            {
+                screen.Invalidate();
+            }
+        }
+
+        result.refreshes = dashboard.Refreshes();
+        result.bytes = terminal.BytesWritten();
+        return result;
+    }
+
+    /// What ConsoleRenderer.Log does today: one formatted line per received frame.
+    double ConsoleBytesPerSecond(const Options& options)
+    {
+        constexpr std::uint32_t kSampleFrames = 200000;
+        Rng rng(3);
+        std::string line;
+        std::uint64_t bytes = 0;
+        for (std::uint32_t frame = 0; frame < kSampleFrames; ++frame)
+        {
+            char text[128];
+            const std::uint32_t slot = frame % options.doors;
+            const int length = std::snprintf(text, sizeof(text), "[12:00:%06.3f] Door %u bus %u: %s\r\n",
+                static_cast<double>(frame % 60000) / 1000.0, slot % DoorStateFrame::kMaxDoors, slot / DoorStateFrame::kMaxDoors,
+                rng.Next() % 3 == 0 ? "Open" : "Closed");
+            bytes += static_cast<std::uint64_t>(length);
+        }
+        return static_cast<double>(bytes) / kSampleFrames * options.frameRateHz;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        if (argc > 0) options.doors = static_cast<std::uint32_t>(std::strtoul(argv[0], nullptr, 10));
+        if (argc > 1) options.frameRateHz = static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10));
+        if (argc > 2) options.seconds = static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10));
+        if (argc > 3) options.changePermille = static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10));
+        if (options.doors == 0 || options.doors > kMaxBuses * DoorStateFrame::kMaxDoors || options.frameRateHz == 0
+            || options.seconds == 0 || options.changePermille > 1000)
+        {
+            std::fprintf(stderr, "doors must be 1..%u, frameRateHz and seconds > 0, changePermille <= 1000\n", kMaxBuses * DoorStateFrame::kMaxDoors);
+            return false;
+        }
+        return true;
+    }
+}
+
+namespace TuiCursesBench
+{
+    int RunDashboardBench(int argc, char** argv)
+    {
+        Options options;
+        if (!ParseOptions(argc, argv, options))
+        {
+            return 1;
+        }
+
+        const std::size_t capacity = Dashboard::GridCapacity(kRows, kCols);
+        std::printf("dashboard: %u doors (%zu fit on %ux%u), %u frames/s, %u%% state changes, %u Hz cap, %u s simulated\n\n",
+            options.doors, capacity, kCols, kRows, options.frameRateHz, options.changePermille / 10, kRefreshHz, options.seconds);
+
+        const double consoleBytes = ConsoleBytesPerSecond(options);
+        std::printf("console   %12.0f bytes/s (one line per frame, scrolls)\n", consoleBytes);
+
+        const RunResult full = RunHeadless(options, options.seconds, true, false);
+        const double fullBytes = static_cast<double>(full.bytes) / static_cast<double>(full.refreshes);
+        const double fullUs = full.refreshSeconds * 1e6 / static_cast<double>(full.refreshes);
+        std::printf("full      %12.0f bytes/refresh  %12.0f bytes/s  %8.1f us/refresh\n", fullBytes, fullBytes * kRefreshHz, fullUs);
+
+        const RunResult diff = RunHeadless(options, options.seconds, false, false);
+        const double diffBytes = static_cast<double>(diff.bytes) / static_cast<double>(diff.refreshes);
+        const double diffUs = diff.refreshSeconds * 1e6 / static_cast<double>(diff.refreshes);
+        const double budgetShare = diffUs * kRefreshHz / 1e4;
+        const bool diffPass = diffBytes < fullBytes && budgetShare < 10.0;
+        std::printf("diff      %12.0f bytes/refresh  %12.0f bytes/s  %8.1f us/refresh  %.0f cells/refresh  %.2f%% of a core  %s\n",
+            diffBytes, diffBytes * kRefreshHz, diffUs, static_cast<double>(diff.cells) / static_cast<double>(diff.refreshes),
+            budgetShare, diffPass ? "PASS" : "FAIL");
+
+        const std::uint64_t expected = static_cast<std::uint64_t>(options.seconds) * kRefreshHz;
+        const bool capPass = diff.refreshes == expected;
+        std::printf("cap       %llu refreshes in %u s at %u frames/s (expected %llu)  %s\n",
+            static_cast<unsigned long long>(diff.refreshes), options.seconds, options.frameRateHz,
+            static_cast<unsigned long long>(expected), capPass ? "PASS" : "FAIL");
+
+        const RunResult verify = RunHeadless(options, 1, false, true);
+        std::printf("verify    %llu refreshes decoded from the ANSI stream: screen %s  %s\n",
+            static_cast<unsigned long long>(verify.refreshes), verify.matches ? "matches" : "DIFFERS", verify.matches ? "PASS" : "FAIL");
+
+        return diffPass && capPass && verify.matches ? 0 : 1;
+    }
+
+    int RunLiveBench(int argc, char** argv)
+    {
+        Options options;
+        options.seconds = 30;
+        if (!ParseOptions(argc, argv, options))
+        {
+            return 1;
+        }
+
+        RunResult result;
+        {
+            BusSimulator bus(options);
+            Dashboard dashboard(DashboardConfig{ kRefreshHz });
+            CursesTerminal terminal;
+            ScreenBuffer screen(terminal.Rows(), terminal.Cols());
+
+            const auto start = std::chrono::steady_clock::now();
+            const std::int64_t end = static_cast<std::int64_t>(options.seconds) * DoorCore::kTicksPerSecond;
+            while (bus.NowTicks() < end)
+            {
+                const int key = terminal.ReadKey();
+                if (key == 'q' || key == 'Q')
+                {
+                    break;
+                }
+                if (key == CursesTerminal::kKeyResize)
+                {
+                    screen.Resize(terminal.Rows(), terminal.Cols());
+                }
+
+                // Real time drives the simulated bus; sleep in short steps like a receive loop.
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                bus.Advance(elapsed / 100 - bus.NowTicks());
+                Stopwatch watch;
+                if (dashboard.Poll(bus.State(), bus.NowTicks(), screen, terminal))
+                {
+                    result.refreshSeconds += watch.ElapsedSeconds();
+                    result.cells += dashboard.LastPresent().cellsWritten;
+                    bus.UpdateRates();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            result.refreshes = dashboard.Refreshes();
+        }
+
+        std::printf("live      %llu refreshes, %.1f us/refresh, %.0f cells/refresh\n", static_cast<unsigned long long>(result.refreshes),
+            result.refreshes != 0 ? result.refreshSeconds * 1e6 / static_cast<double>(result.refreshes) : 0.0,
+            result.refreshes != 0 ? static_cast<double>(result.cells) / static_cast<double>(result.refreshes) : 0.0);
+        return 0;
+    }
+}
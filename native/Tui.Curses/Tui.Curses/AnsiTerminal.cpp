@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include "AnsiTerminal.h"
+
+#include <charconv>
+#include <cstdio>
+#include <utility>
+
+namespace TuiCurses
+{
+    namespace
+    {
+        /// SGR sequence per CellStyle; each starts with a reset so styles never accumulate.
+        constexpr std::string_view kStyleSequences[kCellStyleCount] = {
+            "\x1b[0m",      // Normal
+            "\x1b[0;2m",    // Dim
+            "\x1b[0;1;36m", // Header
+            "\x1b[0;32m",   // Closed
+            "\x1b[0;1;33m", // Open
+            "\x1b[0;1;31m", // Obstructed
+            "\x1b[0;90m",   // Stale
+            "\x1b[0;1;35m", // Warning
+        };
+
+        void AppendNumber(std::string& out, std::uint32_t value)
+        {
+            char text[12];
+            const auto result = std::to_chars(text, text + sizeof(text), value);
+            out.append(text, result.ptr);
+        }
+    }
+
+    AnsiTerminal::AnsiTerminal(Sink sink)
+        : _sink(std::move(sink))
+    {
+        _buffer.reserve(64 * 1024);
+    }
+
+    AnsiTerminal::Sink AnsiTerminal::StdoutSink()
+    {
+        return [](std::string_view bytes) {
+            std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+            std::fflush(stdout);
+        };
+    }
+
+    void AnsiTerminal::Clear()
+    {
+        _buffer.append("\x1b[0m\x1b[2J");
+        _style = CellStyle::Normal;
+        _styleKnown = true;
+        _row = UINT32_MAX;
+        _col = UINT32_MAX;
+    }
+
+    void AnsiTerminal::Write(std::uint32_t row, std::uint32_t col, std::span<const Cell> cells)
+    {
+        MoveTo(row, col);
+        for (const Cell& cell : cells)
+        {
+            SetStyle(cell.style);
+            _buffer.push_back(cell.glyph);
+        }
+        _col += static_cast<std::uint32_t>(cells.size());
+    }
+
+    void AnsiTerminal::Flush()
+    {
+        if (_buffer.empty())
+        {
+            return;
+        }
+
+        _bytesWritten += _buffer.size();
+        ++_flushes;
+        if (_sink)
+        {
+            _sink(_buffer);
+        }
+        _buffer.clear();
+    }
+
+    void AnsiTerminal::Enter()
+    {
+        _buffer.append("\x1b[?1049h\x1b[?25l");
+        Clear();
+        Flush();
+    }
+
+    void AnsiTerminal::Leave()
+    {
+        _buffer.append("\x1b[0m\x1b[?25h\x1b[?1049l");
+        _styleKnown = false;
+        Flush();
+    }
+
+    void AnsiTerminal::MoveTo(std::uint32_t row, std::uint32_t col)
+    {
+        if (row == _row && col == _col)
+        {
+            return;
+        }
+
+        // CUP is 1-based.
+        _buffer.append("\x1b[");
+        AppendNumber(_buffer, row + 1);
+        _buffer.push_back(';');
+        AppendNumber(_buffer, col + 1);
+        _buffer.push_back('H');
+        _row = row;
+        _col = col;
+    }
+
+    void AnsiTerminal::SetStyle(CellStyle style)
+    {
+        if (_styleKnown && style == _style)
+        {
+            return;
+        }
+
+        _buffer.append(kStyleSequences[static_cast<std::size_t>(style)]);
+        _style = style;
+        _styleKnown = true;
+    }
+}
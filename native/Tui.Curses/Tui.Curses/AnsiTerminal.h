@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "ScreenBuffer.h"
+
+namespace TuiCurses
+{
+    /// <summary>
+    /// ITerminal that encodes output as VT100/ANSI escape sequences into one buffer per frame.
+    /// </summary>
+    /// <remarks>
+    /// Tracks the cursor position and current style, so consecutive runs on a row and runs
+    /// in the same style skip the cursor-move and SGR sequences. Flush hands the frame's bytes
+    /// to the sink in one call (one write(2) per refresh). A default-constructed terminal has
+    /// no sink and only counts bytes, which is what the headless benchmark uses.
+    /// </remarks>
+    class AnsiTerminal final : public ITerminal
+    {
+    public:
+        using Sink = std::function<void(std::string_view bytes)>;
+
+        explicit AnsiTerminal(Sink sink = {});
+
+        /// Sink that writes to standard output (a terminal or a pipe).
+        static Sink StdoutSink();
+
+        void Clear() override;
+        void Write(std::uint32_t row, std::uint32_t col, std::span<const Cell> cells) override;
+        void Flush() override;
+
+        /// Hides the cursor and switches to the alternate screen; Leave restores both.
+        void Enter();
+        void Leave();
+
+        std::uint64_t BytesWritten() const { return _bytesWritten; }
+        std::uint64_t Flushes() const { return _flushes; }
+
+    private:
+        void MoveTo(std::uint32_t row, std::uint32_t col);
+        void SetStyle(CellStyle style);
+
+        Sink _sink;
+        std::string _buffer;
+        std::uint32_t _row = UINT32_MAX;
+        std::uint32_t _col = UINT32_MAX;
+        CellStyle _style = CellStyle::Normal;
+        bool _styleKnown = false;
+        std::uint64_t _bytesWritten = 0;
+        std::uint64_t _flushes = 0;
+    };
+}
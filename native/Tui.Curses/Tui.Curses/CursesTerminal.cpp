@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "CursesTerminal.h"
+
+// Last: its macros (move, clear, refresh, ...) would break the headers above.
+#include <curses.h>
+
+namespace TuiCurses
+{
+    namespace
+    {
+        struct StyleAttributes
+        {
+            short foreground;
+            chtype attributes;
+        };
+
+        /// Colour and attributes per CellStyle; -1 is the terminal's default colour.
+        const StyleAttributes kStyles[kCellStyleCount] = {
+            { -1, A_NORMAL },           // Normal
+            { -1, A_DIM },              // Dim
+            { COLOR_CYAN, A_BOLD },     // Header
+            { COLOR_GREEN, A_NORMAL },  // Closed
+            { COLOR_YELLOW, A_BOLD },   // Open
+            { COLOR_RED, A_BOLD },      // Obstructed
+            { COLOR_BLUE, A_DIM },      // Stale
+            { COLOR_MAGENTA, A_BOLD },  // Warning
+        };
+
+        chtype Attributes(CellStyle style, bool hasColors)
+        {
+            const std::size_t index = static_cast<std::size_t>(style);
+            const chtype color = hasColors && kStyles[index].foreground >= 0 ? COLOR_PAIR(static_cast<int>(index) + 1) : 0;
+            return kStyles[index].attributes | color;
+        }
+    }
+
+    const int CursesTerminal::kKeyResize = KEY_RESIZE;
+
+    CursesTerminal::CursesTerminal()
+    {
+        initscr();
+        cbreak();
+        noecho();
+        nodelay(stdscr, TRUE);
+        keypad(stdscr, TRUE);
+        curs_set(0);
+        leaveok(stdscr, TRUE);
+
+        _hasColors = has_colors();
+        if (_hasColors)
+        {
+            start_color();
+            use_default_colors();
+            for (std::size_t i = 0; i < kCellStyleCount; ++i)
+            {
+                if (kStyles[i].foreground >= 0)
+                {
+                    init_pair(static_cast<short>(i + 1), kStyles[i].foreground, -1);
+                }
+            }
+        }
+    }
+
+    CursesTerminal::~CursesTerminal()
+    {
+        curs_set(1);
+        endwin();
+    }
+
+    void CursesTerminal::Clear()
+    {
+        wclear(stdscr);
+    }
+
+    void CursesTerminal::Write(std::uint32_t row, std::uint32_t col, std::span<const Cell> cells)
+    {
+        wmove(stdscr, static_cast<int>(row), static_cast<int>(col));
+        CellStyle style = cells.empty() ? CellStyle::Normal : cells.front().style;
+        wattrset(stdscr, Attributes(style, _hasColors));
+        for (const Cell& cell : cells)
+        {
+            if (cell.style != style)
+            {
+                style = cell.style;
+                wattrset(stdscr, Attributes(style, _hasColors));
+            }
+            // Fails harmlessly in the bottom-right cell, where curses cannot advance the cursor.
+            waddch(stdscr, static_cast<unsigned char>(cell.glyph));
+        }
+    }
+
+    void CursesTerminal::Flush()
+    {
+        wrefresh(stdscr);
+    }
+
+    std::uint32_t CursesTerminal::Rows() const
+    {
+        return static_cast<std::uint32_t>(getmaxy(stdscr));
+    }
+
+    std::uint32_t CursesTerminal::Cols() const
+    {
+        return static_cast<std::uint32_t>(getmaxx(stdscr));
+    }
+
+    int CursesTerminal::ReadKey()
+    {
+        const int key = wgetch(stdscr);
+        return key == ERR ? -1 : key;
+    }
+}
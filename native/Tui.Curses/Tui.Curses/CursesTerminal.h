@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ScreenBuffer.h"
+
+namespace TuiCurses
+{
+    /// <summary>
+    /// ITerminal on curses: ncurses on Linux, PDCurses (external/pdcurses) on Windows.
+    /// </summary>
+    /// <remarks>
+    /// Owns the curses session of the process (initscr/endwin); create at most one. Runs are
+    /// drawn into stdscr and Flush calls refresh(), so curses' own optimizer only sees the
+    /// cells ScreenBuffer already found changed. Input is non-blocking.
+    ///
+    /// curses.h defines macros such as move, clear and refresh, so it is only included by
+    /// CursesTerminal.cpp. Link with -lncurses on Linux and PDCursesLib on Windows.
+    /// </remarks>
+    class CursesTerminal final : public ITerminal
+    {
+    public:
+        CursesTerminal();
+        ~CursesTerminal() override;
+
+        CursesTerminal(const CursesTerminal&) = delete;
+        CursesTerminal& operator=(const CursesTerminal&) = delete;
+
+        void Clear() override;
+        void Write(std::uint32_t row, std::uint32_t col, std::span<const Cell> cells) override;
+        void Flush() override;
+
+        std::uint32_t Rows() const;
+        std::uint32_t Cols() const;
+
+        /// Next pending key, or -1 if none. A terminal resize arrives as kKeyResize.
+        int ReadKey();
+
+        static const int kKeyResize;
+
+    private:
+        bool _hasColors = false;
+    };
+}
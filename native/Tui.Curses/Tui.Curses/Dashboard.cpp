@@ -0,0 +1,233 @@
+#include "pch.h"
+
+#include "Dashboard.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace TuiCurses
+{
+    namespace
+    {
+        constexpr std::uint32_t kHeaderRows = 2;
+        constexpr std::uint32_t kFooterRows = 2;
+        /// Narrowest door grid worth keeping the ID table for.
+        constexpr std::uint32_t kMinGridCols = 20;
+
+        /// Sparkline glyphs from lowest to highest; ASCII for PDCurses.
+        constexpr char kSparkLevels[] = " ._-=+*#%@";
+        constexpr std::size_t kSparkLevelCount = sizeof(kSparkLevels) - 1;
+
+        std::uint32_t GridCols(std::uint32_t cols)
+        {
+            return cols >= kMinGridCols + Dashboard::kIdTableWidth ? cols - Dashboard::kIdTableWidth : cols;
+        }
+
+        Cell DoorCell(const DashboardDoor& door)
+        {
+            if (!door.known)
+            {
+                return Cell{ '.', CellStyle::Dim };
+            }
+
+            char glyph = '-';
+            CellStyle style = CellStyle::Closed;
+            switch (door.state)
+            {
+            case DoorCore::DoorState::Closed:
+                break;
+            case DoorCore::DoorState::Open:
+                glyph = 'O';
+                style = CellStyle::Open;
+                break;
+            case DoorCore::DoorState::Obstructed:
+                glyph = 'X';
+                style = CellStyle::Obstructed;
+                break;
+            }
+            return Cell{ glyph, door.stale ? CellStyle::Stale : style };
+        }
+
+        /// "850 ns", "12.3 us", "4.56 ms", "1.23 s": at most 8 characters.
+        void FormatDuration(char* text, std::size_t size, std::int64_t nanoseconds)
+        {
+            const double value = static_cast<double>(nanoseconds);
+            if (nanoseconds < 1000)
+            {
+                std::snprintf(text, size, "%lld ns", static_cast<long long>(nanoseconds));
+            }
+            else if (nanoseconds < 1000000)
+            {
+                std::snprintf(text, size, "%.1f us", value / 1e3);
+            }
+            else if (nanoseconds < 1000000000)
+            {
+                std::snprintf(text, size, "%.2f ms", value / 1e6);
+            }
+            else
+            {
+                std::snprintf(text, size, "%.2f s", value / 1e9);
+            }
+        }
+    }
+
+    Dashboard::Dashboard(DashboardConfig config)
+        : _config(config)
+    {
+        if (_config.refreshHz == 0)
+        {
+            _config.refreshHz = 1;
+        }
+        _refreshIntervalTicks = DoorCore::kTicksPerSecond / _config.refreshHz;
+    }
+
+    std::size_t Dashboard::GridCapacity(std::uint32_t rows, std::uint32_t cols)
+    {
+        const std::uint32_t gridRows = rows > kHeaderRows + kFooterRows ? rows - kHeaderRows - kFooterRows : 0;
+        return static_cast<std::size_t>(gridRows) * GridCols(cols);
+    }
+
+    bool Dashboard::Poll(const DashboardState& state, std::int64_t nowTicks, ScreenBuffer& screen, ITerminal& terminal)
+    {
+        if (nowTicks < _nextRefresh)
+        {
+            return false;
+        }
+
+        // Same cadence rule as DoorTable::PollDeltas: no drift, and when behind the next
+        // refresh is a full interval away rather than due immediately.
+        const std::int64_t due = _nextRefresh + _refreshIntervalTicks;
+        _nextRefresh = due > nowTicks ? due : nowTicks + _refreshIntervalTicks;
+        Draw(state, screen);
+        _lastPresent = screen.Present(terminal);
+        ++_refreshes;
+        return true;
+    }
+
+    void Dashboard::Draw(const DashboardState& state, ScreenBuffer& screen)
+    {
+        const std::uint32_t rows = screen.Rows();
+        const std::uint32_t cols = screen.Cols();
+        if (rows <= kHeaderRows + kFooterRows || cols < kMinGridCols)
+        {
+            screen.Erase();
+            screen.PutText(0, 0, "terminal too small", CellStyle::Warning);
+            return;
+        }
+
+        const std::uint32_t gridRows = rows - kHeaderRows - kFooterRows;
+        const std::uint32_t gridCols = GridCols(cols);
+        DrawHeader(state, screen);
+        DrawDoors(state, screen, kHeaderRows, gridRows, gridCols);
+        if (gridCols < cols)
+        {
+            DrawIds(state, screen, kHeaderRows, gridRows, gridCols);
+        }
+        DrawLatency(state, screen, rows - kFooterRows);
+    }
+
+    void Dashboard::DrawHeader(const DashboardState& state, ScreenBuffer& screen)
+    {
+        const std::uint32_t cols = screen.Cols();
+        const std::size_t capacity = GridCapacity(screen.Rows(), cols);
+
+        char text[256];
+        const std::uint32_t title = screen.PutText(0, 0, state.title, CellStyle::Header, std::min<std::uint32_t>(32, cols));
+        std::snprintf(text, sizeof(text), "  %10.0f frames/s  %8.0f drops/s  total %llu frames  %llu drops  %u Hz",
+            state.framesPerSecond, state.dropsPerSecond, static_cast<unsigned long long>(state.totalFrames),
+            static_cast<unsigned long long>(state.totalDrops), _config.refreshHz);
+        screen.PutText(0, title, text, state.dropsPerSecond > 0 ? CellStyle::Warning : CellStyle::Normal, cols - title);
+
+        if (state.doors.size() > capacity)
+        {
+            std::snprintf(text, sizeof(text), "- closed  O open  X obstructed  . unknown  (dim: stale)   showing %zu of %zu doors",
+                capacity, state.doors.size());
+        }
+        else
+        {
+            std::snprintf(text, sizeof(text), "- closed  O open  X obstructed  . unknown  (dim: stale)   %zu doors", state.doors.size());
+        }
+        screen.PutText(1, 0, text, CellStyle::Dim, cols);
+    }
+
+    void Dashboard::DrawDoors(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top, std::uint32_t rows, std::uint32_t cols)
+    {
+        std::size_t door = 0;
+        for (std::uint32_t row = 0; row < rows; ++row)
+        {
+            for (std::uint32_t col = 0; col < cols; ++col, ++door)
+            {
+                screen.Put(top + row, col, door < state.doors.size() ? DoorCell(state.doors[door]) : Cell{});
+            }
+        }
+    }
+
+    void Dashboard::DrawIds(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top, std::uint32_t rows, std::uint32_t left)
+    {
+        char text[64];
+        std::snprintf(text, sizeof(text), "  %-9s%10s %8s", "CAN ID", "frames/s", "drops/s");
+        screen.PutText(top, left, text, CellStyle::Header, kIdTableWidth);
+
+        // Only the rows that fit need ordering.
+        const std::size_t shown = std::min<std::size_t>(state.ids.size(), rows - 1);
+        _idOrder.resize(state.ids.size());
+        for (std::uint32_t i = 0; i < _idOrder.size(); ++i)
+        {
+            _idOrder[i] = i;
+        }
+        std::partial_sort(_idOrder.begin(), _idOrder.begin() + static_cast<std::ptrdiff_t>(shown), _idOrder.end(),
+            [&](std::uint32_t a, std::uint32_t b) {
+                const IdRate& x = state.ids[a];
+                const IdRate& y = state.ids[b];
+                return x.framesPerSecond != y.framesPerSecond ? x.framesPerSecond > y.framesPerSecond : x.canId < y.canId;
+            });
+
+        for (std::uint32_t row = 1; row < rows; ++row)
+        {
+            if (row - 1 < shown)
+            {
+                const IdRate& id = state.ids[_idOrder[row - 1]];
+                std::snprintf(text, sizeof(text), id.canId <= 0x7FF ? "  0x%03X    %10.0f %8.0f" : "  %08X %10.0f %8.0f",
+                    id.canId, id.framesPerSecond, id.dropsPerSecond);
+                screen.PutText(top + row, left, text, id.dropsPerSecond > 0 ? CellStyle::Warning : CellStyle::Normal, kIdTableWidth);
+            }
+            else
+            {
+                screen.Fill(top + row, left, kIdTableWidth, Cell{});
+            }
+        }
+    }
+
+    void Dashboard::DrawLatency(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top)
+    {
+        const std::uint32_t cols = screen.Cols();
+        if (_latencyHistory.size() != cols)
+        {
+            _latencyHistory.assign(cols, 0);
+            _latencyNext = 0;
+        }
+        // Negative percentiles (clock skew) would index below the lowest level.
+        _latencyHistory[_latencyNext] = std::max<std::int64_t>(state.latencyP99Ns, 0);
+        _latencyNext = (_latencyNext + 1) % _latencyHistory.size();
+
+        const std::int64_t peak = std::max<std::int64_t>(1, *std::max_element(_latencyHistory.begin(), _latencyHistory.end()));
+
+        char p50[24];
+        char p99[24];
+        char max[24];
+        FormatDuration(p50, sizeof(p50), state.latencyP50Ns);
+        FormatDuration(p99, sizeof(p99), state.latencyP99Ns);
+        FormatDuration(max, sizeof(max), peak);
+        char text[160];
+        std::snprintf(text, sizeof(text), "latency producer->screen  p50 %-8s  p99 %-8s  sparkline: p99 per refresh, top %s", p50, p99, max);
+        screen.PutText(top, 0, text, CellStyle::Header, cols);
+
+        // Oldest sample at the left edge, newest at the right.
+        for (std::uint32_t col = 0; col < cols; ++col)
+        {
+            const std::int64_t value = _latencyHistory[(_latencyNext + col) % cols];
+            const std::size_t level = static_cast<std::size_t>(value * static_cast<std::int64_t>(kSparkLevelCount - 1) / peak);
+            screen.Put(top + 1, col, Cell{ kSparkLevels[level], value == peak ? CellStyle::Warning : CellStyle::Normal });
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DoorStateFrame.h"
+#include "ScreenBuffer.h"
+
+namespace TuiCurses
+{
+    struct DashboardDoor
+    {
+        DoorCore::DoorState state = DoorCore::DoorState::Closed;
+        /// False until the door has reported; drawn as unknown.
+        bool known = false;
+        bool stale = false;
+    };
+
+    struct IdRate
+    {
+        std::uint32_t canId = 0;
+        double framesPerSecond = 0;
+        double dropsPerSecond = 0;
+    };
+
+    /// <summary>
+    /// Everything the dashboard shows, as of one refresh.
+    /// </summary>
+    /// <remarks>
+    /// Owned by the UI thread: fill doors from DoorTable deltas (slot = bus * 256 + door) and
+    /// the rates and latency from two Metrics snapshots, then hand it to Dashboard::Poll. The
+    /// dashboard never keeps references into it between calls.
+    /// </remarks>
+    struct DashboardState
+    {
+        std::string title = "Rail HMI door bus";
+        std::vector<DashboardDoor> doors;
+        /// Any order; the dashboard lists the busiest IDs that fit.
+        std::vector<IdRate> ids;
+        double framesPerSecond = 0;
+        double dropsPerSecond = 0;
+        std::uint64_t totalFrames = 0;
+        std::uint64_t totalDrops = 0;
+        /// Producer-to-screen latency percentiles for the last interval, in nanoseconds.
+        std::int64_t latencyP50Ns = 0;
+        std::int64_t latencyP99Ns = 0;
+    };
+
+    struct DashboardConfig
+    {
+        /// Maximum refresh rate of Poll, independent of how fast the state changes.
+        std::uint32_t refreshHz = 30;
+    };
+
+    /// <summary>
+    /// Full-screen door bus dashboard: door grid, per-ID rate table and latency sparkline.
+    /// </summary>
+    /// <remarks>
+    /// Layout: a header with totals, one cell per door on the left (wrapping row by row), the
+    /// busiest IDs on the right and a p99 latency sparkline of the last refreshes at the
+    /// bottom. Draw repaints the whole frame into the ScreenBuffer's back buffer every time;
+    /// the buffer's damage tracking turns that into output for the changed cells only, so a
+    /// refresh costs terminal bytes in proportion to what changed, not to the screen size.
+    /// Poll adds the frame-rate cap, so the bus can update the state at any rate.
+    /// </remarks>
+    class Dashboard
+    {
+    public:
+        /// Width of the ID table column, including its left margin.
+        static constexpr std::uint32_t kIdTableWidth = 30;
+
+        explicit Dashboard(DashboardConfig config = {});
+
+        /// Draws `state` into the back buffer of `screen` (at its current size).
+        void Draw(const DashboardState& state, ScreenBuffer& screen);
+
+        /// Rate-limited Draw + Present: returns false without drawing until 1/refreshHz has
+        /// passed since the last refresh (`nowTicks` in .NET ticks).
+        bool Poll(const DashboardState& state, std::int64_t nowTicks, ScreenBuffer& screen, ITerminal& terminal);
+
+        /// Doors that fit in the grid at the given screen size.
+        static std::size_t GridCapacity(std::uint32_t rows, std::uint32_t cols);
+
+        std::uint64_t Refreshes() const { return _refreshes; }
+        const PresentStats& LastPresent() const { return _lastPresent; }
+
+    private:
+        void DrawHeader(const DashboardState& state, ScreenBuffer& screen);
+        void DrawDoors(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top, std::uint32_t rows, std::uint32_t cols);
+        void DrawIds(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top, std::uint32_t rows, std::uint32_t left);
+        void DrawLatency(const DashboardState& state, ScreenBuffer& screen, std::uint32_t top);
+
+        DashboardConfig _config;
+        std::int64_t _refreshIntervalTicks;
+        std::int64_t _nextRefresh = 0;
+        std::uint64_t _refreshes = 0;
+        PresentStats _lastPresent;
+
+        /// p99 per Draw, oldest first once full; as long as the screen is wide.
+        std::vector<std::int64_t> _latencyHistory;
+        std::size_t _latencyNext = 0;
+        std::vector<std::uint32_t> _idOrder;
+    };
+}
@@ -0,0 +1,139 @@
+#include "pch.h"
+
+#include "ScreenBuffer.h"
+
+#include <algorithm>
+
+namespace TuiCurses
+{
+    ScreenBuffer::ScreenBuffer(std::uint32_t rows, std::uint32_t cols)
+    {
+        Resize(rows, cols);
+    }
+
+    void ScreenBuffer::Resize(std::uint32_t rows, std::uint32_t cols)
+    {
+        _rows = rows;
+        _cols = cols;
+        const std::size_t cells = static_cast<std::size_t>(rows) * cols;
+        _front.assign(cells, Cell{});
+        _back.assign(cells, Cell{});
+        _damage.assign(rows, Span{});
+        _clearPending = true;
+    }
+
+    void ScreenBuffer::Erase()
+    {
+        for (std::uint32_t row = 0; row < _rows; ++row)
+        {
+            Fill(row, 0, _cols, Cell{});
+        }
+    }
+
+    void ScreenBuffer::Invalidate()
+    {
+        // After the terminal clears, it shows blanks; damage whatever the back buffer differs in.
+        std::fill(_front.begin(), _front.end(), Cell{});
+        std::fill(_damage.begin(), _damage.end(), Span{});
+        for (std::uint32_t row = 0; row < _rows; ++row)
+        {
+            for (std::uint32_t col = 0; col < _cols; ++col)
+            {
+                if (Back(row, col) != Cell{})
+                {
+                    Damage(row, col);
+                }
+            }
+        }
+        _clearPending = true;
+    }
+
+    std::uint32_t ScreenBuffer::PutText(std::uint32_t row, std::uint32_t col, std::string_view text, CellStyle style, std::uint32_t width)
+    {
+        if (row >= _rows || col >= _cols)
+        {
+            return 0;
+        }
+
+        const std::uint32_t limit = std::min(width, _cols - col);
+        const std::uint32_t length = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), limit));
+        for (std::uint32_t i = 0; i < length; ++i)
+        {
+            Put(row, col + i, Cell{ text[i], style });
+        }
+        if (width != UINT32_MAX && length < limit)
+        {
+            Fill(row, col + length, limit - length, Cell{ ' ', style });
+            return limit;
+        }
+        return length;
+    }
+
+    void ScreenBuffer::Fill(std::uint32_t row, std::uint32_t col, std::uint32_t count, Cell cell)
+    {
+        if (row >= _rows || col >= _cols)
+        {
+            return;
+        }
+
+        const std::uint32_t end = col + std::min(count, _cols - col);
+        for (std::uint32_t c = col; c < end; ++c)
+        {
+            Put(row, c, cell);
+        }
+    }
+
+    PresentStats ScreenBuffer::Present(ITerminal& terminal)
+    {
+        PresentStats stats;
+        if (_clearPending)
+        {
+            terminal.Clear();
+            _clearPending = false;
+        }
+
+        for (std::uint32_t row = 0; row < _rows; ++row)
+        {
+            Span& span = _damage[row];
+            if (span.begin >= span.end)
+            {
+                continue;
+            }
+            ++stats.rowsScanned;
+
+            Cell* front = _front.data() + static_cast<std::size_t>(row) * _cols;
+            const Cell* back = _back.data() + static_cast<std::size_t>(row) * _cols;
+            std::uint32_t col = span.begin;
+            while (col < span.end)
+            {
+                if (back[col] == front[col])
+                {
+                    ++col;
+                    continue;
+                }
+
+                // Extend the run while the next change is within kMergeGap cells.
+                const std::uint32_t start = col;
+                std::uint32_t last = col;
+                for (std::uint32_t next = col + 1; next < span.end && next - last <= kMergeGap; ++next)
+                {
+                    if (back[next] != front[next])
+                    {
+                        last = next;
+                    }
+                }
+
+                const std::uint32_t count = last - start + 1;
+                terminal.Write(row, start, std::span<const Cell>(back + start, count));
+                std::copy(back + start, back + start + count, front + start);
+                stats.cellsWritten += count;
+                ++stats.runs;
+                col = last + 1;
+            }
+            span = Span{};
+        }
+
+        terminal.Flush();
+        return stats;
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace TuiCurses
+{
+    /// <summary>
+    /// Colour/attribute classes a cell can be drawn with; terminals map them to their own
+    /// attributes (SGR sequences, curses colour pairs).
+    /// </summary>
+    enum class CellStyle : std::uint8_t
+    {
+        Normal,
+        Dim,
+        Header,
+        Closed,
+        Open,
+        Obstructed,
+        Stale,
+        Warning
+    };
+
+    constexpr std::size_t kCellStyleCount = 8;
+
+    /// One character cell. ASCII only, so the same glyphs work on ncurses and PDCurses.
+    struct Cell
+    {
+        char glyph = ' ';
+        CellStyle style = CellStyle::Normal;
+
+        friend bool operator==(const Cell&, const Cell&) = default;
+    };
+
+    /// <summary>
+    /// Output side of a ScreenBuffer: receives runs of cells to draw at a position.
+    /// </summary>
+    class ITerminal
+    {
+    public:
+        virtual ~ITerminal() = default;
+
+        /// Clears the whole screen to blanks.
+        virtual void Clear() = 0;
+
+        /// Draws `cells` left to right starting at (row, col); never wraps past the row.
+        virtual void Write(std::uint32_t row, std::uint32_t col, std::span<const Cell> cells) = 0;
+
+        /// Makes everything written since the last Flush visible.
+        virtual void Flush() = 0;
+    };
+
+    struct PresentStats
+    {
+        /// Cells sent to the terminal, including unchanged cells bridged inside a run.
+        std::size_t cellsWritten = 0;
+        std::size_t runs = 0;
+        /// Rows the damage tracking had to look at.
+        std::size_t rowsScanned = 0;
+    };
+
+    /// <summary>
+    /// Double-buffered cell grid with per-row damage tracking.
+    /// </summary>
+    /// <remarks>
+    /// Drawing goes to the back buffer. Every Put compares the new cell with the front buffer
+    /// (what the terminal shows) and widens that row's damaged column span when they differ,
+    /// so Present only visits damaged rows and only emits the cells that actually changed.
+    /// Changed cells separated by a short unchanged gap are sent as one run, because
+    /// repositioning the cursor costs more than re-sending a few cells. Redrawing the whole
+    /// frame every refresh is therefore cheap: identical content produces no output.
+    /// </remarks>
+    class ScreenBuffer
+    {
+    public:
+        /// Unchanged cells bridged between two changed runs instead of moving the cursor.
+        static constexpr std::uint32_t kMergeGap = 6;
+
+        ScreenBuffer(std::uint32_t rows = 0, std::uint32_t cols = 0);
+
+        /// Resizes both buffers and forces a full repaint (blank screen, Clear on Present).
+        void Resize(std::uint32_t rows, std::uint32_t cols);
+
+        std::uint32_t Rows() const { return _rows; }
+        std::uint32_t Cols() const { return _cols; }
+
+        /// Fills the back buffer with blanks.
+        void Erase();
+
+        /// Clears the terminal on the next Present and repaints every non-blank cell, e.g. after
+        /// something else wrote to the screen.
+        void Invalidate();
+
+        void Put(std::uint32_t row, std::uint32_t col, Cell cell)
+        {
+            if (row >= _rows || col >= _cols)
+            {
+                return;
+            }
+
+            const std::size_t index = static_cast<std::size_t>(row) * _cols + col;
+            _back[index] = cell;
+            if (cell != _front[index])
+            {
+                Damage(row, col);
+            }
+        }
+
+        /// Writes `text` from (row, col), clipped at the right edge and at `width` cells; pads
+        /// with blanks up to `width` when it is larger than the text. Returns cells written.
+        std::uint32_t PutText(std::uint32_t row, std::uint32_t col, std::string_view text, CellStyle style, std::uint32_t width = UINT32_MAX);
+
+        /// Fills `count` cells from (row, col) with `cell`.
+        void Fill(std::uint32_t row, std::uint32_t col, std::uint32_t count, Cell cell);
+
+        const Cell& Back(std::uint32_t row, std::uint32_t col) const
+        {
+            return _back[static_cast<std::size_t>(row) * _cols + col];
+        }
+
+        const Cell& Front(std::uint32_t row, std::uint32_t col) const
+        {
+            return _front[static_cast<std::size_t>(row) * _cols + col];
+        }
+
+        /// Sends the damaged cells to `terminal`, flushes it and makes the back buffer the new
+        /// front. The back buffer keeps its content, so the next frame may redraw or not.
+        PresentStats Present(ITerminal& terminal);
+
+    private:
+        void Damage(std::uint32_t row, std::uint32_t col)
+        {
+            Span& span = _damage[row];
+            if (col < span.begin)
+            {
+                span.begin = col;
+            }
+            if (col >= span.end)
+            {
+                span.end = col + 1;
+            }
+        }
+
+        /// Damaged columns [begin, end) of one row; empty when begin >= end.
+        struct Span
+        {
+            std::uint32_t begin = UINT32_MAX;
+            std::uint32_t end = 0;
+        };
+
+        std::uint32_t _rows = 0;
+        std::uint32_t _cols = 0;
+        std::vector<Cell> _front;
+        std::vector<Cell> _back;
+        std::vector<Span> _damage;
+        bool _clearPending = true;
+    };
+}
@@ -1 +1,7 @@
 #pragma once
+
+// Public entry point for the Tui.Curses static library.
+#include "AnsiTerminal.h"
+#include "CursesTerminal.h"
+#include "Dashboard.h"
+#include "ScreenBuffer.h"